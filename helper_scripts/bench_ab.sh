@@ -0,0 +1,40 @@
+#!/bin/sh
+
+# A/B the cpu benchmark in src/bench.c between a git revision and the working tree.
+# Both builds use the bench.c from the working tree, only the core they link against changes.
+#
+# usage: helper_scripts/bench_ab.sh <base revision> [instructions]
+# e.g.   helper_scripts/bench_ab.sh HEAD~1
+
+set -e
+
+if [ -z "$1" ]; then
+    echo "usage: $0 <base revision> [instructions]"
+    exit 1
+fi
+
+BASE=$1
+INSTRUCTIONS=${2:-50000000}
+ROOT=$(git rev-parse --show-toplevel)
+TMP=$(mktemp -d)
+trap 'rm -rf "$TMP"' EXIT
+
+mkdir "$TMP/base"
+git -C "$ROOT" archive "$BASE" src | tar -x -C "$TMP/base"
+cp -R "$ROOT/src" "$TMP/working"
+
+# builds the working tree bench.c against the core files in a src directory, leaving out the
+# frontend. bench.c is copied in so its includes pick up the headers next to it.
+build() {
+    files=$(ls "$1"/*.c | grep -v -e '/main\.c$' -e '/test\.c$' -e '/bench\.c$' -e '/video\.c$')
+    cp "$ROOT/src/bench.c" "$1/bench.c"
+    gcc -std=c99 -O2 -DBENCH_CPU_ONLY -I"$1" "$1/bench.c" $files -o "$2"
+}
+
+build "$TMP/base/src" "$TMP/bench_base"
+build "$TMP/working" "$TMP/bench_working"
+
+echo "base ($BASE)"
+"$TMP/bench_base" "$INSTRUCTIONS"
+echo "working tree"
+"$TMP/bench_working" "$INSTRUCTIONS"
@@ -3,11 +3,33 @@
 '''
 Script to pull opcodes from url below to a switch statement.
 made because its like over 200 of them...
+
+usage:
+    make_switch.py            print the switch statement skeleton
+    make_switch.py --tables   print src/opcodes.c (per opcode decode metadata)
 '''
 
 import lxml.html as lh
 import requests
 import re
+import sys
+
+URL = 'https://www.pastraiser.com/cpu/gameboy/gameboy_opcodes.html'
+
+''' the table on the site has a few typos, fix them up here '''
+FIXUPS = {
+    0xE2: {'length': 1},    # LD (C),A
+    0xF2: {'length': 1},    # LD A,(C)
+}
+
+''' the same for the CB table, BIT n,(HL) only reads so it's 12 rather than 16 '''
+CB_FIXUPS = {opcode: {'cycles': '12'} for opcode in range(0x46, 0x80, 8)}
+
+''' ops that end a basic block, anything that can move pc somewhere else or touches interrupts '''
+BLOCK_ENDS = ['JR', 'JP', 'CALL', 'RET', 'RETI', 'RST', 'HALT', 'STOP', 'DI', 'EI']
+
+''' unused opcodes lock up the real cpu, just treat them as a 4 cycle NOP '''
+ILLEGAL_CYCLES = 4
 
 def get_table_elements(url):
     ''' Return tr elements from page as list '''
@@ -16,43 +38,100 @@ def get_table_elements(url):
     if response.status_code == 200:
         doc = lh.fromstring(response.content)
         return doc.xpath('//tr')
-    
+
     return None
 
+def parse_cell(y):
+    ''' Return (inst, length, cycles, flags) for a table cell, None if the opcode is unused '''
+    text = str(y.text_content()).replace('\xa0', ' ')
+    if text.isspace():
+        return None
+
+    flags = text[-7:]
+    text = text[:-7]
+    length = int(text.split()[-2][-1])
+    cycles = text.split()[-1]
+    inst = ''.join(text.split()[:-2]) + ' ' + text.split()[-2][:-1]
+    return (inst.strip(), length, cycles, flags)
+
+def parse_rows(rows):
+    ''' Return list of 256 parsed cells for the 16 rows of an opcode table '''
+    ops = []
+    for x in rows:
+        for y in x[1:]:
+            ops.append(parse_cell(y))
+    return ops
+
+def print_switch(ops):
+    for count, op in enumerate(ops):
+        print('case {}:'.format(hex(count).upper().replace('X', 'x')))
+        if op:
+            inst, length, cycles, flags = op
+            print('\t// ' + inst)
+            print('\t// {} {}'.format(length, cycles))
+            print('\t// ' + flags)
+        print('\tbreak;')
+
+def split_cycles(op, opcode, fixups):
+    ''' Return (cycles, cycles_taken) for an opcode, "12/8" is taken/not taken '''
+    if not op:
+        return (ILLEGAL_CYCLES, ILLEGAL_CYCLES)
+
+    cycles = fixups.get(opcode, {}).get('cycles', op[2])
+    if '/' in cycles:
+        taken, not_taken = cycles.split('/')
+        return (int(not_taken), int(taken))
+    return (int(cycles), int(cycles))
+
+def flag_mask(op):
+    ''' Return the FLAG_* bits written by an opcode, flags look like "Z 0 H -" '''
+    if not op:
+        return '0'
+
+    names = ['FLAG_ZERO', 'FLAG_SUBTRACT', 'FLAG_HALF_CARRY', 'FLAG_CARRY']
+    flags = op[3].split()
+    written = [name for name, flag in zip(names, flags) if flag != '-']
+    return ' | '.join(written) if written else '0'
+
+def ends_block(op):
+    ''' Ops that jump or change the interrupt state end a basic block '''
+    if not op:
+        return 1
+
+    return int(op[0].split()[0] in BLOCK_ENDS)
+
+def print_info(name, ops, fixups):
+    print('const OpcodeInfo {}[256] = {{'.format(name))
+    for i, op in enumerate(ops):
+        cycles, cycles_taken = split_cycles(op, i, fixups)
+        inst = op[0] if op else 'ILLEGAL'
+        length = fixups.get(i, {}).get('length', op[1]) if op else 1
+        print('    /* 0x{:02X} */ {{ "{}", {}, {}, {}, {}, {} }},'.format(
+            i, inst, length, cycles, cycles_taken, flag_mask(op), ends_block(op)))
+    print('};')
+
+def print_tables(ops, cb_ops):
+    print('// opcodes.c')
+    print('// generated by helper_scripts/make_switch.py --tables, do not edit by hand')
+    print('')
+    print('#include "opcodes.h"')
+    print('')
+    print('/* mnemonic, length, cycles, cycles when a conditional op is taken, flags written, ends a block */')
+    print_info('opcode_info', ops, FIXUPS)
+    print('')
+    print('/* the CB prefixed opcodes, length and cycles include the prefix */')
+    print_info('cb_opcode_info', cb_ops, CB_FIXUPS)
+
 if __name__ == '__main__':
-        tr = get_table_elements('https://www.pastraiser.com/cpu/gameboy/gameboy_opcodes.html')
-
-        count = 0
-        ''' for normal opcode (8bit) '''  
-        for x in tr[1:17]:
-            for y in x[1:]:
-                text = str(y.text_content()).replace('\xa0', ' ')
-                print('case {}:'.format(hex(count).upper().replace('X', 'x')))
-                if not text.isspace():
-                    flags = text[-7:]
-                    text = text[:-7]
-                    size_and_cycles = text.split()[-2][-1] + ' ' + text.split()[-1]
-                    inst = ''.join(text.split()[:-2]) + ' ' + text.split()[-2][:-1]
-                    print('\t// ' + inst)
-                    print('\t// ' + size_and_cycles)
-                    print('\t// ' + flags)
-                print('\tbreak;')
-                count += 1
+        tr = get_table_elements(URL)
+
+        ''' for normal opcode (8bit) '''
+        ops = parse_rows(tr[1:17])
         ''' for prefix CB '''
-        count = 0
-        exit(0)
-        for x in tr[18:34]:
-            for y in x[1:]:
-                text = str(y.text_content()).replace('\xa0', ' ')
-                print('case {}:'.format(hex(count).upper().replace('X', 'x')))
-                if not text.isspace():
-                    flags = text[-7:]
-                    text = text[:-7]
-                    size_and_cycles = text.split()[-2][-1] + ' ' + text.split()[-1]
-                    inst = ''.join(text.split()[:-2]) + ' ' + text.split()[-2][:-1]
-
-                    print('\t// ' + inst)
-                    print('\t// ' + size_and_cycles)
-                    print('\t// ' + flags)
-                print('\tbreak;')
-                count += 1
\ No newline at end of file
+        cb_ops = parse_rows(tr[18:34])
+
+        if '--tables' in sys.argv:
+            print_tables(ops, cb_ops)
+            exit(0)
+
+        print_switch(ops)
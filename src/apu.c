@@ -0,0 +1,437 @@
+// apu.c
+#include <string.h>
+
+#include "apu.h"
+#include "proc.h"
+
+// bit 7 of NR52 turns the whole apu on and off
+#define APU_POWER 0x80
+
+// how many samples are put together before they go into the ring
+#define BATCH_SAMPLES 256
+
+// read back ORed with these, write only and unused bits read as 1
+static const uint8_t read_masks[APU_END - APU_START + 1] = {
+    0x80, 0x3F, 0x00, 0xFF, 0xBF,   // NR10 -> NR14
+    0xFF, 0x3F, 0x00, 0xFF, 0xBF,   // NR20 -> NR24
+    0x7F, 0xFF, 0x9F, 0xFF, 0xBF,   // NR30 -> NR34
+    0xFF, 0xFF, 0x00, 0x00, 0xBF,   // NR40 -> NR44
+    0x00, 0x00, 0x70,               // NR50 -> NR52
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    // wave ram
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0
+};
+
+// square waves for 12.5%, 25%, 50% and 75%, a bit for each of the 8 steps
+static const uint8_t duties[4] = { 0x01, 0x81, 0x87, 0x7E };
+
+static const uint8_t noise_divisors[8] = { 8, 16, 32, 48, 64, 80, 96, 112 };
+
+static inline uint8_t channel_register(Proc * p, int channel, int n) {
+    /* every channel has 5 registers, NRx0 -> NRx4 */
+    return p->memory[APU_START + channel * 5 + n];
+}
+
+static uint16_t channel_frequency(Proc * p, int channel) {
+    return channel_register(p, channel, 3) | ((channel_register(p, channel, 4) & 7) << 8);
+}
+
+static uint32_t channel_period(Proc * p, int channel) {
+    /* cycles for each step of the waveform */
+    switch (channel) {
+    case 0: case 1:
+        return (2048 - channel_frequency(p, channel)) * 4;
+    case 2:
+        return (2048 - channel_frequency(p, channel)) * 2;
+    default: {
+        uint8_t nr43 = p->memory[IO_NR43];
+        return (uint32_t) noise_divisors[nr43 & 7] << (nr43 >> 4);
+    }
+    }
+}
+
+static int dac_on(Proc * p, int channel) {
+    if (channel == 2) return (p->memory[IO_NR30] & 0x80) != 0;
+    return (channel_register(p, channel, 2) & 0xF8) != 0;
+}
+
+/* ---------------------------------------------------------------------------------------
+ * synthesis
+ * --------------------------------------------------------------------------------------- */
+
+static void channel_step(Proc * p, int channel) {
+    /* the waveform moves on by one, a duty step / wave sample / shift of the lfsr */
+    ApuChannel * c = &p->apu.channels[channel];
+
+    switch (channel) {
+    case 0: case 1:
+        c->position = (c->position + 1) & 7;
+        break;
+    case 2:
+        c->position = (c->position + 1) & 31;
+        break;
+    default: {
+        // the 7 bit mode feeds back into bit 6 as well
+        uint16_t bit = (c->lfsr ^ (c->lfsr >> 1)) & 1;
+        c->lfsr = (c->lfsr >> 1) | (bit << 14);
+        if (p->memory[IO_NR43] & 0x08) c->lfsr = (c->lfsr & ~0x40) | (bit << 6);
+        break;
+    }
+    }
+}
+
+static int channel_output(Proc * p, int channel) {
+    /* -15 -> 15, what comes out of the dac. A channel that's off still has its dac at the
+     * bottom until the dac is off too, the output filter takes the offset away
+     */
+    ApuChannel * c = &p->apu.channels[channel];
+    if (!dac_on(p, channel)) return 0;
+    if (!c->enabled) return -15;
+
+    int level;
+    switch (channel) {
+    case 0: case 1:
+        level = (duties[channel_register(p, channel, 1) >> 6] >> c->position) & 1 ? c->volume : 0;
+        break;
+    case 2: {
+        uint8_t byte = p->memory[WAVE_START + c->position / 2];
+        uint8_t sample = c->position & 1 ? byte & 0x0F : byte >> 4;
+        // mute, 100%, 50%, 25%
+        uint8_t shift = (p->memory[IO_NR32] >> 5) & 3;
+        level = shift ? sample >> (shift - 1) : 0;
+        break;
+    }
+    default:
+        level = c->lfsr & 1 ? 0 : c->volume;
+        break;
+    }
+
+    return level * 2 - 15;
+}
+
+static void channel_update(Proc * p, int channel, uint32_t clock) {
+    /* where the channel is on each side after panning and the master volume, any change
+     * is a step in the output at clock
+     */
+    Apu * a = &p->apu;
+    ApuChannel * c = &a->channels[channel];
+    uint8_t panning = p->memory[IO_NR51];
+    uint8_t master = p->memory[IO_NR50];
+    int out = channel_output(p, channel);
+
+    int amplitudes[2] = {
+        panning & (0x10 << channel) ? out * (((master >> 4) & 7) + 1) : 0,
+        panning & (0x01 << channel) ? out * ((master & 7) + 1) : 0
+    };
+
+    for (int side = 0; side < 2; side++) {
+        if (amplitudes[side] != c->amplitude[side]) {
+            blip_add_delta(&a->blips[side], clock, amplitudes[side] - c->amplitude[side]);
+            c->amplitude[side] = amplitudes[side];
+        }
+    }
+}
+
+static void update_all(Proc * p) {
+    /* after a register write or the frame sequencer, anything could have changed */
+    if (!p->apu.ring) return;
+    for (int channel = 0; channel < NUM_CHANNELS; channel++) {
+        channel_update(p, channel, 0);
+    }
+}
+
+static void channel_run(Proc * p, int channel, uint32_t clocks) {
+    /* every step of the waveform over the next clocks. The period can't change in here, the
+     * registers only change between runs
+     */
+    ApuChannel * c = &p->apu.channels[channel];
+    if (!c->enabled) return;
+
+    uint32_t period = channel_period(p, channel);
+    uint32_t clock = c->timer;
+    for (; clock <= clocks; clock += period) {
+        channel_step(p, channel);
+        channel_update(p, channel, clock);
+    }
+    c->timer = clock - clocks;
+}
+
+static inline int16_t clamp_sample(float value) {
+    return value > INT16_MAX ? INT16_MAX : value < INT16_MIN ? INT16_MIN : (int16_t) value;
+}
+
+static void flush(Proc * p) {
+    /* everything the blips have finished goes through the output filter into the ring */
+    Apu * a = &p->apu;
+    float sides[2][BATCH_SAMPLES];
+    StereoSample batch[BATCH_SAMPLES];
+    uint32_t count;
+
+    while ((count = blip_read(&a->blips[0], sides[0], BATCH_SAMPLES)) > 0) {
+        blip_read(&a->blips[1], sides[1], count);
+
+        for (uint32_t i = 0; i < count; i++) {
+            float out[2];
+            // the capacitor on the real output, takes away the offset of the dacs
+            for (int side = 0; side < 2; side++) {
+                float in = sides[side][i];
+                out[side] = in - a->capacitor[side];
+                a->capacitor[side] = in - out[side] * a->charge;
+            }
+            // 4 channels at 15 * 8 volume * 64 only just fits, the filter can overshoot a little
+            batch[i].left = clamp_sample(out[0] * 64);
+            batch[i].right = clamp_sample(out[1] * 64);
+        }
+
+        audio_ring_write(a->ring, batch, count);
+        a->samples += count;
+    }
+}
+
+static void synthesize(Proc * p, uint64_t until) {
+    /* each channel's steps from synced up to until go into the blips as one frame, split up
+     * if it's more than they hold
+     */
+    Apu * a = &p->apu;
+    if (!a->ring) {
+        a->synced = until > a->synced ? until : a->synced;
+        return;
+    }
+
+    while (a->synced < until) {
+        uint64_t clocks = until - a->synced;
+        uint32_t max = blip_max_clocks(&a->blips[0]);
+        if (clocks > max) clocks = max;
+
+        for (int channel = 0; channel < NUM_CHANNELS; channel++) {
+            channel_run(p, channel, clocks);
+        }
+        blip_end_frame(&a->blips[0], clocks);
+        blip_end_frame(&a->blips[1], clocks);
+        a->synced += clocks;
+
+        flush(p);
+    }
+}
+
+void apu_sync(Proc * p) {
+    synthesize(p, p->cycles);
+}
+
+/* ---------------------------------------------------------------------------------------
+ * frame sequencer
+ * --------------------------------------------------------------------------------------- */
+
+static uint16_t sweep_calculate(Proc * p) {
+    /* the next frequency, going over 2047 turns channel 1 off */
+    ApuChannel * c = &p->apu.channels[0];
+    uint8_t nr10 = p->memory[IO_NR10];
+    uint16_t change = c->sweep_shadow >> (nr10 & 7);
+    uint16_t frequency = nr10 & 0x08 ? c->sweep_shadow - change : c->sweep_shadow + change;
+
+    if (frequency > 2047) c->enabled = 0;
+    return frequency;
+}
+
+static void sweep_step(Proc * p) {
+    ApuChannel * c = &p->apu.channels[0];
+    if (!c->sweep_timer || --c->sweep_timer) return;
+
+    uint8_t nr10 = p->memory[IO_NR10];
+    uint8_t period = (nr10 >> 4) & 7;
+    c->sweep_timer = period ? period : 8;
+    if (!c->sweep_enabled || !period) return;
+
+    uint16_t frequency = sweep_calculate(p);
+    if (frequency <= 2047 && (nr10 & 7)) {
+        c->sweep_shadow = frequency;
+        p->memory[IO_NR13] = frequency & 0xFF;
+        p->memory[IO_NR14] = (p->memory[IO_NR14] & ~7) | (frequency >> 8);
+        // checked again straight away with the new one
+        sweep_calculate(p);
+    }
+}
+
+static void envelope_step(Proc * p, int channel) {
+    ApuChannel * c = &p->apu.channels[channel];
+    uint8_t nrx2 = channel_register(p, channel, 2);
+    uint8_t period = nrx2 & 7;
+
+    if (!period || !c->envelope_timer || --c->envelope_timer) return;
+
+    c->envelope_timer = period;
+    if ((nrx2 & 0x08) && c->volume < 15) c->volume++;
+    else if (!(nrx2 & 0x08) && c->volume > 0) c->volume--;
+}
+
+static void sequencer_step(Proc * p) {
+    /* 8 steps, length on the even ones, sweep on 2 and 6 and the envelopes on 7 */
+    Apu * a = &p->apu;
+    if (!(p->memory[IO_NR52] & APU_POWER)) return;
+
+    uint8_t step = a->sequencer_step;
+    a->sequencer_step = (step + 1) & 7;
+
+    if (!(step & 1)) {
+        for (int channel = 0; channel < NUM_CHANNELS; channel++) {
+            ApuChannel * c = &a->channels[channel];
+            if ((channel_register(p, channel, 4) & 0x40) && c->length && !--c->length) {
+                c->enabled = 0;
+            }
+        }
+    }
+    if (step == 2 || step == 6) sweep_step(p);
+    if (step == 7) {
+        envelope_step(p, 0);
+        envelope_step(p, 1);
+        envelope_step(p, 3);
+    }
+}
+
+void apu_step(Proc * p, uint64_t time) {
+    synthesize(p, time);
+    sequencer_step(p);
+    update_all(p);
+}
+
+/* ---------------------------------------------------------------------------------------
+ * registers
+ * --------------------------------------------------------------------------------------- */
+
+static void trigger(Proc * p, int channel) {
+    ApuChannel * c = &p->apu.channels[channel];
+
+    c->enabled = dac_on(p, channel);
+    if (!c->length) c->length = channel == 2 ? 256 : 64;
+    c->timer = channel_period(p, channel);
+
+    if (channel == 2) {
+        c->position = 0;
+        return;
+    }
+
+    uint8_t nrx2 = channel_register(p, channel, 2);
+    c->volume = nrx2 >> 4;
+    c->envelope_timer = nrx2 & 7;
+
+    if (channel == 3) {
+        c->lfsr = 0x7FFF;
+    } else if (channel == 0) {
+        uint8_t nr10 = p->memory[IO_NR10];
+        uint8_t period = (nr10 >> 4) & 7;
+        c->sweep_shadow = channel_frequency(p, 0);
+        c->sweep_timer = period ? period : 8;
+        c->sweep_enabled = period || (nr10 & 7);
+        if (nr10 & 7) sweep_calculate(p);
+    }
+}
+
+static void power_off(Proc * p) {
+    /* every register but the wave ram is cleared and can't be written until it's back on */
+    memset(&p->memory[APU_START], 0, IO_NR52 - APU_START);
+    for (int channel = 0; channel < NUM_CHANNELS; channel++) {
+        // the output only goes back to 0 through update_all
+        ApuChannel * c = &p->apu.channels[channel];
+        int amplitude[2] = { c->amplitude[0], c->amplitude[1] };
+        memset(c, 0, sizeof(ApuChannel));
+        c->amplitude[0] = amplitude[0];
+        c->amplitude[1] = amplitude[1];
+    }
+}
+
+uint8_t apu_read(Proc * p, uint16_t address) {
+    if (address == IO_NR52) {
+        uint8_t status = p->memory[IO_NR52] & APU_POWER;
+        for (int channel = 0; channel < NUM_CHANNELS; channel++) {
+            if (p->apu.channels[channel].enabled) status |= 1 << channel;
+        }
+        return status | read_masks[address - APU_START];
+    }
+    return p->memory[address] | read_masks[address - APU_START];
+}
+
+static void write_register(Proc * p, uint16_t address, uint8_t value) {
+    int powered = p->memory[IO_NR52] & APU_POWER;
+
+    if (address == IO_NR52) {
+        if (powered && !(value & APU_POWER)) power_off(p);
+        if (!powered && (value & APU_POWER)) p->apu.sequencer_step = 0;
+        p->memory[IO_NR52] = value & APU_POWER;
+        return;
+    }
+
+    if (address >= WAVE_START) {
+        p->memory[address] = value;
+        return;
+    }
+    if (!powered) return;
+
+    p->memory[address] = value;
+
+    int channel = (address - APU_START) / 5;
+    if (channel >= NUM_CHANNELS) return;
+    ApuChannel * c = &p->apu.channels[channel];
+
+    switch ((address - APU_START) % 5) {
+    case 0:
+        if (channel == 2 && !(value & 0x80)) c->enabled = 0;
+        break;
+    case 1:
+        // the length counts down from what's written, wave has 8 bits of it
+        c->length = channel == 2 ? 256 - value : 64 - (value & 0x3F);
+        break;
+    case 2:
+        if (channel != 2 && !dac_on(p, channel)) c->enabled = 0;
+        break;
+    case 4:
+        if (value & 0x80) trigger(p, channel);
+        break;
+    }
+}
+
+void apu_write(Proc * p, uint16_t address, uint8_t value) {
+    // everything up to now is made with the registers as they were
+    apu_sync(p);
+    write_register(p, address, value);
+    update_all(p);
+}
+
+void apu_set_output(Proc * p, AudioRing * ring, uint32_t rate) {
+    apu_sync(p);
+    p->apu.ring = rate ? ring : NULL;
+    p->apu.rate = rate;
+    for (int side = 0; side < 2; side++) {
+        blip_init(&p->apu.blips[side], CLOCK_SPEED, rate ? rate : 1);
+        p->apu.capacitor[side] = 0;
+    }
+    for (int channel = 0; channel < NUM_CHANNELS; channel++) {
+        p->apu.channels[channel].amplitude[0] = 0;
+        p->apu.channels[channel].amplitude[1] = 0;
+    }
+
+    // the capacitor keeps 0.999958 of its charge every cycle
+    float charge = 1;
+    for (uint32_t i = 0; rate && i < CLOCK_SPEED / rate; i++) {
+        charge *= 0.999958f;
+    }
+    p->apu.charge = charge;
+
+    update_all(p);
+}
+
+void apu_adjust_rate(Proc * p, double ratio) {
+    /* only the blips change, the capacitor is close enough at a fraction of a percent off */
+    if (!p->apu.ring) return;
+
+    apu_sync(p);
+    for (int side = 0; side < 2; side++) {
+        blip_set_rates(&p->apu.blips[side], CLOCK_SPEED, p->apu.rate * ratio);
+    }
+}
+
+void apu_init(Proc * p) {
+    /* the registers are already in memory (proc_initialize_memory), the channels start off */
+    memset(&p->apu, 0, sizeof(Apu));
+    p->apu.synced = p->cycles;
+    p->memory[IO_NR52] &= APU_POWER;
+}
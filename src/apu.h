@@ -0,0 +1,109 @@
+#ifndef APU_H
+#define APU_H
+
+#include <stdint.h>
+
+#include "ring.h"
+#include "blip.h"
+
+/*
+ * https://gbdev.io/pandocs/Audio.html
+ *
+ * The four channels are never stepped with the cpu. apu_sync brings them up to a cycle
+ * count in one go and it only runs when a sound register is touched or the frame sequencer
+ * steps (EVENT_APU, 512 times a second). Each channel goes straight from one step of its
+ * waveform to the next, the output only changes there so each change is a band-limited
+ * step into the blips (blip.h) which make the samples at the host rate. Everything in between
+ * is a run of samples written to the ring in one batch, and without a ring there's nothing to
+ * make so only the registers and the frame sequencer are kept up.
+ */
+
+#define APU_START 0xFF10
+#define APU_END   0xFF3F
+#define IO_NR10 0xFF10
+#define IO_NR11 0xFF11
+#define IO_NR12 0xFF12
+#define IO_NR13 0xFF13
+#define IO_NR14 0xFF14
+#define IO_NR21 0xFF16
+#define IO_NR22 0xFF17
+#define IO_NR23 0xFF18
+#define IO_NR24 0xFF19
+#define IO_NR30 0xFF1A
+#define IO_NR31 0xFF1B
+#define IO_NR32 0xFF1C
+#define IO_NR33 0xFF1D
+#define IO_NR34 0xFF1E
+#define IO_NR41 0xFF20
+#define IO_NR42 0xFF21
+#define IO_NR43 0xFF22
+#define IO_NR44 0xFF23
+#define IO_NR50 0xFF24
+#define IO_NR51 0xFF25
+#define IO_NR52 0xFF26
+#define WAVE_START 0xFF30
+
+// the frame sequencer runs at 512 Hz
+#define APU_STEP_CYCLES 8192
+
+#define NUM_CHANNELS 4
+
+typedef struct {
+    uint8_t enabled;
+    // cycles until the waveform moves on, and where it is (duty step / wave sample)
+    uint32_t timer;
+    uint8_t position;
+
+    // counts down to 0 and turns the channel off if length is enabled
+    uint16_t length;
+
+    uint8_t volume;
+    uint8_t envelope_timer;
+
+    // channel 1 only
+    uint16_t sweep_shadow;
+    uint8_t sweep_timer;
+    uint8_t sweep_enabled;
+
+    // channel 4 only
+    uint16_t lfsr;
+
+    // what it's adding to the left and right output right now
+    int amplitude[2];
+} ApuChannel;
+
+typedef struct {
+    ApuChannel channels[NUM_CHANNELS];
+    uint8_t sequencer_step;
+
+    // cycle the channels have been brought up to
+    uint64_t synced;
+
+    // where the output goes, the left and right steps are resampled to the ring's rate by the blips
+    AudioRing * ring;
+    uint32_t rate;
+    Blip blips[2];
+    // high pass on the output, what's charged up on each side and how much stays each sample
+    float capacitor[2];
+    float charge;
+
+    // samples made
+    uint64_t samples;
+} Apu;
+
+struct Proc;
+
+void    apu_init(struct Proc * p);
+// samples from now on go to ring at rate, NULL turns them off
+void    apu_set_output(struct Proc * p, AudioRing * ring, uint32_t rate);
+// makes samples ratio times faster than the rate, staying close to it keeps the ring from running dry or over (timing.h)
+void    apu_adjust_rate(struct Proc * p, double ratio);
+// makes the samples up to the current cycle
+void    apu_sync(struct Proc * p);
+// the frame sequencer, length, sweep and envelope
+void    apu_step(struct Proc * p, uint64_t time);
+
+uint8_t apu_read(struct Proc * p, uint16_t address);
+void    apu_write(struct Proc * p, uint16_t address, uint8_t value);
+
+#endif
@@ -0,0 +1,40 @@
+// audio.c
+#include <stdio.h>
+#include <string.h>
+
+#include "audio.h"
+
+static void audio_callback(void * data, Uint8 * stream, int bytes) {
+    /* runs on sdl's audio thread, whatever the apu hasn't made yet is silence */
+    AudioRing * ring = (AudioRing *) data;
+    uint32_t wanted = bytes / sizeof(StereoSample);
+    uint32_t got = audio_ring_read(ring, (StereoSample *) stream, wanted);
+
+    memset(stream + got * sizeof(StereoSample), 0, (wanted - got) * sizeof(StereoSample));
+}
+
+SDL_AudioDeviceID audio_open(AudioRing * ring, int rate) {
+    SDL_AudioSpec want, have;
+    memset(&want, 0, sizeof(want));
+    want.freq = rate;
+    want.format = AUDIO_S16SYS;
+    want.channels = 2;
+    want.samples = AUDIO_BUFFER_SAMPLES;
+    want.callback = audio_callback;
+    want.userdata = ring;
+
+    // sdl converts if the device wants something else
+    SDL_AudioDeviceID device = SDL_OpenAudioDevice(NULL, 0, &want, &have, 0);
+    if (!device) {
+        fprintf(stderr, "sdl could not open audio: %s\n", SDL_GetError());
+        return 0;
+    }
+
+    SDL_PauseAudioDevice(device, 0);
+    return device;
+}
+
+void audio_close(SDL_AudioDeviceID device) {
+    // sdl waits for a callback that's running to finish
+    if (device) SDL_CloseAudioDevice(device);
+}
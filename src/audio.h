@@ -0,0 +1,16 @@
+#ifndef AUDIO_H
+#define AUDIO_H
+
+#include "SDL2/SDL.h"
+
+#include "ring.h"
+
+// samples the sdl callback asks for at a time
+#define AUDIO_BUFFER_SAMPLES 1024
+
+/* plays samples from ring through sdl, the callback is the ring's consumer. 0 if there's no audio device */
+SDL_AudioDeviceID audio_open(AudioRing * ring, int rate);
+// once this returns the callback isn't running and won't touch the ring again
+void              audio_close(SDL_AudioDeviceID device);
+
+#endif
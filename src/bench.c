@@ -0,0 +1,693 @@
+// bench.c
+// Throughput benchmarks for the core, build with make bench
+// usage: ./bench [instructions]
+
+// needed for syscall() with -std=c99
+#define _DEFAULT_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stddef.h>
+#include <string.h>
+#include <math.h>
+#include <unistd.h>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#endif
+
+#include "proc.h"
+#include "memory.h"
+#include "cart.h"
+#include "tile.h"
+#include "palette.h"
+#include "blip.h"
+#include "state.h"
+#include "rewind.h"
+#include "timing.h"
+
+#define DEFAULT_INSTRUCTIONS 50000000
+
+#define PROGRAM_START 0xC000
+
+/*
+ * Tight loop in work ram. Only uses ops that already behaved the same in the old switch
+ * dispatch so helper_scripts/bench_ab.sh can compare the same work across revisions
+ * (the old switch didn't skip the operands of a conditional jump that wasn't taken, so
+ * the loop only uses an unconditional one).
+ */
+static const uint8_t cpu_program[] = {
+    0x06, 0x10,             // C000  LD B,10
+    0x21, 0x00, 0xC1,       // C002  LD HL,C100
+    0x2A,                   // C005  LD A,(HL+)
+    0x80,                   // C006  ADD A,B
+    0x4F,                   // C007  LD C,A
+    0x14,                   // C008  INC D
+    0x78,                   // C009  LD A,B
+    0x90,                   // C00A  SUB B
+    0x05,                   // C00B  DEC B
+    0x2A,                   // C00C  LD A,(HL+)
+    0xB8,                   // C00D  CP B
+    0x3C,                   // C00E  INC A
+    0x47,                   // C00F  LD B,A
+    0xC3, 0x00, 0xC0,       // C010  JP C000
+};
+
+static Proc* load_cpu_program() {
+    Proc* p = proc_create();
+
+    for (int i = 0; i < sizeof(cpu_program); i++) {
+        write_byte(p, PROGRAM_START + i, cpu_program[i]);
+    }
+    p->pc = PROGRAM_START;
+
+    return p;
+}
+
+/*
+ * Host instructions and L1 data cache misses from the perf counters, only on linux and
+ * they can still be turned off (perf_event_paranoid, containers), -1 when they are
+ */
+static int open_counter(uint32_t type, uint64_t config) {
+#ifdef __linux__
+    struct perf_event_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.type = type;
+    attr.size = sizeof(attr);
+    attr.config = config;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    return syscall(__NR_perf_event_open, &attr, 0, -1, -1, 0);
+#else
+    return -1;
+#endif
+}
+
+static uint64_t read_counter(int fd) {
+    uint64_t value = 0;
+#ifdef __linux__
+    if (fd >= 0 && read(fd, &value, sizeof(value)) != sizeof(value)) value = 0;
+#endif
+    return value;
+}
+
+static void print_layout() {
+    /* where the state every instruction touches sits in Proc */
+    size_t start = offsetof(Proc, registers);
+    size_t end = offsetof(Proc, cycles) + sizeof(uint64_t);
+    if (offsetof(Proc, pc) < start) start = offsetof(Proc, pc);
+    if (offsetof(Proc, sp) < start) start = offsetof(Proc, sp);
+
+    printf("cpu state: bytes %zu -> %zu of Proc, %zu cache lines\n",
+            start, end, (end - 1) / 64 - start / 64 + 1);
+}
+
+static void bench_cpu(long instructions) {
+    Proc* p = load_cpu_program();
+
+#ifdef __linux__
+    int host_instructions = open_counter(PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS);
+    int l1d_misses = open_counter(PERF_TYPE_HW_CACHE, PERF_COUNT_HW_CACHE_L1D
+            | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16));
+#else
+    int host_instructions = open_counter(0, 0);
+    int l1d_misses = open_counter(0, 0);
+#endif
+    uint64_t instructions_before = read_counter(host_instructions);
+    uint64_t misses_before = read_counter(l1d_misses);
+
+    uint64_t start = timing_now_ns();
+    for (long i = 0; i < instructions; i++) {
+        proc_read_word(p);
+    }
+    double seconds = (timing_now_ns() - start) / 1e9;
+
+    uint64_t instructions_after = read_counter(host_instructions);
+    uint64_t misses_after = read_counter(l1d_misses);
+
+    printf("cpu:  %ld instructions in %.3f s, %.2f M instructions/s, %.2f emulated MHz\n",
+            instructions, seconds, instructions / seconds / 1e6, p->cycles / seconds / 1e6);
+    printf("      %.2f ns", seconds * 1e9 / instructions);
+    if (host_instructions >= 0) {
+        printf(", %.1f host instructions", (double) (instructions_after - instructions_before) / instructions);
+    }
+    if (l1d_misses >= 0) {
+        printf(", %.4f L1D misses", (double) (misses_after - misses_before) / instructions);
+    }
+    printf(" per instruction%s\n", host_instructions < 0 ? " (perf counters not available)" : "");
+
+#ifdef __linux__
+    if (host_instructions >= 0) close(host_instructions);
+    if (l1d_misses >= 0) close(l1d_misses);
+#endif
+
+    proc_delete(p);
+}
+
+#ifndef BENCH_CPU_ONLY
+
+static void bench_block_cache(long instructions, int enabled, int jit) {
+    /* same program run a frame at a time through proc_run_cycles, with and without the block
+     * cache and the jit on top of it
+     */
+    Proc* p = load_cpu_program();
+    proc_enable_block_cache(p, enabled);
+    if (jit && !proc_enable_jit(p, 1)) {
+        printf("run_cycles, jit: not available on this host\n");
+        proc_delete(p);
+        return;
+    }
+
+    // the program averages ~6 cycles an instruction
+    uint64_t cycles = (uint64_t) instructions * 6;
+
+    uint64_t start = timing_now_ns();
+    while (p->cycles < cycles) {
+        proc_run_cycles(p, CYCLES_PER_FRAME);
+    }
+    double seconds = (timing_now_ns() - start) / 1e9;
+
+    printf("run_cycles, %s: %.2f emulated MHz",
+            jit ? "jit           " : enabled ? "block cache on " : "block cache off", p->cycles / seconds / 1e6);
+    if (jit) {
+        printf(", %llu blocks compiled, %llu native runs",
+                (unsigned long long) p->jit->compiled, (unsigned long long) p->jit->native_runs);
+    } else if (enabled) {
+        printf(", %llu block hits, %llu misses",
+                (unsigned long long) p->block_cache->hits, (unsigned long long) p->block_cache->misses);
+    }
+    printf("\n");
+
+    proc_delete(p);
+}
+
+static void bench_halt(long instructions) {
+    /* waits for vblank in HALT the way most games spend their frames, the cycles halted
+     * are skipped rather than stepped through
+     */
+    static const uint8_t halt_program[] = {
+        0xFB,               // C000  EI
+        0x76,               // C001  HALT
+        0x18, 0xFC,         // C002  JR C000
+    };
+
+    Proc* p = proc_create();
+    for (int i = 0; i < sizeof(halt_program); i++) {
+        write_byte(p, PROGRAM_START + i, halt_program[i]);
+    }
+    p->memory[0x40] = 0xD9;     // RETI
+    write_byte(p, IO_IE, INT_VBLANK);
+    p->pc = PROGRAM_START;
+
+    uint64_t cycles = (uint64_t) instructions * 6;
+
+    uint64_t start = timing_now_ns();
+    while (p->cycles < cycles) {
+        proc_run_cycles(p, CYCLES_PER_FRAME);
+    }
+    double seconds = (timing_now_ns() - start) / 1e9;
+
+    printf("run_cycles, halted         : %.2f emulated MHz, %llu halts, %.1f%% of cycles skipped\n",
+            p->cycles / seconds / 1e6, (unsigned long long) p->stats.halts,
+            100.0 * p->stats.halted_cycles / p->cycles);
+
+    proc_delete(p);
+}
+
+static void bench_idle(long instructions, int skip) {
+    /* waits for vblank by polling LY, with and without skipping the loop */
+    static const uint8_t poll_program[] = {
+        0xF0, 0x44,         // C000  LDH A,(44)
+        0xFE, 0x90,         // C002  CP 90
+        0x20, 0xFA,         // C004  JR NZ,C000
+        0xF0, 0x44,         // C006  LDH A,(44)
+        0xFE, 0x90,         // C008  CP 90
+        0x28, 0xFA,         // C00A  JR Z,C006
+        0x18, 0xF2,         // C00C  JR C000
+    };
+
+    Proc* p = proc_create();
+    for (int i = 0; i < sizeof(poll_program); i++) {
+        write_byte(p, PROGRAM_START + i, poll_program[i]);
+    }
+    p->pc = PROGRAM_START;
+    p->skip_idle_loops = skip;
+
+    uint64_t cycles = (uint64_t) instructions * 6;
+
+    uint64_t start = timing_now_ns();
+    while (p->cycles < cycles) {
+        proc_run_cycles(p, CYCLES_PER_FRAME);
+    }
+    double seconds = (timing_now_ns() - start) / 1e9;
+
+    printf("run_cycles, polling LY %s: %.2f emulated MHz, %llu skips, %.1f%% of cycles skipped\n",
+            skip ? "skip" : "    ", p->cycles / seconds / 1e6, (unsigned long long) p->stats.idle_skips,
+            100.0 * p->stats.idle_cycles / p->cycles);
+
+    proc_delete(p);
+}
+
+static void bench_bank_switch(long instructions) {
+    /* the MBC5 bank register written straight through cart_write against what it would
+     * cost to copy the bank into memory instead, then a loop that switches the bank and
+     * reads from it every time round for what it costs with the emulation around it
+     */
+    static const uint8_t switch_program[] = {
+        0x21, 0x00, 0x40,       // C000  LD HL,4000
+        0x0C,                   // C003  INC C
+        0x79,                   // C004  LD A,C
+        0xEA, 0x00, 0x20,       // C005  LD (2000),A
+        0x7E,                   // C008  LD A,(HL)
+        0x18, 0xF8,             // C009  JR C003
+    };
+    const int banks = 256;
+
+    uint8_t* rom = calloc(banks, ROM_BANK_SIZE);
+    rom[HEADER_TYPE] = 0x19;    // MBC5
+    Cart* c = cart_create_from_buffer(rom, (size_t) banks * ROM_BANK_SIZE);
+
+    Proc* p = proc_create();
+    cart_load(c, p);
+    for (int i = 0; i < sizeof(switch_program); i++) {
+        write_byte(p, PROGRAM_START + i, switch_program[i]);
+    }
+    p->pc = PROGRAM_START;
+
+    uint64_t cycles = (uint64_t) instructions * 6;
+
+    uint64_t start = timing_now_ns();
+    while (p->cycles < cycles) {
+        proc_run_cycles(p, CYCLES_PER_FRAME);
+    }
+    double seconds = (timing_now_ns() - start) / 1e9;
+    uint64_t switches = c->bank_switches;
+
+    // just the switch, the register write and the pages pointed at the new bank
+    start = timing_now_ns();
+    for (uint64_t i = 0; i < switches; i++) {
+        cart_write(c, p, 0x2000, i);
+    }
+    double write_seconds = (timing_now_ns() - start) / 1e9;
+
+    // the same number of switches done by copying each bank into a 16 KiB window
+    uint8_t* window = malloc(ROM_BANK_SIZE);
+    volatile uint8_t sink = 0;
+    long copies = switches < 200000 ? switches : 200000;
+    start = timing_now_ns();
+    for (long i = 0; i < copies; i++) {
+        memcpy(window, rom + (i % banks) * ROM_BANK_SIZE, ROM_BANK_SIZE);
+        sink += window[i & (ROM_BANK_SIZE - 1)];
+    }
+    double copy_seconds = (timing_now_ns() - start) / 1e9;
+
+    printf("bank switch: %.2f ns a cart_write, %.2f ns to copy a bank\n",
+            write_seconds * 1e9 / switches, copy_seconds * 1e9 / copies);
+    printf("bank switch loop: %llu switches, %.1f per frame, %.2f ns a time round the emulated loop\n",
+            (unsigned long long) switches, (double) switches * CYCLES_PER_FRAME / p->cycles,
+            seconds * 1e9 / switches);
+
+    free(window);
+    proc_delete(p);
+    cart_delete(c);
+    free(rom);
+}
+
+static void bench_rom_load() {
+    /* opening a 4 MiB rom by mapping it against reading the whole thing in */
+    const size_t size = 4 << 20;
+    const int loads = 200;
+
+    char path[] = "/tmp/bench_romXXXXXX";
+    int fd = mkstemp(path);
+    if (fd < 0) return;
+
+    uint8_t* rom = calloc(1, size);
+    rom[HEADER_TYPE] = 0x19;
+    if (write(fd, rom, size) != (ssize_t) size) {
+        close(fd);
+        remove(path);
+        free(rom);
+        return;
+    }
+    close(fd);
+
+    uint64_t start = timing_now_ns();
+    for (int i = 0; i < loads; i++) {
+        cart_delete(cart_create(path));
+    }
+    double mapped = (timing_now_ns() - start) / 1e9;
+
+    start = timing_now_ns();
+    for (int i = 0; i < loads; i++) {
+        FILE* f = fopen(path, "rb");
+        size_t read = fread(rom, 1, size, f);
+        fclose(f);
+        cart_delete(cart_create_from_buffer(rom, read));
+    }
+    double copied = (timing_now_ns() - start) / 1e9;
+
+    printf("rom load: 4 MiB rom mapped in %.1f us, read and copied in %.1f us\n",
+            mapped * 1e6 / loads, copied * 1e6 / loads);
+
+    remove(path);
+    free(rom);
+}
+
+static void bench_tiles(long instructions) {
+    /* a game streaming all of the tile data every frame, each byte written twice (clear then
+     * draw) and the tiles decoded once for the frame
+     */
+    Proc* p = proc_create();
+    long frames = instructions / 10000 + 1;
+
+    uint64_t decode_ns = 0;
+    uint64_t start = timing_now_ns();
+    for (long frame = 0; frame < frames; frame++) {
+        for (uint16_t address = 0x8000; address < 0x9800; address++) {
+            write_byte(p, address, 0);
+            write_byte(p, address, address + frame);
+        }
+
+        uint64_t decode_start = timing_now_ns();
+        tiles_update(p);
+        decode_ns += timing_now_ns() - decode_start;
+    }
+    double seconds = (timing_now_ns() - start) / 1e9;
+
+    printf("tiles: %.2f us per frame writing and decoding, %.1f tiles decoded per frame, %.2f ns per tile decoded\n",
+            seconds * 1e6 / frames, (double) p->stats.tiles_decoded / frames,
+            (double) decode_ns / p->stats.tiles_decoded);
+
+    proc_delete(p);
+}
+
+#endif
+
+static void bench_palette(long instructions) {
+    /* whole frames of shades to ARGB8888 the way the video thread does it */
+    static uint8_t shades[SCREEN_HEIGHT][SCREEN_WIDTH];
+    static uint32_t pixels[SCREEN_HEIGHT][SCREEN_WIDTH];
+    long frames = instructions / 10000 + 1;
+
+    for (int y = 0; y < SCREEN_HEIGHT; y++) {
+        for (int x = 0; x < SCREEN_WIDTH; x++) {
+            shades[y][x] = (x ^ y) & 3;
+        }
+    }
+
+    uint64_t start = timing_now_ns();
+    for (long frame = 0; frame < frames; frame++) {
+        for (int y = 0; y < SCREEN_HEIGHT; y++) {
+            palette_convert_line(&COLORS_DMG, shades[y], pixels[y], SCREEN_WIDTH);
+        }
+    }
+    uint64_t ns = timing_now_ns() - start;
+
+    // something has to read the pixels or the conversion can be thrown away
+    volatile uint32_t sink = pixels[frames % SCREEN_HEIGHT][frames % SCREEN_WIDTH];
+    (void) sink;
+
+    printf("palette: %.2f us per frame, %.3f ns per pixel\n",
+            ns / 1e3 / frames, (double) ns / frames / (SCREEN_WIDTH * SCREEN_HEIGHT));
+}
+
+static void bench_apu(long instructions, int writes) {
+    /* all four channels playing, with writes set a register is changed every 64 cycles.
+     * Writes only cost a sync each, the samples cost the same either way
+     */
+    Proc* p = proc_create();
+    AudioRing ring;
+    audio_ring_init(&ring, 1 << 16);
+    apu_set_output(p, &ring, 48000);
+
+    static const uint8_t setup[][2] = {
+        { 0x24, 0x77 }, { 0x25, 0xFF },
+        { 0x12, 0xF0 }, { 0x11, 0x80 }, { 0x13, 0x00 }, { 0x14, 0x87 },     // 512 Hz square
+        { 0x17, 0xF0 }, { 0x16, 0x40 }, { 0x18, 0x83 }, { 0x19, 0x86 },     // 344 Hz square
+        { 0x30, 0x01 }, { 0x31, 0x23 }, { 0x32, 0x45 }, { 0x33, 0x67 },
+        { 0x1A, 0x80 }, { 0x1C, 0x20 }, { 0x1D, 0x00 }, { 0x1E, 0x87 },     // wave
+        { 0x21, 0xF0 }, { 0x22, 0x21 }, { 0x23, 0x80 },                     // noise
+    };
+    for (size_t i = 0; i < sizeof(setup) / sizeof(setup[0]); i++) {
+        write_byte(p, 0xFF00 + setup[i][0], setup[i][1]);
+    }
+
+    long frames = instructions / 100000 + 1;
+    StereoSample discard[1024];
+
+    uint64_t start = timing_now_ns();
+    for (long frame = 0; frame < frames; frame++) {
+        for (int cycle = 0; cycle < CYCLES_PER_FRAME; cycle += 64) {
+            p->cycles += 64;
+            if (writes) write_byte(p, IO_NR23, 0x80 + (cycle & 7));
+            if (p->cycles >= scheduler_next(&p->scheduler)) io_run_events(p);
+        }
+        apu_sync(p);
+        while (audio_ring_read(&ring, discard, 1024) == 1024) {}
+    }
+    uint64_t ns = timing_now_ns() - start;
+
+    printf("apu, %-23s: %.1f ns per output sample, %.3f%% of real time\n",
+            writes ? "register every 64 cycles" : "steady", (double) ns / p->apu.samples,
+            100.0 * ns / (frames * FRAME_NS));
+
+    audio_ring_free(&ring);
+    proc_delete(p);
+}
+
+static void bench_state(long instructions) {
+    /* saving and loading in memory with a 32 KiB ram cart, vram and work ram filled with
+     * noise so packing has something to do besides the empty space
+     */
+    uint8_t * rom = calloc(4, ROM_BANK_SIZE);
+    rom[HEADER_TYPE] = 0x03;        // MBC1+RAM+BATTERY
+    rom[HEADER_RAM_SIZE] = 0x03;    // 32 KiB
+    Cart * cart = cart_create_from_buffer(rom, 4 * ROM_BANK_SIZE);
+    Proc * p = load_cpu_program();
+    cart_load(cart, p);
+
+    srand(1);
+    for (uint16_t address = 0x8000; address < 0x9800; address++) write_byte(p, address, rand());
+    for (uint16_t address = 0xC100; address < 0xD000; address++) write_byte(p, address, rand() & 0x0F);
+    proc_run_cycles(p, instructions / 100);
+
+    size_t capacity = state_bound(p);
+    uint8_t * buffer = malloc(capacity);
+    const int rounds = 2000;
+
+    for (int packed = 0; packed < 2; packed++) {
+        int flags = packed ? STATE_PACKED : 0;
+        size_t size = 0;
+
+        uint64_t start = timing_now_ns();
+        for (int i = 0; i < rounds; i++) {
+            size = state_save(p, buffer, capacity, flags);
+        }
+        uint64_t saved = timing_now_ns() - start;
+
+        start = timing_now_ns();
+        int loaded = 1;
+        for (int i = 0; i < rounds; i++) {
+            loaded &= state_load(p, buffer, size);
+        }
+        uint64_t load = timing_now_ns() - start;
+
+        printf("state, %-6s: %6zu bytes, saved in %.1f us, loaded in %.1f us%s\n", packed ? "packed" : "raw",
+                size, saved / 1e3 / rounds, load / 1e3 / rounds, loaded ? "" : ", failed to load");
+    }
+
+    free(buffer);
+    proc_delete(p);
+    cart_delete(cart);
+    free(rom);
+}
+
+static void bench_rewind(int threaded) {
+    /* a snapshot every frame of a loop adding to each byte of work ram in turn, a couple of
+     * KiB change every frame. The cpu thread's cost is what the frame pays
+     */
+    static const uint8_t sweep_program[] = {
+        0x21, 0x00, 0xC1,   // LD HL,C100
+        0x7E,               // LD A,(HL)
+        0x85,               // ADD A,L
+        0x22,               // LD (HL+),A
+        0x7C,               // LD A,H
+        0xFE, 0xD0,         // CP D0
+        0x20, 0xF8,         // JR NZ,-8
+        0x18, 0xF3,         // JR -13
+    };
+    const int frames = 600;
+    const size_t budget = 32 << 20;
+
+    Proc * p = proc_create();
+    for (int i = 0; i < sizeof(sweep_program); i++) {
+        write_byte(p, PROGRAM_START + i, sweep_program[i]);
+    }
+    p->pc = PROGRAM_START;
+
+    Rewind r;
+    rewind_init(&r, p, budget, frames, 1, threaded);
+    for (int frame = 0; frame < frames; frame++) {
+        proc_run_cycles(p, CYCLES_PER_FRAME);
+        rewind_frame(&r, p);
+    }
+
+    uint32_t snapshots = rewind_snapshots(&r);
+    uint64_t start = timing_now_ns();
+    for (uint32_t i = 0; i < snapshots; i++) {
+        rewind_step_back(&r, p);
+    }
+    uint64_t back_ns = timing_now_ns() - start;
+
+    double per_snapshot = (double) r.stored / (r.captures - 1);
+    printf("rewind, %-6s: %.1f us a frame on the cpu thread, %.1f us packing, %.0f bytes a snapshot, "
+            "%.1f KiB per second, %llu skipped, %.1f us stepping back\n",
+            threaded ? "worker" : "inline", r.capture_ns / 1e3 / r.captures + (threaded ? 0 : r.delta_ns / 1e3 / r.captures),
+            r.delta_ns / 1e3 / r.captures, per_snapshot, per_snapshot * 1e9 / FRAME_NS / 1024,
+            (unsigned long long) r.skipped, back_ns / 1e3 / snapshots);
+
+    rewind_free(&r);
+    proc_delete(p);
+}
+
+/* reference for the audio quality check, the same band limit as blip.c without its short kernel */
+#define REFERENCE_HALF_WIDTH 256
+#define REFERENCE_POINTS 64
+
+static double * reference_step;
+
+static void make_reference_step() {
+    /* a blackman windowed sinc over REFERENCE_HALF_WIDTH samples each side, summed to a step */
+    int points = 2 * REFERENCE_HALF_WIDTH * REFERENCE_POINTS;
+    reference_step = malloc((points + 1) * sizeof(double));
+
+    double total = 0;
+    reference_step[0] = 0;
+    for (int i = 0; i < points; i++) {
+        double t = (i + 0.5) / REFERENCE_POINTS - REFERENCE_HALF_WIDTH;
+        double x = 3.14159265358979323846 * 2 * 0.42 * t;
+        double w = (i + 0.5) / points;
+        double window = 0.42 - 0.5 * cos(2 * 3.14159265358979323846 * w) + 0.08 * cos(4 * 3.14159265358979323846 * w);
+        total += (x == 0 ? 1 : sin(x) / x) * window;
+        reference_step[i + 1] = total;
+    }
+    for (int i = 0; i <= points; i++) {
+        reference_step[i] /= total;
+    }
+}
+
+static double reference_at(double x) {
+    /* the step x samples after it happened */
+    double i = (x + REFERENCE_HALF_WIDTH) * REFERENCE_POINTS;
+    if (i <= 0) return 0;
+    if (i >= 2 * REFERENCE_HALF_WIDTH * REFERENCE_POINTS) return 1;
+    int index = (int) i;
+    double between = i - index;
+    return reference_step[index] * (1 - between) + reference_step[index + 1] * between;
+}
+
+static void bench_quality(uint32_t half_period) {
+    /* a square wave through the blip and point sampled like the apu used to, both against
+     * every step band limited exactly. Signal to error in dB, higher is better
+     */
+    enum { RATE = 48000, SAMPLES = 24000, SKIP = 1024, AMPLITUDE = 100 };
+    const double clocks_per_sample = (double) CLOCK_SPEED / RATE;
+    // the blip's output is behind by half its kernel
+    const double delay = BLIP_TAPS / 2 - 1;
+
+    // -A at clock 0 then up and down by 2A every half period, levels[j] is after step j
+    int steps = (int) ((SAMPLES + REFERENCE_HALF_WIDTH + 1) * clocks_per_sample / half_period) + 1;
+    double * deltas = malloc(steps * sizeof(double));
+    double * levels = malloc(steps * sizeof(double));
+    for (int j = 0; j < steps; j++) {
+        deltas[j] = j == 0 ? -AMPLITUDE : (j & 1 ? 2 : -2) * AMPLITUDE;
+        levels[j] = (j ? levels[j - 1] : 0) + deltas[j];
+    }
+
+    static float blipped[SAMPLES];
+    Blip * blip = malloc(sizeof(Blip));
+    blip_init(blip, CLOCK_SPEED, RATE);
+
+    uint64_t start = timing_now_ns();
+    uint32_t made = 0;
+    uint64_t frame_start = 0;
+    int step = 0;
+    while (made < SAMPLES) {
+        uint32_t clocks = blip_max_clocks(blip);
+        for (; (uint64_t) step * half_period < frame_start + clocks; step++) {
+            blip_add_delta(blip, (uint64_t) step * half_period - frame_start, deltas[step]);
+        }
+        blip_end_frame(blip, clocks);
+        frame_start += clocks;
+        made += blip_read(blip, blipped + made, SAMPLES - made);
+    }
+    uint64_t ns = timing_now_ns() - start;
+
+    double signal = 0, blip_error = 0, point_error = 0;
+    for (int n = SKIP; n < SAMPLES; n++) {
+        double reference[2];
+        double times[2] = { n - delay, n };
+        for (int r = 0; r < 2; r++) {
+            // everything before the window is settled, the steps in it are part way
+            double t = times[r];
+            int first = (int) ceil((t - REFERENCE_HALF_WIDTH) * clocks_per_sample / half_period);
+            int last = (int) floor((t + REFERENCE_HALF_WIDTH) * clocks_per_sample / half_period);
+            double level = first > 0 ? levels[first - 1] : 0;
+            for (int j = first > 0 ? first : 0; j <= last; j++) {
+                level += deltas[j] * reference_at(t - j * half_period / clocks_per_sample);
+            }
+            reference[r] = level;
+        }
+
+        // the level at the clock the sample lands on
+        int sampled = (int) floor(n * clocks_per_sample / half_period);
+        double point = levels[sampled];
+
+        signal += reference[1] * reference[1];
+        blip_error += (blipped[n] - reference[0]) * (blipped[n] - reference[0]);
+        point_error += (point - reference[1]) * (point - reference[1]);
+    }
+
+    printf("audio, %5.0f Hz square : blip %.1f dB, point sampled %.1f dB, blip %.1f ns per sample\n",
+            CLOCK_SPEED / (2.0 * half_period), 10 * log10(signal / blip_error),
+            10 * log10(signal / point_error), (double) ns / SAMPLES);
+
+    free(blip);
+    free(deltas);
+    free(levels);
+}
+
+int main(int argc, char **argv) {
+    long instructions = argc > 1 ? atol(argv[1]) : DEFAULT_INSTRUCTIONS;
+
+    print_layout();
+    bench_cpu(instructions);
+
+#ifndef BENCH_CPU_ONLY
+    bench_block_cache(instructions, 0, 0);
+    bench_block_cache(instructions, 1, 0);
+    bench_block_cache(instructions, 1, 1);
+    bench_halt(instructions);
+    bench_idle(instructions, 0);
+    bench_idle(instructions, 1);
+    bench_bank_switch(instructions);
+    bench_rom_load();
+    bench_tiles(instructions);
+    bench_palette(instructions);
+    bench_state(instructions);
+    bench_rewind(0);
+    bench_rewind(1);
+    bench_apu(instructions, 0);
+    bench_apu(instructions, 1);
+
+    make_reference_step();
+    // a 440 Hz tone, then one high enough that most of its harmonics are past the band
+    bench_quality(4766);
+    bench_quality(595);
+    free(reference_step);
+#endif
+
+    return 0;
+}
@@ -0,0 +1,139 @@
+// blip.c
+#include <math.h>
+#include <string.h>
+
+#include "blip.h"
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+// passes everything up to 0.42 of the output rate (~20 kHz at 48 kHz)
+#define BLIP_CUTOFF 0.42
+
+#define FRACTION_BITS 32
+
+// M_PI isn't in c99
+#define PI 3.14159265358979323846
+
+/* kernel[phase][tap] is how much of a step at phase / BLIP_PHASES past a sample lands on
+ * each of the samples after it, one more phase than needed to interpolate up to the next
+ */
+static float kernel[BLIP_PHASES + 1][BLIP_TAPS] __attribute__((aligned(32)));
+static int kernel_ready;
+
+static void make_kernel() {
+    /* a windowed sinc at BLIP_PHASES points per sample, summed up into a step that goes
+     * from 0 to 1 over BLIP_TAPS samples. Each phase is the step's rise over every sample
+     */
+    enum { POINTS = BLIP_TAPS * BLIP_PHASES };
+    static double step[POINTS + 1];
+    double total = 0;
+
+    step[0] = 0;
+    for (int i = 0; i < POINTS; i++) {
+        // the middle of each point, centred on the middle of the kernel
+        double t = (i + 0.5) / BLIP_PHASES - BLIP_TAPS / 2.0;
+        double x = PI * 2 * BLIP_CUTOFF * t;
+        double sinc = x == 0 ? 1 : sin(x) / x;
+        // blackman
+        double w = (i + 0.5) / POINTS;
+        double window = 0.42 - 0.5 * cos(2 * PI * w) + 0.08 * cos(4 * PI * w);
+        total += sinc * window;
+        step[i + 1] = total;
+    }
+
+    for (int phase = 0; phase <= BLIP_PHASES; phase++) {
+        for (int tap = 0; tap < BLIP_TAPS; tap++) {
+            // step rises between tap - phase and tap + 1 - phase (in samples), 0 before the start
+            int from = tap * BLIP_PHASES - phase;
+            int to = from + BLIP_PHASES;
+            double low = from < 0 ? 0 : step[from];
+            double high = to < 0 ? 0 : to > POINTS ? total : step[to];
+            kernel[phase][tap] = (high - low) / total;
+        }
+    }
+    kernel_ready = 1;
+}
+
+void blip_set_rates(Blip * b, double clock_rate, double sample_rate) {
+    b->factor = (uint64_t) (sample_rate / clock_rate * (1ULL << FRACTION_BITS) + 0.5);
+}
+
+void blip_init(Blip * b, double clock_rate, double sample_rate) {
+    if (!kernel_ready) make_kernel();
+
+    memset(b, 0, sizeof(Blip));
+    blip_set_rates(b, clock_rate, sample_rate);
+}
+
+uint32_t blip_max_clocks(const Blip * b) {
+    // what's still waiting to be read counts against it too
+    uint64_t space = ((uint64_t) BLIP_MAX_SAMPLES << FRACTION_BITS) - b->offset;
+    return space / b->factor;
+}
+
+void blip_add_delta(Blip * b, uint32_t clock, float delta) {
+    uint64_t position = b->offset + clock * b->factor;
+    float * out = &b->deltas[position >> FRACTION_BITS];
+
+    // the phase and how far it is towards the next one
+    uint32_t fraction = (uint32_t) position;
+    int phase = fraction >> (FRACTION_BITS - BLIP_PHASE_BITS);
+    float between = (fraction & ((1u << (FRACTION_BITS - BLIP_PHASE_BITS)) - 1))
+            * (1.0f / (1u << (FRACTION_BITS - BLIP_PHASE_BITS)));
+
+    const float * k0 = kernel[phase];
+    const float * k1 = kernel[phase + 1];
+    float w1 = delta * between;
+    float w0 = delta - w1;
+
+#if defined(__AVX2__)
+    const __m256 v0 = _mm256_set1_ps(w0), v1 = _mm256_set1_ps(w1);
+    for (int tap = 0; tap < BLIP_TAPS; tap += 8) {
+        __m256 k = _mm256_add_ps(_mm256_mul_ps(_mm256_load_ps(k0 + tap), v0),
+                                 _mm256_mul_ps(_mm256_load_ps(k1 + tap), v1));
+        _mm256_storeu_ps(out + tap, _mm256_add_ps(_mm256_loadu_ps(out + tap), k));
+    }
+#elif defined(__SSE2__)
+    const __m128 v0 = _mm_set1_ps(w0), v1 = _mm_set1_ps(w1);
+    for (int tap = 0; tap < BLIP_TAPS; tap += 4) {
+        __m128 k = _mm_add_ps(_mm_mul_ps(_mm_load_ps(k0 + tap), v0),
+                              _mm_mul_ps(_mm_load_ps(k1 + tap), v1));
+        _mm_storeu_ps(out + tap, _mm_add_ps(_mm_loadu_ps(out + tap), k));
+    }
+#else
+    for (int tap = 0; tap < BLIP_TAPS; tap++) {
+        out[tap] += k0[tap] * w0 + k1[tap] * w1;
+    }
+#endif
+}
+
+void blip_end_frame(Blip * b, uint32_t clocks) {
+    b->offset += clocks * b->factor;
+}
+
+uint32_t blip_samples_avail(const Blip * b) {
+    return b->offset >> FRACTION_BITS;
+}
+
+uint32_t blip_read(Blip * b, float * samples, uint32_t count) {
+    uint32_t avail = blip_samples_avail(b);
+    if (count > avail) count = avail;
+
+    float sum = b->sum;
+    for (uint32_t i = 0; i < count; i++) {
+        sum += b->deltas[i];
+        samples[i] = sum;
+    }
+    b->sum = sum;
+
+    // what's left, and the tail of the steps past it, moves to the front
+    uint32_t left = avail - count + BLIP_TAPS;
+    memmove(b->deltas, b->deltas + count, left * sizeof(float));
+    memset(b->deltas + left, 0, count * sizeof(float));
+    b->offset -= (uint64_t) count << FRACTION_BITS;
+    return count;
+}
@@ -0,0 +1,51 @@
+#ifndef BLIP_H
+#define BLIP_H
+
+#include <stdint.h>
+
+/*
+ * Band-limited step synthesis, http://www.slack.net/~ant/bl-synth/
+ *
+ * The channels are square waves and the like, the whole output is a series of steps at
+ * exact clock times. Each step goes into the buffer as a band-limited step (a windowed sinc
+ * summed up) at the output rate rather than being sampled, so there's no aliasing and the
+ * cost is the number of steps plus the number of samples, it doesn't matter how high the
+ * clock rate is. The buffer holds the differences, reading sums them back up.
+ *
+ * A frame is any run of clocks, blip_end_frame makes the samples in it readable and times
+ * in the next frame are from where it ended.
+ */
+
+// samples each step is spread over, the output is delayed by half of it
+#define BLIP_TAPS 32
+// fractional positions the kernel is worked out for, in between is interpolated
+#define BLIP_PHASE_BITS 6
+#define BLIP_PHASES (1 << BLIP_PHASE_BITS)
+// most samples one frame can make before they have to be read
+#define BLIP_MAX_SAMPLES 1024
+
+typedef struct {
+    // output samples per clock, 32.32 fixed point
+    uint64_t factor;
+    // where the next frame starts in output samples, 32.32 fixed point
+    uint64_t offset;
+    // running total of what's been read
+    float sum;
+    float deltas[BLIP_MAX_SAMPLES + BLIP_TAPS];
+} Blip;
+
+void     blip_init(Blip * b, double clock_rate, double sample_rate);
+// changes the ratio without losing anything already in the buffer
+void     blip_set_rates(Blip * b, double clock_rate, double sample_rate);
+// longest frame that's guaranteed to fit
+uint32_t blip_max_clocks(const Blip * b);
+
+// delta is added to the output from clock onwards
+void     blip_add_delta(Blip * b, uint32_t clock, float delta);
+void     blip_end_frame(Blip * b, uint32_t clocks);
+
+uint32_t blip_samples_avail(const Blip * b);
+// returns how many were read
+uint32_t blip_read(Blip * b, float * samples, uint32_t count);
+
+#endif
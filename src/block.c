@@ -0,0 +1,94 @@
+#include <stdlib.h>
+
+#include "block.h"
+
+BlockCache * block_cache_create() {
+    return calloc(1, sizeof(BlockCache));
+}
+
+void block_cache_delete(BlockCache * c) {
+    if (!c) return;
+
+    block_cache_flush(c);
+
+    while (c->free_blocks) {
+        Block * b = c->free_blocks;
+        c->free_blocks = b->next_free;
+        free(b);
+    }
+
+    free(c);
+}
+
+Block * block_cache_lookup(BlockCache * c, uint16_t address, uint16_t bank) {
+    Block * b = c->blocks[address];
+
+    if (b && b->bank == bank) {
+        c->hits++;
+        return b;
+    }
+
+    c->misses++;
+    return NULL;
+}
+
+Block * block_cache_new_block(BlockCache * c) {
+    Block * b = c->free_blocks;
+
+    if (b) {
+        c->free_blocks = b->next_free;
+    } else {
+        b = malloc(sizeof(Block));
+    }
+
+    return b;
+}
+
+static void block_cache_remove(BlockCache * c, Block * b) {
+    /* unlinks a block, it goes on the free list rather than free() since it may be running */
+    c->blocks[b->start] = NULL;
+    for (uint32_t i = 0; i < b->bytes; i++) {
+        uint16_t address = b->start + i;
+        c->code[address]--;
+        c->page_code[address >> CODE_PAGE_SHIFT]--;
+    }
+
+    b->valid = 0;
+    b->next_free = c->free_blocks;
+    c->free_blocks = b;
+}
+
+void block_cache_insert(BlockCache * c, Block * b) {
+    // a block from another rom bank can be sitting at the same address
+    if (c->blocks[b->start]) {
+        block_cache_remove(c, c->blocks[b->start]);
+    }
+
+    b->valid = 1;
+    c->blocks[b->start] = b;
+    for (uint32_t i = 0; i < b->bytes; i++) {
+        uint16_t address = b->start + i;
+        c->code[address]++;
+        c->page_code[address >> CODE_PAGE_SHIFT]++;
+    }
+}
+
+void block_cache_invalidate(BlockCache * c, uint16_t address) {
+    /* drops every block that covers the address, they can only start up to MAX_BLOCK_BYTES before it */
+    for (int i = 0; i < MAX_BLOCK_BYTES && c->code[address]; i++) {
+        Block * b = c->blocks[(uint16_t) (address - i)];
+
+        if (b && b->bytes > i) {
+            block_cache_remove(c, b);
+            c->invalidations++;
+        }
+    }
+}
+
+void block_cache_flush(BlockCache * c) {
+    for (uint32_t i = 0; i < BLOCK_CACHE_SIZE; i++) {
+        if (c->blocks[i]) {
+            block_cache_remove(c, c->blocks[i]);
+        }
+    }
+}
@@ -0,0 +1,83 @@
+#ifndef BLOCK_H
+#define BLOCK_H
+
+#include <stdint.h>
+
+/*
+ * Cache of pre-decoded basic blocks, a block is a straight run of instructions ending at
+ * the first jump/call/return (or MAX_BLOCK_OPS). Each instruction is stored already decoded
+ * as a MicroOp so running a block doesn't fetch or decode anything.
+ */
+
+#define MAX_BLOCK_OPS 32
+// longest instruction is 3 bytes
+#define MAX_BLOCK_BYTES (MAX_BLOCK_OPS * 3)
+
+#define BLOCK_CACHE_SIZE (1 << 16)
+// live code is also counted per 4 KiB page, the memory bus pages are the same size
+#define CODE_PAGE_SHIFT 12
+
+struct Proc;
+
+// returns 1 if it was a conditional JR/JP/CALL/RET that was taken
+typedef int (*OpHandler)(struct Proc* p, uint16_t operand);
+
+// a block compiled by the jit, runs the whole block
+typedef void (*NativeBlock)(struct Proc* p);
+
+typedef struct {
+    OpHandler handler;
+    uint16_t operand;
+    uint8_t length;
+    uint8_t cycles;
+    uint8_t cycles_taken;
+} MicroOp;
+
+typedef struct Block {
+    uint16_t start;
+    uint16_t bytes;
+    uint16_t bank;
+    uint8_t count;
+    uint8_t valid;
+    struct Block * next_free;
+
+    // cycles if every conditional op is taken, the most the block can run for
+    uint16_t max_cycles;
+
+    // jit state, runs counts up to the threshold then the block is compiled or rejected
+    uint16_t runs;
+    uint8_t rejected;
+    NativeBlock native;
+
+    // IDLE_LOOP and what it reads if the block is a busy-wait loop (idle.h), 0 otherwise
+    uint8_t idle;
+
+    MicroOp ops[MAX_BLOCK_OPS];
+} Block;
+
+typedef struct {
+    // indexed by the address the block starts at
+    Block * blocks[BLOCK_CACHE_SIZE];
+    // number of live blocks covering each address, writes only look at the cache when this is set
+    uint16_t code[BLOCK_CACHE_SIZE];
+    uint16_t page_code[BLOCK_CACHE_SIZE >> CODE_PAGE_SHIFT];
+
+    // invalidated blocks are kept around to reuse, a block can be invalidated while it runs
+    Block * free_blocks;
+
+    uint64_t hits;
+    uint64_t misses;
+    uint64_t invalidations;
+} BlockCache;
+
+BlockCache * block_cache_create();
+void         block_cache_delete(BlockCache * c);
+
+Block *      block_cache_lookup(BlockCache * c, uint16_t address, uint16_t bank);
+Block *      block_cache_new_block(BlockCache * c);
+void         block_cache_insert(BlockCache * c, Block * b);
+
+void         block_cache_invalidate(BlockCache * c, uint16_t address);
+void         block_cache_flush(BlockCache * c);
+
+#endif
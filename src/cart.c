@@ -1,11 +1,134 @@
+// cart.c
+// needed for mmap and fstat with -std=c99
+#define _POSIX_C_SOURCE 200112L
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
 #include "cart.h"
+#include "memory.h"
+
+/* https://gbdev.io/pandocs/MBCs.html */
+
+static void cart_init(Cart* c) {
+    /* works out the bank controller and sizes from the header once the rom is in */
+    c->rom_banks = c->rom_size / ROM_BANK_SIZE;
+    c->rom_bank = 1;
+
+    switch (c->rom[HEADER_TYPE]) {
+    case 0x00: case 0x08: case 0x09:
+        c->type = MBC_NONE;
+        break;
+    case 0x01: case 0x02: case 0x03:
+        c->type = MBC_1;
+        break;
+    case 0x05: case 0x06:
+        c->type = MBC_2;
+        break;
+    case 0x0F: case 0x10: case 0x11: case 0x12: case 0x13:
+        c->type = MBC_3;
+        break;
+    case 0x19: case 0x1A: case 0x1B: case 0x1C: case 0x1D: case 0x1E:
+        c->type = MBC_5;
+        break;
+    default:
+        printf("Unsupported cartridge type %02X, running it without banking\n", c->rom[HEADER_TYPE]);
+        c->type = MBC_NONE;
+        break;
+    }
+
+    // 0, unused, 8 KiB, 32 KiB, 128 KiB, 64 KiB
+    static const size_t ram_sizes[] = { 0, 0x800, 0x2000, 0x8000, 0x20000, 0x10000 };
+    uint8_t ram_size = c->rom[HEADER_RAM_SIZE];
+    c->ram_size = ram_size < 6 ? ram_sizes[ram_size] : 0;
+    if (c->type == MBC_2) c->ram_size = MBC2_RAM_SIZE;
+
+    if (c->ram_size) {
+        // always at least one whole bank so the bank pointer can cover 0xA000 -> 0xBFFF
+        if (c->type != MBC_2 && c->ram_size < RAM_BANK_SIZE) c->ram_size = RAM_BANK_SIZE;
+        c->ram = calloc(1, c->ram_size);
+        c->ram_banks = c->ram ? c->ram_size / RAM_BANK_SIZE : 0;
+    }
+
+    // ROM+RAM carts have nothing to switch the ram on with, it's just there
+    c->ram_enabled = c->type == MBC_NONE;
+}
+
+static Cart* cart_alloc_rom(size_t size) {
+    /* rounds the rom up to whole banks, at least the two that are always mapped */
+    Cart* c = calloc(1, sizeof(Cart));
+    if (!c) return NULL;
+
+    size = (size + ROM_BANK_SIZE - 1) / ROM_BANK_SIZE * ROM_BANK_SIZE;
+    c->rom_size = size < CART_SIZE ? CART_SIZE : size;
+    c->rom = calloc(1, c->rom_size);
+    if (!c->rom) {
+        free(c);
+        return NULL;
+    }
+
+    return c;
+}
+
+static Cart* cart_map_file(int fd, size_t size) {
+    /* maps the rom read only, nothing is read until a bank is touched and the pages come
+     * straight from the page cache. Only whole banks can be mapped, reading past the end
+     * of the file would fault
+     */
+    if (size < CART_SIZE || size % ROM_BANK_SIZE) return NULL;
+
+    void* rom = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (rom == MAP_FAILED) return NULL;
 
-Cart* cart_create(char* rom_file) {
     Cart* c = calloc(1, sizeof(Cart));
+    if (!c) {
+        munmap(rom, size);
+        return NULL;
+    }
+
+    c->rom = rom;
+    c->rom_size = size;
+    c->rom_mapped = 1;
+    return c;
+}
+
+Cart* cart_create(char* rom_file) {
+    int fd = open(rom_file, O_RDONLY);
+    if (fd < 0) {
+        printf("Error opening file '%s'!\n", rom_file);
+        return NULL;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        printf("Error opening file '%s'!\n", rom_file);
+        close(fd);
+        return NULL;
+    }
+
+    Cart* c = cart_map_file(fd, st.st_size);
+    close(fd);
+
+    // odd sized roms get read into a copy padded out to whole banks
+    if (!c) {
+        c = cart_alloc_rom(st.st_size);
+        if (c) cart_read(c, rom_file);
+    }
+
+    if (c) cart_init(c);
+
+    return c;
+}
+
+Cart* cart_create_from_buffer(const uint8_t* rom, size_t size) {
+    /* for roms that are already in memory, the cart gets its own copy */
+    Cart* c = cart_alloc_rom(size);
 
     if (c) {
-        memset(c->rom, 0, CART_SIZE);
-        cart_read(c, rom_file);
+        memcpy(c->rom, rom, size);
+        cart_init(c);
     }
 
     return c;
@@ -21,34 +144,184 @@ void cart_read(Cart* c, char *rom_file) {
         return;
     }
 
-    // Find file size
-    fseek(f, 0L, SEEK_END);
-    int size = ftell(f);
-    // check if size too big
-    if (size > CART_SIZE) {
-        printf("Error: Rom too big!\n");
-        fclose(f);
-        return;
+    if (fread(c->rom, 1, c->rom_size, f) == 0) {
+        printf("Error reading '%s'!\n", rom_file);
     }
-    // Reset pointer
-    fseek(f, 0L, SEEK_SET);
-
-    fread(c->rom, size, 1, f);
 
     fclose(f);
 }
 
+/* ---------------------------------------------------------------------------------------
+ * banks
+ * --------------------------------------------------------------------------------------- */
+
+static void cart_map(Cart* c, Proc* p) {
+    /* points Proc at the banks the registers select, a bank switch is just this */
+    uint16_t bank0 = 0;
+    uint16_t bank1;
+    uint8_t ram_bank = 0;
+
+    switch (c->type) {
+    case MBC_1:
+        // the 2 bit register is the upper rom bits, in mode 1 it banks 0x0000 and the ram too
+        bank1 = (c->ram_bank << 5) | ((c->rom_bank & 0x1F) ? (c->rom_bank & 0x1F) : 1);
+        if (c->mode) {
+            bank0 = c->ram_bank << 5;
+            ram_bank = c->ram_bank;
+        }
+        break;
+    case MBC_2:
+        bank1 = (c->rom_bank & 0x0F) ? (c->rom_bank & 0x0F) : 1;
+        break;
+    case MBC_3:
+        bank1 = (c->rom_bank & 0x7F) ? (c->rom_bank & 0x7F) : 1;
+        ram_bank = c->ram_bank;
+        break;
+    case MBC_5:
+        // bank 0 can be mapped at 0x4000 here
+        bank1 = c->rom_bank & 0x1FF;
+        ram_bank = c->ram_bank & 0x0F;
+        break;
+    default:
+        bank1 = 1;
+        break;
+    }
+
+    bank0 %= c->rom_banks;
+    bank1 %= c->rom_banks;
+    if (bank0 != p->rom_map_bank[0] || bank1 != p->rom_map_bank[1]) {
+        c->bank_switches++;
+        // the block running could be from the bank that just went, stop it after this write
+        p->deadline = p->cycles;
+    }
+
+    // the rom is read only, writes go to the bank registers
+    memory_map_pages(p, 0x0000, ROM_BANK_SIZE, c->rom + (size_t) bank0 * ROM_BANK_SIZE, NULL);
+    memory_map_pages(p, 0x4000, ROM_BANK_SIZE, c->rom + (size_t) bank1 * ROM_BANK_SIZE, NULL);
+    p->rom_map_bank[0] = bank0;
+    p->rom_map_bank[1] = bank1;
+
+    // MBC2 ram and the MBC3 clock go through cart_read_ram / cart_write_ram instead
+    uint8_t * ram = NULL;
+    if (c->ram_enabled && c->ram_banks && c->type != MBC_2 && ram_bank < 8) {
+        ram = c->ram + (size_t) (ram_bank % c->ram_banks) * RAM_BANK_SIZE;
+    }
+    memory_map_pages(p, 0xA000, RAM_BANK_SIZE, ram, ram);
+}
 
-/* Add memory in from from 0x0000 -> 0x8000 to processor */
 void cart_load(Cart* c, Proc* p) {
+    /* plugs the cart in, reads from 0x0000 -> 0x7FFF and 0xA000 -> 0xBFFF go to it from now on */
     if (!c || !p) return;
 
-    for (uint32_t i = 0; i < CART_SIZE; i++) {
-        p->memory[i] = c->rom[i];
+    p->cart = c;
+    cart_map(c, p);
+}
+
+/* ---------------------------------------------------------------------------------------
+ * MBC3 clock
+ * --------------------------------------------------------------------------------------- */
+
+static void rtc_sync(Cart* c, Proc* p) {
+    /* brings the clock up to the emulated time, it runs off the cpu clock rather than the host's */
+    uint64_t seconds = (p->cycles - c->rtc_cycles) / CLOCK_SPEED;
+    c->rtc_cycles += seconds * CLOCK_SPEED;
+
+    // bit 6 of the day high register stops it
+    if (!seconds || (c->rtc[RTC_DAY_HIGH] & 0x40)) return;
+
+    uint64_t days = c->rtc[RTC_DAY_LOW] | ((c->rtc[RTC_DAY_HIGH] & 1) << 8);
+    uint64_t total = c->rtc[RTC_SECONDS] + 60 * (c->rtc[RTC_MINUTES] + 60 * (c->rtc[RTC_HOURS] + 24 * days)) + seconds;
+
+    c->rtc[RTC_SECONDS] = total % 60;
+    c->rtc[RTC_MINUTES] = (total / 60) % 60;
+    c->rtc[RTC_HOURS] = (total / 3600) % 24;
+
+    days = total / 86400;
+    c->rtc[RTC_DAY_LOW] = days & 0xFF;
+    c->rtc[RTC_DAY_HIGH] = (c->rtc[RTC_DAY_HIGH] & 0xC0) | ((days >> 8) & 1);
+    // the day counter overflowing past 511 sets the carry, it stays set until it's written
+    if (days > 511) c->rtc[RTC_DAY_HIGH] |= 0x80;
+}
+
+/* ---------------------------------------------------------------------------------------
+ * reads and writes
+ * --------------------------------------------------------------------------------------- */
+
+void cart_write(Cart* c, Proc* p, uint16_t address, uint8_t value) {
+    switch (c->type) {
+    case MBC_1:
+        if (address < 0x2000) c->ram_enabled = (value & 0x0F) == 0x0A;
+        else if (address < 0x4000) c->rom_bank = value & 0x1F;
+        else if (address < 0x6000) c->ram_bank = value & 0x03;
+        else c->mode = value & 1;
+        break;
+    case MBC_2:
+        // bit 8 of the address picks between the two registers
+        if (address >= 0x4000) return;
+        if (address & 0x100) c->rom_bank = value & 0x0F;
+        else c->ram_enabled = (value & 0x0F) == 0x0A;
+        break;
+    case MBC_3:
+        if (address < 0x2000) c->ram_enabled = (value & 0x0F) == 0x0A;
+        else if (address < 0x4000) c->rom_bank = value & 0x7F;
+        else if (address < 0x6000) c->ram_bank = value;
+        else {
+            // writing 0 then 1 latches the clock
+            if (!c->rtc_latch && value == 1) {
+                rtc_sync(c, p);
+                memcpy(c->rtc_latched, c->rtc, NUM_RTC);
+            }
+            c->rtc_latch = value;
+        }
+        break;
+    case MBC_5:
+        if (address < 0x2000) c->ram_enabled = (value & 0x0F) == 0x0A;
+        else if (address < 0x3000) c->rom_bank = (c->rom_bank & 0x100) | value;
+        else if (address < 0x4000) c->rom_bank = (c->rom_bank & 0xFF) | ((value & 1) << 8);
+        else if (address < 0x6000) c->ram_bank = value & 0x0F;
+        break;
+    default:
+        return;
+    }
+
+    cart_map(c, p);
+}
+
+uint8_t cart_read_ram(Cart* c, Proc* p, uint16_t address) {
+    if (!c->ram_enabled) return 0xFF;
+
+    if (c->type == MBC_2) {
+        // only the lower 4 bits exist, mirrored all through 0xA000 -> 0xBFFF
+        return 0xF0 | c->ram[address & (MBC2_RAM_SIZE - 1)];
+    }
+
+    if (c->type == MBC_3 && c->ram_bank >= 0x08 && c->ram_bank <= 0x0C) {
+        return c->rtc_latched[c->ram_bank - 0x08];
+    }
+
+    return 0xFF;
+}
+
+void cart_write_ram(Cart* c, Proc* p, uint16_t address, uint8_t value) {
+    if (!c->ram_enabled) return;
+
+    if (c->type == MBC_2) {
+        c->ram[address & (MBC2_RAM_SIZE - 1)] = value & 0x0F;
+    } else if (c->type == MBC_3 && c->ram_bank >= 0x08 && c->ram_bank <= 0x0C) {
+        rtc_sync(c, p);
+        c->rtc[c->ram_bank - 0x08] = value;
+        // writing the seconds starts the second over
+        if (c->ram_bank == 0x08) c->rtc_cycles = p->cycles;
     }
 }
 
 void cart_delete(Cart* c) {
     if (!c) return;
+    free(c->ram);
+    if (c->rom_mapped) {
+        munmap(c->rom, c->rom_size);
+    } else {
+        free(c->rom);
+    }
     free(c);
-}
\ No newline at end of file
+}
@@ -5,18 +5,83 @@
 #include "helpers.h"
 #include "proc.h"
 
+// smallest rom, two 16 KiB banks without a memory bank controller
 #define CART_SIZE (1 << 15)
+#define ROM_BANK_SIZE 0x4000
+#define RAM_BANK_SIZE 0x2000
 
-// DEAL WITH MEMORY BANKS LATER
+// MBC2 has 512 x 4 bits of ram built in
+#define MBC2_RAM_SIZE 512
 
-typedef struct {
-    unsigned char rom[CART_SIZE];
+/* cartridge header */
+#define HEADER_TITLE 0x134
+#define HEADER_TYPE 0x147
+#define HEADER_ROM_SIZE 0x148
+#define HEADER_RAM_SIZE 0x149
+#define HEADER_CHECKSUM 0x14D
+#define HEADER_GLOBAL_CHECKSUM 0x14E
+
+typedef enum {
+    MBC_NONE,
+    MBC_1,
+    MBC_2,
+    MBC_3,
+    MBC_5
+} MbcType;
+
+/* MBC3 clock registers, selected as ram banks 0x08 -> 0x0C */
+enum RtcRegister {
+    RTC_SECONDS,
+    RTC_MINUTES,
+    RTC_HOURS,
+    RTC_DAY_LOW,
+    RTC_DAY_HIGH,
+    NUM_RTC
+};
+
+/*
+ * The rom and ram stay here, switching banks only changes which bank the memory pages
+ * point at so nothing is ever copied into Proc.memory.
+ */
+typedef struct Cart {
+    // mapped straight from the file when it can be, so every instance running it shares the pages
+    uint8_t * rom;
+    size_t rom_size;
+    uint16_t rom_banks;
+    uint8_t rom_mapped;
+
+    uint8_t * ram;
+    size_t ram_size;
+    uint8_t ram_banks;
+
+    MbcType type;
+
+    // bank registers as the game wrote them, cart_map works out the banks from them
+    uint16_t rom_bank;
+    uint8_t ram_bank;
+    uint8_t ram_enabled;
+    uint8_t mode;
+
+    // MBC3 clock, it's latched into rtc_latched for reading, ticks from rtc_cycles onwards
+    uint8_t rtc[NUM_RTC];
+    uint8_t rtc_latched[NUM_RTC];
+    uint8_t rtc_latch;
+    uint64_t rtc_cycles;
+
+    // number of times the game switched banks
+    uint64_t bank_switches;
 } Cart;
 
-Cart* cart_create(char* rom_file);
-void  cart_read(Cart* c, char* rom_file);
-void  cart_load(Cart* c, Proc* p);
-void  cart_delete(Cart* c);
+Cart*   cart_create(char* rom_file);
+Cart*   cart_create_from_buffer(const uint8_t* rom, size_t size);
+void    cart_read(Cart* c, char* rom_file);
+void    cart_load(Cart* c, Proc* p);
+void    cart_delete(Cart* c);
 
+// writes to 0x0000 -> 0x7FFF go to the bank controller
+void    cart_write(Cart* c, Proc* p, uint16_t address, uint8_t value);
+// ram the bank pointers can't cover, disabled / MBC2 / the MBC3 clock
+uint8_t cart_read_ram(Cart* c, Proc* p, uint16_t address);
+void    cart_write_ram(Cart* c, Proc* p, uint16_t address, uint8_t value);
 
-#endif
\ No newline at end of file
+#endif
@@ -0,0 +1,43 @@
+// frames.c
+#include <string.h>
+
+#include "frames.h"
+
+void triple_buffer_init(TripleBuffer * t) {
+    memset(t->buffers, 0, sizeof(t->buffers));
+    t->back = 0;
+    t->ready = 1;
+    t->front = 2;
+    t->published = t->dropped = 0;
+    t->presented = t->duplicated = 0;
+}
+
+uint8_t (*triple_buffer_publish(TripleBuffer * t))[SCREEN_WIDTH] {
+    /* hands the finished back buffer over and takes whatever was ready to draw the next one */
+    int old = __atomic_exchange_n(&t->ready, t->back | FRAME_FRESH, __ATOMIC_ACQ_REL);
+
+    t->published++;
+    // nothing took the last one before this replaced it
+    if (old & FRAME_FRESH) t->dropped++;
+
+    t->back = old & ~FRAME_FRESH;
+    return t->buffers[t->back];
+}
+
+int triple_buffer_waiting(TripleBuffer * t) {
+    return (__atomic_load_n(&t->ready, __ATOMIC_ACQUIRE) & FRAME_FRESH) != 0;
+}
+
+const uint8_t (*triple_buffer_acquire(TripleBuffer * t))[SCREEN_WIDTH] {
+    t->presented++;
+
+    if (!(__atomic_load_n(&t->ready, __ATOMIC_ACQUIRE) & FRAME_FRESH)) {
+        t->duplicated++;
+        return (const uint8_t (*)[SCREEN_WIDTH]) t->buffers[t->front];
+    }
+
+    // the ready frame is fresh and only the presenter clears that, so this gets it
+    int ready = __atomic_exchange_n(&t->ready, t->front, __ATOMIC_ACQ_REL);
+    t->front = ready & ~FRAME_FRESH;
+    return (const uint8_t (*)[SCREEN_WIDTH]) t->buffers[t->front];
+}
@@ -0,0 +1,66 @@
+#ifndef FRAMES_H
+#define FRAMES_H
+
+#include <stdint.h>
+
+/*
+ * Triple buffer between the cpu thread drawing frames and whatever shows them. The ppu
+ * always has a buffer of its own to draw into, finishing a frame swaps it with the ready
+ * one, and the presenter swaps its buffer for the ready one when there's a new frame. Each
+ * side only ever does one atomic exchange so neither waits on the other, and the presenter
+ * always gets the newest whole frame.
+ */
+
+#define SCREEN_WIDTH 160
+#define SCREEN_HEIGHT 144
+
+// set in TripleBuffer.ready when the frame there hasn't been taken yet
+#define FRAME_FRESH 0x4
+
+typedef uint8_t Frame[SCREEN_HEIGHT][SCREEN_WIDTH];
+
+typedef struct {
+    Frame buffers[3] __attribute__((aligned(64)));
+
+    // only touched by the cpu thread, the buffer being drawn
+    int back;
+    // frames finished, and ones replaced before anything took them
+    uint64_t published;
+    uint64_t dropped;
+
+    // the buffer index of the newest finished frame, | FRAME_FRESH until it's taken
+    int ready __attribute__((aligned(64)));
+
+    // only touched by the presenter, the buffer being shown
+    int front __attribute__((aligned(64)));
+    // frames shown, and times there wasn't a new one so the last was shown again
+    uint64_t presented;
+    uint64_t duplicated;
+} TripleBuffer;
+
+/*
+ * Frames the ppu doesn't draw. The lcd still goes through every line, STAT and the
+ * interrupts are the same, only the pixels aren't worked out and nothing is published.
+ * skip of every frames are skipped, and with adaptive on any frame that starts while the
+ * presenter still hasn't taken the last one is too, it would only have been dropped.
+ */
+typedef struct {
+    uint8_t skip;
+    uint8_t every;
+    uint8_t adaptive;
+
+    // where in every the current frame is, and whether it's being skipped
+    uint8_t position;
+    uint8_t skipping;
+} FrameSkip;
+
+void    triple_buffer_init(TripleBuffer * t);
+// cpu thread, 1 if the last frame published hasn't been taken yet
+int     triple_buffer_waiting(TripleBuffer * t);
+
+// cpu thread, returns the buffer to draw the next frame into
+uint8_t (*triple_buffer_publish(TripleBuffer * t))[SCREEN_WIDTH];
+// presenter, the newest frame, the same as last time if there hasn't been one since
+const uint8_t (*triple_buffer_acquire(TripleBuffer * t))[SCREEN_WIDTH];
+
+#endif
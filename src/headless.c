@@ -0,0 +1,90 @@
+// headless.c
+#include <string.h>
+
+#include "headless.h"
+
+void headless_present(Headless * h, Proc * p) {
+    /* the same thread runs the cpu so there's a new frame every time, nothing gets dropped */
+    if (!h->callback) return;
+
+    h->callback(h->data, triple_buffer_acquire(&p->frames));
+    h->frames++;
+}
+
+void headless_file_sink(void * data, const uint8_t (*frame)[SCREEN_WIDTH]) {
+    /* a raw stream of frames, ffmpeg -f rawvideo -pixel_format gray -video_size 160x144 reads it */
+    static const uint8_t greys[4] = { 0xFF, 0xC0, 0x60, 0x00 };
+    uint8_t pixels[SCREEN_HEIGHT][SCREEN_WIDTH];
+
+    for (int y = 0; y < SCREEN_HEIGHT; y++) {
+        for (int x = 0; x < SCREEN_WIDTH; x++) {
+            pixels[y][x] = greys[frame[y][x] & 3];
+        }
+    }
+
+    fwrite(pixels, 1, sizeof(pixels), (FILE *) data);
+}
+
+/* ---------------------------------------------------------------------------------------
+ * wav
+ * --------------------------------------------------------------------------------------- */
+
+#define WAV_HEADER_SIZE 44
+
+static void put_le(uint8_t * to, uint32_t value, int bytes) {
+    for (int i = 0; i < bytes; i++) {
+        to[i] = value >> (8 * i);
+    }
+}
+
+static void wav_header(WavSink * w) {
+    uint32_t data_size = w->samples * sizeof(StereoSample);
+    uint8_t header[WAV_HEADER_SIZE];
+
+    memcpy(header, "RIFF", 4);
+    put_le(header + 4, 36 + data_size, 4);
+    memcpy(header + 8, "WAVEfmt ", 8);
+    put_le(header + 16, 16, 4);                                 // fmt size
+    put_le(header + 20, 1, 2);                                  // pcm
+    put_le(header + 22, 2, 2);                                  // channels
+    put_le(header + 24, w->rate, 4);
+    put_le(header + 28, w->rate * sizeof(StereoSample), 4);     // bytes per second
+    put_le(header + 32, sizeof(StereoSample), 2);               // bytes per sample
+    put_le(header + 34, 16, 2);                                 // bits
+    memcpy(header + 36, "data", 4);
+    put_le(header + 40, data_size, 4);
+
+    fseek(w->file, 0, SEEK_SET);
+    fwrite(header, 1, sizeof(header), w->file);
+}
+
+int headless_wav_open(WavSink * w, const char * path, uint32_t rate) {
+    w->file = fopen(path, "wb");
+    w->rate = rate;
+    w->samples = 0;
+    if (!w->file) return 0;
+
+    // the sizes are filled in by headless_wav_close
+    wav_header(w);
+    return 1;
+}
+
+void headless_wav_drain(WavSink * w, AudioRing * ring) {
+    StereoSample samples[1024];
+    uint32_t fill;
+
+    // only what's there, asking for more would count as an underrun
+    while ((fill = audio_ring_fill(ring)) > 0) {
+        uint32_t count = audio_ring_read(ring, samples, fill < 1024 ? fill : 1024);
+        // the file is little endian, like the hosts this runs on
+        fwrite(samples, sizeof(StereoSample), count, w->file);
+        w->samples += count;
+    }
+}
+
+void headless_wav_close(WavSink * w) {
+    if (!w->file) return;
+    wav_header(w);
+    fclose(w->file);
+    w->file = NULL;
+}
@@ -0,0 +1,44 @@
+#ifndef HEADLESS_H
+#define HEADLESS_H
+
+#include <stdio.h>
+#include <stdint.h>
+
+#include "proc.h"
+
+/*
+ * Running without a window. Nothing is drawn on screen, the frames the ppu finishes are
+ * handed to a callback instead (or nowhere at all), so this builds and runs without SDL.
+ */
+
+typedef void (*FrameCallback)(void * data, const uint8_t (*frame)[SCREEN_WIDTH]);
+
+typedef struct {
+    FrameCallback callback;
+    void * data;
+
+    // frames passed to the callback
+    uint64_t frames;
+} Headless;
+
+/* 16 bit stereo wav file, the samples come out of the apu's ring once a frame */
+typedef struct {
+    FILE * file;
+    uint32_t rate;
+    uint64_t samples;
+} WavSink;
+
+// takes the newest frame from Proc.frames and passes it to the callback, if there is one
+void headless_present(Headless * h, Proc * p);
+
+// callback writing each frame to the FILE in data as 160x144 8 bit grey, 0 black -> 255 white
+void headless_file_sink(void * data, const uint8_t (*frame)[SCREEN_WIDTH]);
+
+// 0 if the file couldn't be opened
+int  headless_wav_open(WavSink * w, const char * path, uint32_t rate);
+// writes everything waiting in ring
+void headless_wav_drain(WavSink * w, AudioRing * ring);
+// fills in the sizes in the header and closes it
+void headless_wav_close(WavSink * w);
+
+#endif
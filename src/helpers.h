@@ -11,12 +11,53 @@
 #define debug_print(fmt, ...) \
             do { if (DEBUG) fprintf(stderr, fmt, __VA_ARGS__); } while (0)
 
-int is_three_half_carry_add(uint8_t a, uint8_t b, uint8_t c);
-int is_half_carry_add(uint8_t a, uint8_t b);
-int is_half_carry_sub(uint8_t a, uint8_t b);
-int is_three_half_carry_sub(uint8_t a, uint8_t b, uint8_t c);
-uint16_t get_16bit_value(uint8_t upper, uint8_t lower);
-uint8_t get_upper_8bit_value(uint16_t value);
-uint8_t get_lower_8bit_value(uint16_t value);
-
-#endif
\ No newline at end of file
+/*
+ * These are called for nearly every instruction so they are inline here,
+ * helpers.c has the external definitions for when the compiler doesn't inline them.
+ */
+
+inline int is_three_half_carry_add(uint8_t a, uint8_t b, uint8_t c) {
+    uint8_t before = (a & 0xF0) + (b & 0xF0) + (c & 0xF0); // upper 4 bits
+
+    uint8_t after  = (a + b + c) & 0xF0;
+
+    return before != after;
+}
+
+inline int is_half_carry_add(uint8_t a, uint8_t b) {
+    uint8_t before = (a & 0xF0) + (b & 0xF0); // upper 4 bits
+
+    uint8_t after  = (a + b) & 0xF0;
+
+    return before != after;
+}
+
+inline int is_three_half_carry_sub(uint8_t a, uint8_t b, uint8_t c) {
+    /* borrow out of the lower 4 bits */
+    return (a & 0x0F) < (b & 0x0F) + (c & 0x0F);
+}
+
+inline int is_half_carry_sub(uint8_t a, uint8_t b) {
+    return (a & 0x0F) < (b & 0x0F);
+}
+
+inline uint16_t get_16bit_value(uint8_t upper, uint8_t lower) {
+    /*
+     * generate the 16bit value from the values in two registers from upper and lower
+     * if upper is FF and lower is 00, return value would be 0xFF00
+     */
+
+    return (upper << 8) | lower;
+}
+
+inline uint8_t get_upper_8bit_value(uint16_t value) {
+    /* returns the highest 8 bits from the 16 bit value */
+    return (value & 0xFF00) >> 8;
+}
+
+inline uint8_t get_lower_8bit_value(uint16_t value) {
+    /* returns the lowest 8 bits from a 16 bit value */
+    return value & 0xFF;
+}
+
+#endif
@@ -0,0 +1,107 @@
+// idle.c
+#include "idle.h"
+#include "proc.h"
+#include "memory.h"
+
+static int changes_by_itself(uint16_t address) {
+    // DIV and TIMA are worked out from the cycle count, everything else waits for an event
+    return address == IO_DIV || address == IO_TIMA;
+}
+
+static uint8_t pointer_read(uint8_t source) {
+    // the ALU ops and BIT use register 6 for (HL)
+    return source == 6 ? IDLE_READS_HL : 0;
+}
+
+uint8_t idle_loop_detect(Proc * p, const Block * b) {
+    /* returns the Block.idle flags for b, 0 if it isn't a loop that can be skipped */
+    uint8_t idle = IDLE_LOOP;
+    int a_loaded = 0;
+
+    uint16_t address = b->start;
+    for (int i = 0; i < b->count; i++) {
+        const MicroOp * op = &b->ops[i];
+        uint8_t opcode = read_byte(p, address);
+        uint16_t next = address + op->length;
+
+        // the last op has to be the jump back to the start
+        if (i == b->count - 1) {
+            uint16_t target;
+            switch (opcode) {
+            case 0x18: case 0x20: case 0x28: case 0x30: case 0x38:  // JR / JR cc
+                target = next + (int8_t) op->operand;
+                break;
+            case 0xC3: case 0xC2: case 0xCA: case 0xD2: case 0xDA:  // JP / JP cc
+                target = op->operand;
+                break;
+            default:
+                return 0;
+            }
+            return target == b->start ? idle : 0;
+        }
+
+        switch (opcode) {
+        case 0x00:  // NOP
+            break;
+
+        // A loaded from somewhere that doesn't change while going round
+        case 0x0A: idle |= IDLE_READS_BC; a_loaded = 1; break;     // LD A,(BC)
+        case 0x1A: idle |= IDLE_READS_DE; a_loaded = 1; break;     // LD A,(DE)
+        case 0x7E: idle |= IDLE_READS_HL; a_loaded = 1; break;     // LD A,(HL)
+        case 0xF2: idle |= IDLE_READS_C;  a_loaded = 1; break;     // LD A,(C)
+        case 0xF0:                                                  // LDH A,(a8)
+            if (changes_by_itself(0xFF00 + (uint8_t) op->operand)) return 0;
+            a_loaded = 1;
+            break;
+        case 0xFA:                                                  // LD A,(a16)
+            if (changes_by_itself(op->operand)) return 0;
+            a_loaded = 1;
+            break;
+        case 0x3E:                                                  // LD A,d8
+        case 0x78: case 0x79: case 0x7A: case 0x7B: case 0x7C: case 0x7D:  // LD A,r
+            a_loaded = 1;
+            break;
+
+        // only change A, which is the same every time round once it's been loaded
+        case 0x3C: case 0x3D: case 0x2F:                            // INC A / DEC A / CPL
+        case 0xC6: case 0xD6: case 0xE6: case 0xEE: case 0xF6:      // ADD / SUB / AND / XOR / OR d8
+            if (!a_loaded) return 0;
+            break;
+        case 0xFE:                                                  // CP d8
+            break;
+
+        case 0xCB:
+            // BIT n,r, the other cb ops write their register
+            if ((uint8_t) op->operand < 0x40 || (uint8_t) op->operand >= 0x80) return 0;
+            idle |= pointer_read(op->operand & 7);
+            break;
+
+        default:
+            if (opcode >= 0x80 && opcode < 0xC0) {
+                // ALU A,r but not ADC / SBC which would carry into the next time round
+                uint8_t alu = (opcode >> 3) & 7;
+                if (alu == 1 || alu == 3) return 0;
+                if (alu != 7 && !a_loaded) return 0;
+                idle |= pointer_read(opcode & 7);
+                break;
+            }
+            return 0;
+        }
+
+        address = next;
+    }
+
+    // ran out of ops without a jump
+    return 0;
+}
+
+int idle_loop_reads_fixed(Proc * p, uint8_t idle) {
+    /* the pointers the loop reads through aren't known until it runs, they can't point at
+     * something that changes without an event either
+     */
+    if ((idle & IDLE_READS_BC) && changes_by_itself(p->registers.bc)) return 0;
+    if ((idle & IDLE_READS_DE) && changes_by_itself(p->registers.de)) return 0;
+    if ((idle & IDLE_READS_HL) && changes_by_itself(p->registers.hl)) return 0;
+    if ((idle & IDLE_READS_C) && changes_by_itself(0xFF00 + p->registers.c)) return 0;
+    return 1;
+}
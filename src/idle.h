@@ -0,0 +1,33 @@
+#ifndef IDLE_H
+#define IDLE_H
+
+#include <stdint.h>
+
+#include "block.h"
+
+/*
+ * Spots blocks that are busy-wait loops, e.g. polling LY or a flag an interrupt handler sets:
+ *
+ *     loop: LDH A,(44)
+ *           CP 90
+ *           JR NZ,loop
+ *
+ * The block has to jump back to its own start and only read memory and write A / F, with
+ * A loaded before anything changes it. Then once it has gone round once every other time
+ * round does exactly the same thing until memory changes, which only happens at the next
+ * event, so the cpu can skip whole iterations up to it.
+ */
+
+// Block.idle, IDLE_LOOP is set for a loop, the others are pointers it reads through
+#define IDLE_LOOP      0x01
+#define IDLE_READS_BC  0x02
+#define IDLE_READS_DE  0x04
+#define IDLE_READS_HL  0x08
+#define IDLE_READS_C   0x10
+
+struct Proc;
+
+uint8_t idle_loop_detect(struct Proc * p, const Block * b);
+int     idle_loop_reads_fixed(struct Proc * p, uint8_t idle);
+
+#endif
@@ -0,0 +1,342 @@
+// io.c
+#include "io.h"
+#include "proc.h"
+#include "ppu.h"
+#include "memory.h"
+
+/* lcd modes, the lower 2 bits of STAT */
+#define MODE_HBLANK   0
+#define MODE_VBLANK   1
+#define MODE_OAM      2
+#define MODE_TRANSFER 3
+
+/* STAT bits that raise the lcd interrupt */
+#define STAT_COINCIDENCE      0x04
+#define STAT_HBLANK_INT       0x08
+#define STAT_VBLANK_INT       0x10
+#define STAT_OAM_INT          0x20
+#define STAT_COINCIDENCE_INT  0x40
+
+// TIMA counts on bit 9 / 3 / 5 / 7 of the divider falling, so every 1024 / 16 / 64 / 256 cycles
+static const int timer_shift[4] = { 10, 4, 6, 8 };
+
+static void schedule(Proc * p, EventType type, uint64_t time) {
+    /* events scheduled while the cpu is running can be sooner than where it was going to stop */
+    scheduler_schedule(&p->scheduler, type, time);
+    if (time < p->deadline) p->deadline = time;
+}
+
+void io_request_interrupt(Proc * p, uint8_t interrupt) {
+    p->memory[IO_IF] |= interrupt;
+    // stop at the end of the current instruction so it gets serviced
+    p->deadline = p->cycles;
+}
+
+/* ---------------------------------------------------------------------------------------
+ * timer
+ * --------------------------------------------------------------------------------------- */
+
+static void timer_sync(Proc * p) {
+    /* brings TIMA up to the current cycle, reloading from TMA each time it overflows */
+    uint8_t tac = p->memory[IO_TAC];
+
+    if (tac & 0x04) {
+        int shift = timer_shift[tac & 3];
+        uint64_t ticks = ((p->cycles - p->io.div_base) >> shift) - ((p->io.tima_sync - p->io.div_base) >> shift);
+        uint64_t tima = p->memory[IO_TIMA] + ticks;
+
+        while (tima > 0xFF) {
+            tima = tima - 0x100 + p->memory[IO_TMA];
+            io_request_interrupt(p, INT_TIMER);
+        }
+        p->memory[IO_TIMA] = tima;
+    }
+
+    p->io.tima_sync = p->cycles;
+}
+
+static void timer_schedule(Proc * p) {
+    /* the next overflow, TIMA has to be in sync */
+    uint8_t tac = p->memory[IO_TAC];
+
+    if (!(tac & 0x04)) {
+        scheduler_cancel(&p->scheduler, EVENT_TIMER);
+        return;
+    }
+
+    int shift = timer_shift[tac & 3];
+    uint64_t tick = ((p->cycles - p->io.div_base) >> shift) + (0x100 - p->memory[IO_TIMA]);
+    schedule(p, EVENT_TIMER, p->io.div_base + (tick << shift));
+}
+
+/* ---------------------------------------------------------------------------------------
+ * lcd timing, LY, STAT and the interrupts, ppu.c draws the lines
+ * --------------------------------------------------------------------------------------- */
+
+static void lcd_set_mode(Proc * p, uint8_t mode) {
+    p->memory[IO_STAT] = (p->memory[IO_STAT] & ~0x03) | mode;
+
+    static const uint8_t mode_interrupts[4] = { STAT_HBLANK_INT, STAT_VBLANK_INT, STAT_OAM_INT, 0 };
+    if (p->memory[IO_STAT] & mode_interrupts[mode]) {
+        io_request_interrupt(p, INT_LCD_STAT);
+    }
+}
+
+static void lcd_compare(Proc * p) {
+    if (p->memory[IO_LY] == p->memory[IO_LYC]) {
+        p->memory[IO_STAT] |= STAT_COINCIDENCE;
+        if (p->memory[IO_STAT] & STAT_COINCIDENCE_INT) {
+            io_request_interrupt(p, INT_LCD_STAT);
+        }
+    } else {
+        p->memory[IO_STAT] &= ~STAT_COINCIDENCE;
+    }
+}
+
+static void lcd_start(Proc * p, uint64_t time) {
+    ppu_start_frame(p);
+    p->memory[IO_LY] = 0;
+    lcd_compare(p);
+    lcd_set_mode(p, MODE_OAM);
+    schedule(p, EVENT_LCD, time + OAM_CYCLES);
+}
+
+static void lcd_event(Proc * p, uint64_t time) {
+    /* moves on to the next mode, times are from when the event was due rather than
+     * p->cycles so the lcd doesn't drift when an instruction runs over
+     */
+    switch (p->memory[IO_STAT] & 0x03) {
+    case MODE_OAM:
+        lcd_set_mode(p, MODE_TRANSFER);
+        schedule(p, EVENT_LCD, time + TRANSFER_CYCLES);
+        break;
+    case MODE_TRANSFER:
+        ppu_render_line(p);
+        lcd_set_mode(p, MODE_HBLANK);
+        schedule(p, EVENT_LCD, time + LINE_CYCLES - OAM_CYCLES - TRANSFER_CYCLES);
+        break;
+    case MODE_HBLANK:
+        p->memory[IO_LY]++;
+        lcd_compare(p);
+        if (p->memory[IO_LY] == VBLANK_LINE) {
+            lcd_set_mode(p, MODE_VBLANK);
+            io_request_interrupt(p, INT_VBLANK);
+            ppu_end_frame(p);
+            p->stats.frames++;
+            schedule(p, EVENT_LCD, time + LINE_CYCLES);
+        } else {
+            lcd_set_mode(p, MODE_OAM);
+            schedule(p, EVENT_LCD, time + OAM_CYCLES);
+        }
+        break;
+    case MODE_VBLANK:
+        if (p->memory[IO_LY] + 1 == NUM_LINES) {
+            lcd_start(p, time);
+        } else {
+            p->memory[IO_LY]++;
+            lcd_compare(p);
+            schedule(p, EVENT_LCD, time + LINE_CYCLES);
+        }
+        break;
+    }
+}
+
+static void lcd_write_lcdc(Proc * p, uint8_t value) {
+    uint8_t was_on = p->memory[IO_LCDC] & 0x80;
+    p->memory[IO_LCDC] = value;
+
+    if ((value & 0x80) && !was_on) {
+        lcd_start(p, p->cycles);
+    } else if (!(value & 0x80) && was_on) {
+        // LY stays at 0 and the lcd sits in hblank while it's off
+        scheduler_cancel(&p->scheduler, EVENT_LCD);
+        p->memory[IO_LY] = 0;
+        p->memory[IO_STAT] &= ~0x03;
+    }
+}
+
+/* ---------------------------------------------------------------------------------------
+ * serial and joypad
+ * --------------------------------------------------------------------------------------- */
+
+static void serial_event(Proc * p) {
+    /* nothing on the other end of the cable, the byte shifted in is all 1s */
+    debug_print("serial: %02X\n", p->memory[IO_SB]);
+
+    p->memory[IO_SB] = 0xFF;
+    p->memory[IO_SC] &= ~0x80;
+    io_request_interrupt(p, INT_SERIAL);
+}
+
+static uint8_t joypad_read(Proc * p) {
+    /* bit 4 low selects the directions, bit 5 low the buttons, pressed reads as 0 */
+    uint8_t select = p->memory[IO_JOYP] & 0x30;
+    uint8_t pressed = 0;
+
+    if (!(select & 0x10)) pressed |= p->io.buttons & 0x0F;
+    if (!(select & 0x20)) pressed |= p->io.buttons >> 4;
+
+    return 0xC0 | select | (~pressed & 0x0F);
+}
+
+static void joypad_event(Proc * p) {
+    // any button going down raises the interrupt and ends STOP
+    if (p->io.new_buttons & ~p->io.buttons) {
+        io_request_interrupt(p, INT_JOYPAD);
+        p->stopped = 0;
+    }
+    p->io.buttons = p->io.new_buttons;
+}
+
+void io_set_buttons(Proc * p, uint8_t buttons) {
+    /* called by the frontend, posted as an event at the current cycle */
+    p->io.new_buttons = buttons;
+    schedule(p, EVENT_JOYPAD, p->cycles);
+}
+
+/* ---------------------------------------------------------------------------------------
+ * oam dma
+ * --------------------------------------------------------------------------------------- */
+
+static void dma_start(Proc * p, uint8_t value) {
+    /* copies 160 bytes from value * 0x100 into oam, all at once rather than over the 160
+     * cycles it takes on the real thing. Through the bus so it sees the banks the cart has in
+     */
+    uint16_t source = value << 8;
+    for (uint16_t i = 0; i < MAX_SPRITES * 4; i++) {
+        write_byte(p, OAM_START + i, read_byte(p, source + i));
+    }
+}
+
+/* ---------------------------------------------------------------------------------------
+ * registers
+ * --------------------------------------------------------------------------------------- */
+
+void io_init(Proc * p) {
+    scheduler_init(&p->scheduler);
+
+    p->io.div_base = p->cycles;
+    p->io.tima_sync = p->cycles;
+
+    // proc_initialize_memory set these straight into memory
+    for (uint16_t address = IO_BGP; address <= IO_OBP1; address++) {
+        ppu_write_palette(p, address, p->memory[address]);
+    }
+
+    if (p->memory[IO_LCDC] & 0x80) {
+        lcd_start(p, p->cycles);
+    }
+
+    apu_init(p);
+    schedule(p, EVENT_APU, p->cycles + APU_STEP_CYCLES);
+}
+
+uint8_t io_read(Proc * p, uint16_t address) {
+    switch (address) {
+    case IO_JOYP:
+        return joypad_read(p);
+    case IO_DIV:
+        return (p->cycles - p->io.div_base) >> 8;
+    case IO_TIMA:
+        timer_sync(p);
+        return p->memory[IO_TIMA];
+    case IO_IF:
+        // the unused upper bits read as 1
+        return p->memory[IO_IF] | 0xE0;
+    default:
+        if (address >= APU_START && address <= APU_END) return apu_read(p, address);
+        return p->memory[address];
+    }
+}
+
+void io_write(Proc * p, uint16_t address, uint8_t value) {
+    switch (address) {
+    case IO_JOYP:
+        // only the select bits can be written
+        p->memory[IO_JOYP] = value & 0x30;
+        break;
+    case IO_SC:
+        p->memory[IO_SC] = value;
+        // a transfer on the internal clock, nobody drives the external one
+        if ((value & 0x81) == 0x81) {
+            schedule(p, EVENT_SERIAL, p->cycles + SERIAL_CYCLES);
+        }
+        break;
+    case IO_DIV:
+        // any write resets the whole divider, which moves when TIMA next counts
+        timer_sync(p);
+        p->io.div_base = p->cycles;
+        timer_schedule(p);
+        break;
+    case IO_TIMA:
+    case IO_TAC:
+        timer_sync(p);
+        p->memory[address] = value;
+        timer_schedule(p);
+        break;
+    case IO_IF:
+    case IO_IE:
+        p->memory[address] = value;
+        // might have just made an interrupt pending
+        p->deadline = p->cycles;
+        break;
+    case IO_LCDC:
+        lcd_write_lcdc(p, value);
+        break;
+    case IO_STAT:
+        // mode and coincidence bits are read only
+        p->memory[IO_STAT] = (value & 0x78) | (p->memory[IO_STAT] & 0x07);
+        break;
+    case IO_LY:
+        // read only
+        break;
+    case IO_BGP:
+    case IO_OBP0:
+    case IO_OBP1:
+        ppu_write_palette(p, address, value);
+        break;
+    case IO_DMA:
+        p->memory[IO_DMA] = value;
+        dma_start(p, value);
+        break;
+    case IO_LYC:
+        p->memory[IO_LYC] = value;
+        if (p->memory[IO_LCDC] & 0x80) lcd_compare(p);
+        break;
+    default:
+        if (address >= APU_START && address <= APU_END) {
+            apu_write(p, address, value);
+            break;
+        }
+        p->memory[address] = value;
+        break;
+    }
+}
+
+void io_run_events(Proc * p) {
+    /* runs every event that's due by now */
+    uint64_t time;
+    int type;
+
+    while ((type = scheduler_pop(&p->scheduler, p->cycles, &time)) >= 0) {
+        switch (type) {
+        case EVENT_LCD:
+            lcd_event(p, time);
+            break;
+        case EVENT_TIMER:
+            timer_sync(p);
+            timer_schedule(p);
+            break;
+        case EVENT_SERIAL:
+            serial_event(p);
+            break;
+        case EVENT_JOYPAD:
+            joypad_event(p);
+            break;
+        case EVENT_APU:
+            apu_step(p, time);
+            schedule(p, EVENT_APU, time + APU_STEP_CYCLES);
+            break;
+        }
+    }
+}
@@ -0,0 +1,75 @@
+#ifndef IO_H
+#define IO_H
+
+#include <stdint.h>
+
+/*
+ * The io registers (0xFF00 -> 0xFF7F) and IE. The timer, lcd, serial port and joypad each
+ * post events to the scheduler in Proc rather than being stepped after every instruction,
+ * DIV and TIMA are worked out from the cycle count when they're read.
+ */
+
+#define IO_JOYP 0xFF00
+#define IO_SB   0xFF01
+#define IO_SC   0xFF02
+#define IO_DIV  0xFF04
+#define IO_TIMA 0xFF05
+#define IO_TMA  0xFF06
+#define IO_TAC  0xFF07
+#define IO_IF   0xFF0F
+#define IO_LCDC 0xFF40
+#define IO_STAT 0xFF41
+#define IO_LY   0xFF44
+#define IO_LYC  0xFF45
+#define IO_DMA  0xFF46
+#define IO_IE   0xFFFF
+
+/* bits of IF and IE, lowest bit has the highest priority */
+#define INT_VBLANK   0x01
+#define INT_LCD_STAT 0x02
+#define INT_TIMER    0x04
+#define INT_SERIAL   0x08
+#define INT_JOYPAD   0x10
+
+/* buttons for io_set_buttons, set when held down */
+#define BUTTON_RIGHT  0x01
+#define BUTTON_LEFT   0x02
+#define BUTTON_UP     0x04
+#define BUTTON_DOWN   0x08
+#define BUTTON_A      0x10
+#define BUTTON_B      0x20
+#define BUTTON_SELECT 0x40
+#define BUTTON_START  0x80
+
+// lcd timing for each of the 154 lines, mode 2 (oam) -> 3 (transfer) -> 0 (hblank)
+#define LINE_CYCLES 456
+#define OAM_CYCLES 80
+#define TRANSFER_CYCLES 172
+#define VBLANK_LINE 144
+#define NUM_LINES 154
+
+// one byte at 8192 Hz
+#define SERIAL_CYCLES 4096
+
+struct Proc;
+
+typedef struct {
+    // cycle the 16 bit divider was last 0, DIV is its upper byte
+    uint64_t div_base;
+    // TIMA is brought up to date when it's needed, this is when it last was
+    uint64_t tima_sync;
+
+    uint8_t buttons;
+    // set by io_set_buttons, the joypad event applies them
+    uint8_t new_buttons;
+} IoState;
+
+void    io_init(struct Proc * p);
+uint8_t io_read(struct Proc * p, uint16_t address);
+void    io_write(struct Proc * p, uint16_t address, uint8_t value);
+void    io_run_events(struct Proc * p);
+
+void    io_request_interrupt(struct Proc * p, uint8_t interrupt);
+void    io_set_buttons(struct Proc * p, uint8_t buttons);
+
+#endif
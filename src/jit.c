@@ -0,0 +1,612 @@
+// jit.c
+// needed for MAP_ANONYMOUS with -std=c99
+#define _DEFAULT_SOURCE
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "jit.h"
+#include "proc.h"
+#include "memory.h"
+#include "opcodes.h"
+
+#if JIT_SUPPORTED
+
+#include <sys/mman.h>
+
+/* x86-64 register numbers */
+#define RAX 0
+#define RCX 1
+#define RBX 3
+#define RSI 6
+#define RDI 7
+#define R8  8
+#define R9  9
+#define R10 10
+#define R11 11
+#define R12 12
+#define R13 13
+
+/* indexes into the tables below, same order as the fields of Registers */
+#define REG_A 0
+#define REG_B 1
+#define REG_C 2
+#define REG_D 3
+#define REG_E 4
+#define REG_F 5
+#define REG_H 6
+#define REG_L 7
+
+#define ALL_FLAGS (FLAG_ZERO | FLAG_SUBTRACT | FLAG_HALF_CARRY | FLAG_CARRY)
+
+/*
+ * Where each gameboy register lives while a block runs. p is kept in rbx and rax/rcx are
+ * scratch, the rest are caller saved except r12/r13 so the prologue only has to save three.
+ */
+static const int host_reg[8] = { RSI, RDI, R8, R9, R10, R11, R12, R13 };
+
+static const int reg_offset[8] = {
+    offsetof(Registers, a), offsetof(Registers, b), offsetof(Registers, c), offsetof(Registers, d),
+    offsetof(Registers, e), offsetof(Registers, f), offsetof(Registers, h), offsetof(Registers, l),
+};
+
+static const int pair_offset[4] = {
+    offsetof(Registers, af), offsetof(Registers, bc), offsetof(Registers, de), offsetof(Registers, hl),
+};
+
+#define REG_DISP(r) ((int32_t) (offsetof(Proc, registers) + reg_offset[r]))
+
+/* the opcode's register order B C D E H L (HL) A, -1 for (HL) */
+static const int reg_index[8] = { REG_B, REG_C, REG_D, REG_E, REG_H, REG_L, -1, REG_A };
+
+/* BC DE HL, upper then lower */
+static const int pair_index[3][2] = { { REG_B, REG_C }, { REG_D, REG_E }, { REG_H, REG_L } };
+
+/* ADD ADC SUB SBC AND XOR OR CP, in the order of the 0x80 -> 0xBF rows */
+typedef struct {
+    uint8_t opcode;     // <op> r/m8, r8
+    uint8_t ext;        // 0x80 /ext ib
+    uint8_t from_host;  // flags that come straight out of the x86 flags
+    uint8_t set;        // flags that are always set
+    uint8_t carry_in;
+} AluOp;
+
+static const AluOp alu_ops[8] = {
+    { 0x00, 0, FLAG_ZERO | FLAG_HALF_CARRY | FLAG_CARRY, 0,               0 },
+    { 0x10, 2, FLAG_ZERO | FLAG_HALF_CARRY | FLAG_CARRY, 0,               1 },
+    { 0x28, 5, FLAG_ZERO | FLAG_HALF_CARRY | FLAG_CARRY, FLAG_SUBTRACT,   0 },
+    { 0x18, 3, FLAG_ZERO | FLAG_HALF_CARRY | FLAG_CARRY, FLAG_SUBTRACT,   1 },
+    { 0x20, 4, FLAG_ZERO,                                FLAG_HALF_CARRY, 0 },
+    { 0x30, 6, FLAG_ZERO,                                0,               0 },
+    { 0x08, 1, FLAG_ZERO,                                0,               0 },
+    { 0x38, 7, FLAG_ZERO | FLAG_HALF_CARRY | FLAG_CARRY, FLAG_SUBTRACT,   0 },
+};
+
+/* ---------------------------------------------------------------------------------------
+ * x86 encoding
+ * --------------------------------------------------------------------------------------- */
+
+typedef struct {
+    uint8_t * out;
+} Emitter;
+
+static void emit8(Emitter * e, uint8_t byte) {
+    *e->out++ = byte;
+}
+
+static void emit32(Emitter * e, uint32_t value) {
+    memcpy(e->out, &value, 4);
+    e->out += 4;
+}
+
+static void emit64(Emitter * e, uint64_t value) {
+    memcpy(e->out, &value, 8);
+    e->out += 8;
+}
+
+static void emit_rex(Emitter * e, int w, int reg, int rm) {
+    // always emitted for byte registers, without it 6 and 7 are dh/bh instead of sil/dil
+    emit8(e, 0x40 | (w << 3) | ((reg >> 3) << 2) | (rm >> 3));
+}
+
+static void emit_modrm(Emitter * e, int mod, int reg, int rm) {
+    emit8(e, (mod << 6) | ((reg & 7) << 3) | (rm & 7));
+}
+
+/* <op> dst8, src8 (mov is 0x88, the alu ops are 0x00 -> 0x38) */
+static void emit_rr(Emitter * e, uint8_t opcode, int dst, int src) {
+    emit_rex(e, 0, src, dst);
+    emit8(e, opcode);
+    emit_modrm(e, 3, src, dst);
+}
+
+/* <op> dst8, imm8 for the alu ops */
+static void emit_ri(Emitter * e, int ext, int dst, uint8_t imm) {
+    emit_rex(e, 0, 0, dst);
+    emit8(e, 0x80);
+    emit_modrm(e, 3, ext, dst);
+    emit8(e, imm);
+}
+
+static void emit_mov_ri(Emitter * e, int dst, uint8_t imm) {
+    emit_rex(e, 0, 0, dst);
+    emit8(e, 0xB0 + (dst & 7));
+    emit8(e, imm);
+}
+
+/* FE /0 inc, FE /1 dec, F6 /2 not */
+static void emit_unary(Emitter * e, uint8_t opcode, int ext, int dst) {
+    emit_rex(e, 0, 0, dst);
+    emit8(e, opcode);
+    emit_modrm(e, 3, ext, dst);
+}
+
+static void emit_mov_imm64(Emitter * e, int dst, uint64_t imm) {
+    emit_rex(e, 1, 0, dst);
+    emit8(e, 0xB8 + (dst & 7));
+    emit64(e, imm);
+}
+
+/* mov dst8, byte [rbx + disp] */
+static void emit_load(Emitter * e, int dst, int32_t disp) {
+    emit_rex(e, 0, dst, RBX);
+    emit8(e, 0x8A);
+    emit_modrm(e, 2, dst, RBX);
+    emit32(e, disp);
+}
+
+static void emit_store_pc(Emitter * e, uint16_t pc) {
+    // mov word [rbx + pc], imm16
+    emit8(e, 0x66);
+    emit8(e, 0xC7);
+    emit_modrm(e, 2, 0, RBX);
+    emit32(e, offsetof(Proc, pc));
+    emit8(e, pc & 0xFF);
+    emit8(e, pc >> 8);
+}
+
+static void emit_add_cycles(Emitter * e, uint32_t cycles) {
+    // add qword [rbx + cycles], imm32
+    emit_rex(e, 1, 0, RBX);
+    emit8(e, 0x81);
+    emit_modrm(e, 2, 0, RBX);
+    emit32(e, offsetof(Proc, cycles));
+    emit32(e, cycles);
+}
+
+static void emit_store_regs(Emitter * e, uint8_t regs) {
+    /* the handlers read the pairs as 16 bit values, which stall if they were just written
+     * as two bytes, so a pair with either half changed is put back together and stored whole
+     */
+    static const int pairs[4][2] = { { REG_A, REG_F }, { REG_B, REG_C }, { REG_D, REG_E }, { REG_H, REG_L } };
+
+    for (int i = 0; i < 4; i++) {
+        int upper = pairs[i][0], lower = pairs[i][1];
+        if (!(regs & ((1 << upper) | (1 << lower)))) continue;
+
+        // movzx eax, upper / shl eax, 8 / mov al, lower
+        emit_rex(e, 0, RAX, host_reg[upper]);
+        emit8(e, 0x0F); emit8(e, 0xB6);
+        emit_modrm(e, 3, RAX, host_reg[upper]);
+        emit8(e, 0xC1); emit8(e, 0xE0); emit8(e, 0x08);
+        emit_rr(e, 0x88, RAX, host_reg[lower]);
+
+        // mov word [rbx + pair], ax
+        emit8(e, 0x66);
+        emit8(e, 0x89);
+        emit_modrm(e, 2, RAX, RBX);
+        emit32(e, offsetof(Proc, registers) + pair_offset[i]);
+    }
+}
+
+static void emit_load_regs(Emitter * e) {
+    for (int r = 0; r < 8; r++) {
+        emit_load(e, host_reg[r], REG_DISP(r));
+    }
+}
+
+static void emit_flags(Emitter * e, uint8_t from_host, uint8_t set, uint8_t keep) {
+    /* turns the x86 flags from the last op into Z N H C in F, ZF is bit 6, AF (the half
+     * carry out of bit 3) is bit 4 and CF is bit 0 of rflags
+     */
+    int f = host_reg[REG_F];
+
+    emit8(e, 0x9C);                                         // pushfq
+    emit8(e, 0x58);                                         // pop rax
+    if (from_host & FLAG_CARRY) {
+        emit8(e, 0x89); emit8(e, 0xC1);                     // mov ecx, eax
+        emit8(e, 0x83); emit8(e, 0xE1); emit8(e, 0x01);     // and ecx, 1
+        emit8(e, 0xC1); emit8(e, 0xE1); emit8(e, 0x04);     // shl ecx, 4
+    }
+    emit8(e, 0x83); emit8(e, 0xE0); emit8(e, 0x50);         // and eax, 0x50
+    emit8(e, 0xD1); emit8(e, 0xE0);                         // shl eax, 1
+    if (from_host & FLAG_CARRY) {
+        emit8(e, 0x09); emit8(e, 0xC8);                     // or eax, ecx
+    }
+    emit8(e, 0x25); emit32(e, from_host);                   // and eax, from_host
+    if (set) {
+        emit8(e, 0x0D); emit32(e, set);                     // or eax, set
+    }
+
+    if (keep) {
+        emit_ri(e, 4, f, keep);
+        emit_rr(e, 0x08, f, RAX);
+    } else {
+        emit_rr(e, 0x88, f, RAX);
+    }
+}
+
+/* ---------------------------------------------------------------------------------------
+ * compiling a block
+ * --------------------------------------------------------------------------------------- */
+
+static int is_native(uint8_t opcode) {
+    /* ops that get emitted inline, everything else calls the handler */
+    int x = opcode >> 6, y = (opcode >> 3) & 7, z = opcode & 7;
+
+    switch (x) {
+    case 0:
+        // NOP, JR, CPL, SCF, CCF
+        if (opcode == 0x00 || opcode == 0x18 || opcode == 0x2F || opcode == 0x37 || opcode == 0x3F) return 1;
+        // LD rr,d16 / INC rr / DEC rr, not SP
+        if (z == 1 && !(y & 1)) return y != 6;
+        if (z == 3) return y < 6;
+        // INC r / DEC r / LD r,d8, not (HL)
+        if (z >= 4 && z <= 6) return y != 6;
+        return 0;
+    case 1:
+        // LD r,r', not (HL) or HALT
+        return y != 6 && z != 6;
+    case 2:
+        return z != 6;
+    default:
+        // ALU A,d8 and JP a16
+        return z == 6 || opcode == 0xC3;
+    }
+}
+
+static int is_io(uint8_t opcode, uint16_t operand) {
+    // LDH (a8),A / LDH A,(a8) / LD (C),A / LD A,(C) / LD (a16),A / LD A,(a16) up in io
+    switch (opcode) {
+    case 0xE0: case 0xF0: case 0xE2: case 0xF2:
+        return 1;
+    case 0xEA: case 0xFA:
+        return operand >= 0xFF00;
+    default:
+        return 0;
+    }
+}
+
+static uint8_t flags_read(uint8_t opcode) {
+    // ADC / SBC / CCF are the only inline ops that use a flag
+    if ((opcode & 0xF8) == 0x88 || (opcode & 0xF8) == 0x98 || opcode == 0xCE || opcode == 0xDE || opcode == 0x3F) {
+        return FLAG_CARRY;
+    }
+    return 0;
+}
+
+static void emit_alu(Emitter * e, const AluOp * alu, int src, uint16_t operand, uint8_t flags, uint8_t * dirty) {
+    /* src is a host register or -1 for the immediate */
+    int a = host_reg[REG_A];
+
+    if (alu->carry_in) {
+        // bt r11d, 4 puts the gameboy carry into CF
+        emit_rex(e, 0, 0, host_reg[REG_F]);
+        emit8(e, 0x0F); emit8(e, 0xBA);
+        emit_modrm(e, 3, 4, host_reg[REG_F]);
+        emit8(e, 4);
+    }
+
+    if (src < 0) {
+        emit_ri(e, alu->ext, a, (uint8_t) operand);
+    } else {
+        emit_rr(e, alu->opcode, a, src);
+    }
+
+    // CP only sets flags
+    if (alu->opcode != 0x38) *dirty |= 1 << REG_A;
+
+    if (flags) {
+        emit_flags(e, alu->from_host, alu->set, 0);
+        *dirty |= 1 << REG_F;
+    }
+}
+
+static void emit_native(Emitter * e, uint8_t opcode, uint16_t operand, uint8_t flags, uint8_t * dirty) {
+    /* flags is which of the flags the op writes are used before being written again,
+     * when none are the flags aren't worked out at all
+     */
+    int x = opcode >> 6, y = (opcode >> 3) & 7, z = opcode & 7;
+    int f = host_reg[REG_F];
+
+    switch (opcode) {
+    case 0x00: // NOP
+    case 0x18: // JR, the jumps only change where the block exits to
+    case 0xC3: // JP
+        return;
+    case 0x2F: // CPL - 1 1 -
+        emit_unary(e, 0xF6, 2, host_reg[REG_A]);
+        *dirty |= 1 << REG_A;
+        if (flags) {
+            emit_ri(e, 1, f, FLAG_SUBTRACT | FLAG_HALF_CARRY);
+            *dirty |= 1 << REG_F;
+        }
+        return;
+    case 0x37: // SCF - 0 0 1
+        if (flags) {
+            emit_ri(e, 4, f, FLAG_ZERO);
+            emit_ri(e, 1, f, FLAG_CARRY);
+            *dirty |= 1 << REG_F;
+        }
+        return;
+    case 0x3F: // CCF - 0 0 C
+        if (flags) {
+            emit_ri(e, 4, f, FLAG_ZERO | FLAG_CARRY);
+            emit_ri(e, 6, f, FLAG_CARRY);
+            *dirty |= 1 << REG_F;
+        }
+        return;
+    }
+
+    if (x == 0) {
+        if (z == 1) {
+            // LD rr,d16
+            const int * pair = pair_index[y >> 1];
+            emit_mov_ri(e, host_reg[pair[0]], operand >> 8);
+            emit_mov_ri(e, host_reg[pair[1]], operand & 0xFF);
+            *dirty |= (1 << pair[0]) | (1 << pair[1]);
+        } else if (z == 3) {
+            // INC rr / DEC rr, no flags so just carry into the upper register
+            const int * pair = pair_index[y >> 1];
+            emit_ri(e, (y & 1) ? 5 : 0, host_reg[pair[1]], 1);
+            emit_ri(e, (y & 1) ? 3 : 2, host_reg[pair[0]], 0);
+            *dirty |= (1 << pair[0]) | (1 << pair[1]);
+        } else if (z == 4 || z == 5) {
+            // INC r (Z 0 H -) / DEC r (Z 1 H -)
+            int r = reg_index[y];
+            emit_unary(e, 0xFE, z == 5, host_reg[r]);
+            *dirty |= 1 << r;
+            if (flags) {
+                emit_flags(e, FLAG_ZERO | FLAG_HALF_CARRY, z == 5 ? FLAG_SUBTRACT : 0, FLAG_CARRY);
+                *dirty |= 1 << REG_F;
+            }
+        } else {
+            // LD r,d8
+            int r = reg_index[y];
+            emit_mov_ri(e, host_reg[r], (uint8_t) operand);
+            *dirty |= 1 << r;
+        }
+    } else if (x == 1) {
+        // LD r,r'
+        int dst = reg_index[y];
+        emit_rr(e, 0x88, host_reg[dst], host_reg[reg_index[z]]);
+        *dirty |= 1 << dst;
+    } else if (x == 2) {
+        emit_alu(e, &alu_ops[y], host_reg[reg_index[z]], operand, flags, dirty);
+    } else {
+        emit_alu(e, &alu_ops[y], -1, operand, flags, dirty);
+    }
+}
+
+static int writes_flags(uint8_t opcode) {
+    /* the handlers of ops that write flags may leave them pending in p->lazy, the rest
+     * can skip working them out afterwards
+     */
+    return opcode == 0xCB || opcode_info[opcode].flags;
+}
+
+static void jit_call_handler(Proc * p, const MicroOp * op) {
+    /* called from native code for every op that isn't inline, native code works on F
+     * directly so the flags the handler left pending are worked out straight away
+     */
+    p->cycles += op->handler(p, op->operand) ? op->cycles_taken : op->cycles;
+    proc_get_f(p);
+}
+
+static void jit_call_handler_no_flags(Proc * p, const MicroOp * op) {
+    p->cycles += op->handler(p, op->operand) ? op->cycles_taken : op->cycles;
+}
+
+Jit * jit_create() {
+    Jit * j = calloc(1, sizeof(Jit));
+    if (!j) return NULL;
+
+    j->code = mmap(NULL, JIT_CODE_SIZE, PROT_READ | PROT_WRITE | PROT_EXEC, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (j->code == MAP_FAILED) {
+        // no writable+executable memory here, stay with the interpreter
+        free(j);
+        return NULL;
+    }
+
+    j->threshold = JIT_THRESHOLD;
+    return j;
+}
+
+void jit_delete(Jit * j) {
+    if (!j) return;
+
+    munmap(j->code, JIT_CODE_SIZE);
+    free(j);
+}
+
+void jit_flush(Jit * j, BlockCache * c) {
+    /* throws away all native code, the blocks get compiled again once they're hot */
+    for (uint32_t i = 0; c && i < BLOCK_CACHE_SIZE; i++) {
+        if (c->blocks[i]) {
+            c->blocks[i]->native = NULL;
+            c->blocks[i]->runs = 0;
+        }
+    }
+
+    j->used = 0;
+    j->flushes++;
+}
+
+int jit_compile(Jit * j, Proc * p, Block * b) {
+    /* compiles a block, returns 0 and marks it rejected if it should stay in the interpreter */
+    uint8_t opcodes[MAX_BLOCK_OPS];
+    uint8_t live[MAX_BLOCK_OPS];
+    int inline_ops = 0;
+
+    uint16_t address = b->start;
+    for (int i = 0; i < b->count; i++) {
+        opcodes[i] = read_byte(p, address);
+        if (is_io(opcodes[i], b->ops[i].operand)) {
+            inline_ops = 0;
+            break;
+        }
+        inline_ops += is_native(opcodes[i]);
+        address += b->ops[i].length;
+    }
+
+    if (!inline_ops) {
+        b->rejected = 1;
+        j->rejected++;
+        return 0;
+    }
+
+    /* flags still needed after each op, only those get worked out. Handlers can read any
+     * of them and they're all live when the block ends
+     */
+    uint8_t needed = ALL_FLAGS;
+    for (int i = b->count - 1; i >= 0; i--) {
+        live[i] = needed;
+        if (is_native(opcodes[i])) {
+            needed = (needed & ~opcode_info[opcodes[i]].flags) | flags_read(opcodes[i]);
+        } else {
+            needed = ALL_FLAGS;
+        }
+    }
+
+    if (j->used + JIT_MAX_BLOCK_SIZE > JIT_CODE_SIZE) {
+        jit_flush(j, p->block_cache);
+    }
+
+    Emitter e = { j->code + j->used };
+    uint8_t * start = e.out;
+
+    // jumps to the epilogue for when a handler writes over the block or lowers the deadline
+    uint8_t * exits[2 * MAX_BLOCK_OPS];
+    int exit_count = 0;
+
+    // push rbx / r12 / r13, which also leaves the stack 16 byte aligned for calls
+    emit8(&e, 0x53);
+    emit8(&e, 0x41); emit8(&e, 0x54);
+    emit8(&e, 0x41); emit8(&e, 0x55);
+    // mov rbx, rdi
+    emit8(&e, 0x48); emit8(&e, 0x89); emit8(&e, 0xFB);
+    emit_load_regs(&e);
+
+    // registers changed since they were last stored, cycles not added yet and if p->pc is current
+    uint8_t dirty = 0;
+    uint32_t cycles = 0;
+    int pc_stored = 1;
+
+    address = b->start;
+    uint16_t exit_pc = address;
+    for (int i = 0; i < b->count; i++) {
+        const MicroOp * op = &b->ops[i];
+        uint8_t opcode = opcodes[i];
+
+        exit_pc = address + op->length;
+
+        if (is_native(opcode)) {
+            emit_native(&e, opcode, op->operand, live[i] & opcode_info[opcode].flags, &dirty);
+            cycles += op->cycles;
+            pc_stored = 0;
+
+            if (opcode == 0xC3) exit_pc = op->operand;
+            if (opcode == 0x18) exit_pc += (int8_t) op->operand;
+        } else {
+            if (!pc_stored) emit_store_pc(&e, address);
+            if (cycles) emit_add_cycles(&e, cycles);
+            emit_store_regs(&e, dirty);
+            cycles = 0;
+            dirty = 0;
+
+            emit8(&e, 0x48); emit8(&e, 0x89); emit8(&e, 0xDF);  // mov rdi, rbx
+            emit_mov_imm64(&e, RSI, (uintptr_t) op);
+            emit_mov_imm64(&e, RAX, (uintptr_t) (writes_flags(opcode) ? jit_call_handler : jit_call_handler_no_flags));
+            emit8(&e, 0xFF); emit8(&e, 0xD0);                   // call rax
+
+            // stop the same way the interpreter does if the block wrote over itself
+            emit_mov_imm64(&e, RAX, (uintptr_t) &b->valid);
+            emit8(&e, 0x80); emit8(&e, 0x38); emit8(&e, 0x00);  // cmp byte [rax], 0
+            emit8(&e, 0x0F); emit8(&e, 0x84);                   // je epilogue
+            exits[exit_count++] = e.out;
+            emit32(&e, 0);
+
+            // or if it asked to stop early (EI, HALT, an interrupt being raised)
+            emit8(&e, 0x48); emit8(&e, 0x8B); emit8(&e, 0x83);  // mov rax, [rbx + cycles]
+            emit32(&e, offsetof(Proc, cycles));
+            emit8(&e, 0x48); emit8(&e, 0x3B); emit8(&e, 0x83);  // cmp rax, [rbx + deadline]
+            emit32(&e, offsetof(Proc, deadline));
+            emit8(&e, 0x0F); emit8(&e, 0x83);                   // jae epilogue
+            exits[exit_count++] = e.out;
+            emit32(&e, 0);
+
+            emit_load_regs(&e);
+            pc_stored = 1;
+        }
+
+        address += op->length;
+    }
+
+    if (cycles) emit_add_cycles(&e, cycles);
+    emit_store_regs(&e, dirty);
+    if (!pc_stored) emit_store_pc(&e, exit_pc);
+
+    for (int i = 0; i < exit_count; i++) {
+        int32_t rel = (int32_t) (e.out - (exits[i] + 4));
+        memcpy(exits[i], &rel, 4);
+    }
+
+    // pop r13 / r12 / rbx, ret
+    emit8(&e, 0x41); emit8(&e, 0x5D);
+    emit8(&e, 0x41); emit8(&e, 0x5C);
+    emit8(&e, 0x5B);
+    emit8(&e, 0xC3);
+
+    j->used += e.out - start;
+    j->compiled++;
+    b->native = (NativeBlock) (void *) start;
+
+    return 1;
+}
+
+int jit_run(Proc * p, Block * b) {
+    /* runs a compiled block, returns the cycles run */
+    uint64_t start = p->cycles;
+
+    // the native code only knows about F, no lazy flags
+    proc_get_f(p);
+    b->native(p);
+
+    p->jit->native_runs++;
+    return p->cycles - start;
+}
+
+#else
+
+/* no jit on this host, proc_enable_jit just leaves the interpreter on */
+
+Jit * jit_create() {
+    return NULL;
+}
+
+void jit_delete(Jit * j) {
+}
+
+int jit_compile(Jit * j, struct Proc * p, Block * b) {
+    b->rejected = 1;
+    return 0;
+}
+
+int jit_run(struct Proc * p, Block * b) {
+    return 0;
+}
+
+void jit_flush(Jit * j, BlockCache * c) {
+}
+
+#endif
@@ -0,0 +1,53 @@
+#ifndef JIT_H
+#define JIT_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include "block.h"
+
+/*
+ * Translates hot blocks from the block cache into x86-64. The gameboy registers live in host
+ * registers for the whole block, the simple ops (LD r,r' / LD r,d8 / INC / DEC / ALU on
+ * registers / LD rr,d16 / JP / JR) are emitted inline and everything else calls the
+ * interpreter's handler for that op. Anything touching io through LDH / LD (C) is left to
+ * the interpreter completely.
+ */
+
+#if defined(__x86_64__) && !defined(_WIN32)
+#define JIT_SUPPORTED 1
+#else
+#define JIT_SUPPORTED 0
+#endif
+
+// times a block runs in the interpreter before it gets compiled
+#define JIT_THRESHOLD 16
+
+// executable memory for all blocks, thrown away and started over when it fills up
+#define JIT_CODE_SIZE (4 << 20)
+// worst case for one block, every op calling back into the interpreter
+#define JIT_MAX_BLOCK_SIZE 8192
+
+struct Proc;
+
+typedef struct Jit {
+    uint8_t * code;
+    size_t used;
+
+    unsigned threshold;
+
+    uint64_t compiled;
+    // hot blocks that touch io or have nothing worth compiling
+    uint64_t rejected;
+    uint64_t native_runs;
+    uint64_t flushes;
+} Jit;
+
+Jit *  jit_create();
+void   jit_delete(Jit * j);
+
+int    jit_compile(Jit * j, struct Proc * p, Block * b);
+int    jit_run(struct Proc * p, Block * b);
+void   jit_flush(Jit * j, BlockCache * c);
+
+#endif
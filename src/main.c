@@ -1,30 +1,370 @@
 // main.c
 
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
 #include "proc.h"
 #include "cart.h"
+#include "headless.h"
+#include "palette.h"
+#include "timing.h"
+#include "state.h"
+#include "rewind.h"
+// make headless builds without SDL, it's always headless then
+#ifndef HEADLESS
 #include "video.h"
+#include "audio.h"
+#endif
+
+// how many frames between printing the stats with --stats
+#define STATS_INTERVAL 60
+
+// host audio, the ring holds a little over 100 ms of it
+#define AUDIO_RATE 48000
+#define AUDIO_RING_SAMPLES 8192
+// rewind keeps at most this many snapshots, the budget usually runs out first
+#define REWIND_DEPTH 3600
+#define REWIND_BUDGET_MIB 64
+
+// what the rate control keeps in the ring, 40 ms on top of the device's own buffer
+#define AUDIO_TARGET_SAMPLES (AUDIO_RATE / 25)
+
+#ifndef HEADLESS
+// what the speed key goes through, uncapped after the last one
+static const unsigned speed_steps[] = { 1, 2, 4, 8 };
+
+static unsigned next_speed(unsigned speed) {
+    /* the next step up from speed, a --speed between two steps goes to the one above */
+    if (!speed) return speed_steps[0];
+    for (int i = 0; i < sizeof(speed_steps) / sizeof(speed_steps[0]); i++) {
+        if (speed_steps[i] > speed) return speed_steps[i];
+    }
+    return 0;
+}
+#endif
+
+static uint64_t run_frame(Proc * p, uint64_t target_cycles) {
+    /* runs exactly one frame worth of cycles, any overshoot from the last
+     * instruction is taken off of the next frame. Returns the next target
+     */
+    target_cycles += CYCLES_PER_FRAME;
+    if (p->cycles < target_cycles) {
+        proc_run_cycles(p, target_cycles - p->cycles);
+    }
+    return target_cycles;
+}
 
 int main(int argc, char **argv) {
 
     Proc* processor = proc_create();
 
-    Cart* cartridge = cart_create("../roms/Dr. Mario (World).gb");
+    char* rom_file = "../roms/Dr. Mario (World).gb";
+    char* frames_file = NULL;
+    char* wav_file = NULL;
+    char* load_state_file = NULL;
+    char* save_state_file = NULL;
+    // frames between rewind snapshots, 0 is off
+    unsigned rewind_interval = 0;
+    unsigned rewind_budget = REWIND_BUDGET_MIB;
+    unsigned rewind_back = 0;
+    int audio = 1;
+    ColorScheme colors = COLORS_GREY;
+    uint64_t max_frames = 0;
+    // times real time, 0 runs as fast as it can
+    unsigned speed = 1;
+    // debug builds always print them
+    int stats = DEBUG;
+#ifdef HEADLESS
+    int headless = 1;
+#else
+    int headless = 0;
+#endif
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--jit") == 0) {
+            if (!proc_enable_jit(processor, 1)) {
+                fprintf(stderr, "no jit on this host, using the interpreter\n");
+            }
+        } else if (strcmp(argv[i], "--no-idle-skip") == 0) {
+            processor->skip_idle_loops = 0;
+        } else if (strcmp(argv[i], "--headless") == 0) {
+            headless = 1;
+        } else if (strcmp(argv[i], "--frames") == 0 && i + 1 < argc) {
+            // stop after this many frames, 0 runs forever
+            max_frames = strtoull(argv[++i], NULL, 10);
+        } else if (strcmp(argv[i], "--speed") == 0 && i + 1 < argc) {
+            // 1, 2, 4, 8... or uncapped
+            i++;
+            speed = strcmp(argv[i], "uncapped") == 0 ? 0 : strtoul(argv[i], NULL, 10);
+            // the window's speed key (video.h) changes it while it runs
+            if (strcmp(argv[i], "uncapped") != 0 && !speed) {
+                fprintf(stderr, "--speed takes a multiplier or uncapped\n");
+                return 1;
+            }
+        } else if (strcmp(argv[i], "--frame-skip") == 0 && i + 1 < argc) {
+            // auto skips frames the video thread isn't keeping up with, N/M skips N of every M
+            i++;
+            unsigned skip, every;
+            if (strcmp(argv[i], "auto") == 0) {
+                processor->frame_skip.adaptive = 1;
+            } else if (sscanf(argv[i], "%u/%u", &skip, &every) == 2 && skip < every && every <= 255) {
+                processor->frame_skip.skip = skip;
+                processor->frame_skip.every = every;
+            } else {
+                fprintf(stderr, "--frame-skip takes auto or N/M, skipping N of every M frames\n");
+                return 1;
+            }
+        } else if (strcmp(argv[i], "--colors") == 0 && i + 1 < argc) {
+            if (!palette_parse_scheme(argv[++i], &colors)) {
+                fprintf(stderr, "--colors takes grey, dmg or 4 RRGGBB colours separated by commas\n");
+                return 1;
+            }
+        } else if (strcmp(argv[i], "--dump") == 0 && i + 1 < argc) {
+            // headless only, writes every frame to the file (headless.h)
+            frames_file = argv[++i];
+        } else if (strcmp(argv[i], "--wav") == 0 && i + 1 < argc) {
+            // headless only, the sound goes to a wav file instead of nowhere
+            wav_file = argv[++i];
+        } else if (strcmp(argv[i], "--load-state") == 0 && i + 1 < argc) {
+            // starts from a state saved with the same rom (state.h)
+            load_state_file = argv[++i];
+        } else if (strcmp(argv[i], "--save-state") == 0 && i + 1 < argc) {
+            // saved once it stops, with --frames that's a state after exactly that many
+            save_state_file = argv[++i];
+        } else if (strcmp(argv[i], "--rewind") == 0 && i + 1 < argc) {
+            // a snapshot every N frames (rewind.h)
+            rewind_interval = strtoul(argv[++i], NULL, 10);
+        } else if (strcmp(argv[i], "--rewind-budget") == 0 && i + 1 < argc) {
+            // MiB for the snapshots
+            rewind_budget = strtoul(argv[++i], NULL, 10);
+        } else if (strcmp(argv[i], "--rewind-back") == 0 && i + 1 < argc) {
+            // steps back this many snapshots once it stops, before --save-state
+            rewind_back = strtoul(argv[++i], NULL, 10);
+        } else if (strcmp(argv[i], "--no-audio") == 0) {
+            audio = 0;
+        } else if (strcmp(argv[i], "--stats") == 0) {
+            // clock speed, idle time and frame counts every STATS_INTERVAL frames on stderr
+            stats = 1;
+        } else {
+            rom_file = argv[i];
+        }
+    }
+
+    Cart* cartridge = cart_create(rom_file);
+    if (!cartridge) return 1;
 
     cart_load(cartridge, processor);
 
-    //Screen* screen = screen_create();
+    if (load_state_file && !state_load_file(processor, load_state_file)) {
+        fprintf(stderr, "could not load a state for this rom from '%s'\n", load_state_file);
+        return 1;
+    }
+
+    Headless sink = {0};
+    FILE* frames_out = NULL;
+    WavSink wav = {0};
+    AudioRing audio_ring;
+    int ring_ready = 0;
+    int audio_on = 0;
+#ifndef HEADLESS
+    Screen* screen = NULL;
+    pthread_t video = 0;
+    SDL_AudioDeviceID audio_device = 0;
+#endif
+
+    if (headless) {
+        if (frames_file) {
+            frames_out = fopen(frames_file, "wb");
+            if (!frames_out) {
+                fprintf(stderr, "could not open '%s'\n", frames_file);
+                return 1;
+            }
+            sink.callback = headless_file_sink;
+            sink.data = frames_out;
+        }
+        // without somewhere for it to go the apu doesn't make any samples
+        if (audio && wav_file) {
+            if (!headless_wav_open(&wav, wav_file, AUDIO_RATE)) {
+                fprintf(stderr, "could not open '%s'\n", wav_file);
+                return 1;
+            }
+            audio_on = ring_ready = audio_ring_init(&audio_ring, AUDIO_RING_SAMPLES);
+        }
+    } else {
+#ifndef HEADLESS
+        screen = screen_create();
+        screen->colors = colors;
+
+        // draws each frame the ppu finishes until screen_stop
+        video = dispatch_thread(screen, processor);
 
-    //pthread_t thread_id = dispatch_thread(screen, processor);
-    
-    while (1) {
-        proc_read_word(processor);
+        if (audio && (ring_ready = audio_ring_init(&audio_ring, AUDIO_RING_SAMPLES))) {
+            audio_device = audio_open(&audio_ring, AUDIO_RATE);
+            audio_on = audio_device != 0;
+        }
+#endif
     }
 
-    // TODO signal the video thread to end here 
-    
-    // Wait for the video thread to end 
-    //pthread_join(thread_id, NULL);
+    if (audio_on) apu_set_output(processor, &audio_ring, AUDIO_RATE);
+
+    Rewind rewind;
+    int rewind_on = rewind_interval && rewind_init(&rewind, processor, (size_t) rewind_budget << 20,
+            REWIND_DEPTH, rewind_interval, 1);
+
+    /* playing through the sound card at real time the ring is kept around the target by
+     * nudging the sample rate rather than by waiting on it, the wav sink takes whatever's made
+     */
+    int rate_control = audio_on && !headless && speed == 1;
+    RateControl rate;
+    timing_rate_control_init(&rate, AUDIO_TARGET_SAMPLES);
+    if (rate_control) {
+        // silence to play while the apu makes the first frames
+        StereoSample silence[AUDIO_TARGET_SAMPLES] = {{0}};
+        audio_ring_write(&audio_ring, silence, AUDIO_TARGET_SAMPLES);
+    }
+
+    /* the video thread shows a frame every real frame time whatever the speed, anything
+     * faster just drops the frames in between without drawing them
+     */
+    Pacer pacer;
+    timing_pacer_init(&pacer, speed);
+    uint64_t target_cycles = processor->cycles;
+    uint64_t start_ns = timing_now_ns();
+
+    uint64_t start_cycles = processor->cycles;
+    uint64_t start_cpu_ns = timing_thread_cpu_ns();
+
+    uint64_t stats_cycles = processor->cycles;
+    uint64_t stats_halted = processor->stats.halted_cycles;
+    uint64_t stats_idle = processor->stats.idle_cycles;
+    uint64_t stats_tiles = processor->stats.tiles_decoded;
+    uint64_t stats_cpu_ns = start_cpu_ns;
+    uint64_t stats_wall_ns = start_ns;
+    uint64_t frame_count = 0;
+    int frames = 0;
+
+    while (!max_frames || frame_count < max_frames) {
+        target_cycles = run_frame(processor, target_cycles);
+        frame_count++;
+
+        if (headless) {
+            headless_present(&sink, processor);
+            // everything up to the end of the frame, then it's written out
+            if (audio_on) {
+                apu_sync(processor);
+                headless_wav_drain(&wav, &audio_ring);
+            }
+        }
+
+        if (rewind_on) rewind_frame(&rewind, processor);
+
+        if (rate_control) {
+            apu_adjust_rate(processor, timing_rate_control_update(&rate, audio_ring_fill(&audio_ring)));
+        }
+
+        if (stats && ++frames == STATS_INTERVAL) {
+            uint64_t cpu_ns = timing_thread_cpu_ns();
+            uint64_t wall_ns = timing_now_ns();
+            uint64_t cycles = processor->cycles - stats_cycles;
+            double fps = timing_fps(STATS_INTERVAL, wall_ns - stats_wall_ns);
+            fprintf(stderr, "%.1f emulated fps, %.2fx real time\n", fps, fps * FRAME_NS / 1e9);
+            fprintf(stderr, "emulated %.3f MHz per host core, %.1f%% halted, %.1f%% in idle loops\n",
+                    timing_emulated_mhz(cycles, cpu_ns - stats_cpu_ns),
+                    100.0 * (processor->stats.halted_cycles - stats_halted) / cycles,
+                    100.0 * (processor->stats.idle_cycles - stats_idle) / cycles);
+            fprintf(stderr, "%s: %llu idle loops found, skipped %llu times\n", rom_file,
+                    (unsigned long long) processor->stats.idle_loops,
+                    (unsigned long long) processor->stats.idle_skips);
+            fprintf(stderr, "%.1f tiles decoded per frame\n",
+                    (double) (processor->stats.tiles_decoded - stats_tiles) / STATS_INTERVAL);
+            // the video thread's counts, only read here so they don't need to be exact
+            fprintf(stderr, "frames %llu drawn, %llu skipped, %llu dropped, %llu shown twice\n",
+                    (unsigned long long) processor->frames.published,
+                    (unsigned long long) processor->stats.frames_skipped,
+                    (unsigned long long) processor->frames.dropped,
+                    (unsigned long long) __atomic_load_n(&processor->frames.duplicated, __ATOMIC_RELAXED));
+            if (rewind_on) {
+                // racing the worker, close enough for stats
+                fprintf(stderr, "rewind %u snapshots in %.1f MiB, %.1f us a capture on this thread, %llu skipped\n",
+                        rewind.count + rewind.has_latest, rewind.used / 1048576.0,
+                        rewind.captures ? rewind.capture_ns / 1e3 / rewind.captures : 0,
+                        (unsigned long long) rewind.skipped);
+            }
+            if (pacer.waits) {
+                fprintf(stderr, "pacer woke up %.3f ms late on average\n", pacer.late_ns / 1e6 / pacer.waits);
+            }
+            if (rate_control) {
+                // the underruns are the callback's, close enough read from here
+                fprintf(stderr, "audio %.0f samples in the ring, %.1f ms latency, rate x%.4f, %llu underruns, %llu overruns\n",
+                        rate.fill, rate.fill * 1000 / AUDIO_RATE, rate.ratio,
+                        (unsigned long long) audio_ring.underruns, (unsigned long long) audio_ring.overruns);
+            }
+            stats_cycles = processor->cycles;
+            stats_halted = processor->stats.halted_cycles;
+            stats_idle = processor->stats.idle_cycles;
+            stats_tiles = processor->stats.tiles_decoded;
+            stats_cpu_ns = cpu_ns;
+            stats_wall_ns = wall_ns;
+            frames = 0;
+        }
+
+#ifndef HEADLESS
+        if (screen) {
+            int input = screen_poll(screen, processor);
+            if (input & SCREEN_QUIT) break;
+
+            if (input & SCREEN_SPEED) {
+                speed = next_speed(speed);
+                timing_pacer_init(&pacer, speed);
+                if (speed) printf("speed %ux\n", speed);
+                else printf("speed uncapped\n");
+
+                // only at real time, faster than that the ring just overruns
+                int was_rate_control = rate_control;
+                rate_control = audio_on && speed == 1;
+                if (rate_control && !was_rate_control) timing_rate_control_init(&rate, AUDIO_TARGET_SAMPLES);
+                if (!rate_control && was_rate_control) apu_adjust_rate(processor, 1.0);
+            }
+        }
+#endif
+
+        /* pace to the real gameboy clock times the speed */
+        timing_pacer_wait(&pacer);
+    }
+
+    uint64_t wall_ns = timing_now_ns() - start_ns;
+    double fps = timing_fps(frame_count, wall_ns);
+    printf("%llu frames in %.3f s, %.1f fps, %.2fx real time\n", (unsigned long long) frame_count,
+            wall_ns / 1e9, fps, fps * FRAME_NS / 1e9);
+    printf("emulated %.3f MHz per host core\n",
+            timing_emulated_mhz(processor->cycles - start_cycles, timing_thread_cpu_ns() - start_cpu_ns));
+    printf("frames %llu drawn, %llu skipped, %llu dropped, %llu shown twice\n",
+            (unsigned long long) processor->frames.published,
+            (unsigned long long) processor->stats.frames_skipped,
+            (unsigned long long) processor->frames.dropped,
+            (unsigned long long) __atomic_load_n(&processor->frames.duplicated, __ATOMIC_RELAXED));
+
+    if (rewind_on) {
+        for (unsigned i = 0; i < rewind_back && rewind_step_back(&rewind, processor); i++) {}
+        rewind_free(&rewind);
+    }
+
+    if (save_state_file && !state_save_file(processor, save_state_file, STATE_PACKED)) {
+        fprintf(stderr, "could not save the state to '%s'\n", save_state_file);
+    }
+
+#ifndef HEADLESS
+    // both threads read from the Proc and the ring, they're stopped before either goes
+    if (screen) screen_stop(screen, video);
+    audio_close(audio_device);
+#endif
+    if (ring_ready) audio_ring_free(&audio_ring);
+
+    if (frames_out) fclose(frames_out);
+    headless_wav_close(&wav);
+
+    cart_delete(cartridge);
+    proc_delete(processor);
 
     return 0; 
-}
\ No newline at end of file
+}
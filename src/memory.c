@@ -1,48 +1,119 @@
 #include "memory.h"
+#include "tile.h"
+
+/* external definitions of the inline accessors in memory.h */
+extern inline uint8_t read_byte(Proc * p, uint16_t address);
+extern inline void write_byte(Proc * p, uint16_t address, uint8_t value);
+
+/* ---------------------------------------------------------------------------------------
+ * pages
+ * --------------------------------------------------------------------------------------- */
+
+void memory_map_pages(Proc * p, uint16_t address, uint32_t size, uint8_t * read, uint8_t * write) {
+    /* points the pages covering address -> address + size at read / write, NULL for the slow path */
+    for (uint32_t offset = 0; offset < size; offset += PAGE_SIZE) {
+        int page = (address + offset) >> PAGE_SHIFT;
+        p->read_page[page] = read ? read + offset : NULL;
+        p->write_page[page] = write ? write + offset : NULL;
+    }
+}
 
-uint8_t read_byte(Proc * p, uint16_t address) {
-    return p->memory[address];
+void memory_reset_pages(Proc * p) {
+    /* everything straight into memory without a cart, except where writes do something else */
+    memory_map_pages(p, 0x0000, 0x8000, p->memory, NULL);            // rom, writes are the bank registers
+    memory_map_pages(p, 0x8000, 0x2000, p->memory + 0x8000, NULL);   // vram, writes update the tiles
+    memory_map_pages(p, 0xA000, 0x2000, p->memory + 0xA000, p->memory + 0xA000);
+    memory_map_pages(p, 0xC000, 0x2000, p->memory + 0xC000, p->memory + 0xC000);
+    // echo of 0xC000, writes go the slow way so they see any code in work ram
+    memory_map_pages(p, 0xE000, PAGE_SIZE, p->memory + 0xC000, NULL);
+    // rest of the echo, oam, io and high ram
+    memory_map_pages(p, 0xF000, PAGE_SIZE, NULL, NULL);
 }
 
-void write_byte(Proc * p, uint16_t address, uint8_t value) {
-    p->memory[address] = value;
-    
-    /* http://imrannazar.com/GameBoy-Emulation-in-JavaScript:-Graphics */
-    
-    /* if we are writing a byte that is in the vram, we should update the internal representation 
-     * of the tiles 
+void memory_protect_code(Proc * p, uint16_t address, uint16_t bytes) {
+    /* a block was just cached, writes to its pages have to check if they hit it. The page
+     * gets its direct pointer back once it has no code in it (memory_write_slow)
      */
+    if (!bytes) return;
 
-    if ((address & 0xF000) == 0x8000 || (address & 0xF000) == 0x9000) {
-        // Then this should trigger an update to the tile map
-        write_tile(p, address, value);
+    for (int page = address >> PAGE_SHIFT; page <= (address + bytes - 1) >> PAGE_SHIFT; page++) {
+        p->write_page[page & (NUM_PAGES - 1)] = NULL;
     }
 }
 
-void write_tile(Proc * p, uint16_t address, uint8_t value) {
-    uint16_t base_address = address & 0x1FFE;
-    int tile = (base_address >> 4) & 511;
-    int y = (base_address >> 1) & 7;
-    int bit_index;
-    
-    for (int i = 0; i < 8; i ++) {
-        bit_index = 1 << (7 - i);
-
-        /* 
-         * if memory looks like ..... 1 .....
-         *                      ..... 0 .....
-         * result should be 1, 
-         * if memory looks like ..... 1 .....
-         *                      ..... 1 .....
-         * result should be 3, etc
-         */
-
-        p->tileset[tile][i][y] = p->memory[address] & bit_index ? 1 : 0;
-        p->tileset[tile][i][y] += p->memory[address+1] & bit_index ? 2 : 0;
+static void write_code_byte(Proc * p, uint16_t address, uint8_t value) {
+    p->memory[address] = value;
+
+    // drop any pre-decoded code that was just written over
+    if (p->block_cache && p->block_cache->code[address]) {
+        block_cache_invalidate(p->block_cache, address);
     }
+}
 
+uint8_t memory_read_slow(Proc * p, uint16_t address) {
+    if (address >= 0xA000 && address < 0xC000 && p->cart) {
+        return cart_read_ram(p->cart, p, address);
+    }
+    if (address >= 0xE000 && address < 0xFE00) {
+        return p->memory[address - 0x2000];
+    }
+    // some io registers are worked out when they're read (io.c)
+    if (address >= 0xFF00 && address < 0xFF80) {
+        return io_read(p, address);
+    }
+    return p->memory[address];
 }
 
+void memory_write_slow(Proc * p, uint16_t address, uint8_t value) {
+    if (address < 0x8000) {
+        // with a cart plugged in the rom is read only, writes set the bank registers
+        if (p->cart) {
+            cart_write(p->cart, p, address, value);
+        } else {
+            write_code_byte(p, address, value);
+        }
+        return;
+    }
+
+    if (address < 0xA000) {
+        p->memory[address] = value;
+
+        // 0x9800 onwards is the tile maps, the tile data gets decoded when it's drawn
+        if (address < 0x9800) {
+            tile_mark_dirty(p, address);
+        }
+        return;
+    }
+
+    if (address < 0xC000) {
+        // cart ram that isn't a plain bank, MBC2 / the MBC3 clock / disabled
+        cart_write_ram(p->cart, p, address, value);
+        return;
+    }
+
+    if (address < 0xE000) {
+        write_code_byte(p, address, value);
+
+        int page = address >> PAGE_SHIFT;
+        if (!p->block_cache || !p->block_cache->page_code[page]) {
+            p->write_page[page] = p->memory + (page << PAGE_SHIFT);
+        }
+        return;
+    }
+
+    if (address < 0xFE00) {
+        memory_write_slow(p, address - 0x2000, value);
+        return;
+    }
+
+    if ((address >= 0xFF00 && address < 0xFF80) || address == IO_IE) {
+        io_write(p, address, value);
+        return;
+    }
+
+    // oam and high ram
+    write_code_byte(p, address, value);
+}
 
 // TODO not sure if we are ever going to use this?
 // uint16_t read_word(Proc * p, uint16_t address)
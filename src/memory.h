@@ -2,14 +2,43 @@
 #define MEMORY_H
 
 #include "proc.h"
+#include "cart.h"
 void proc_initialize_memory(Proc * p);
 
-uint8_t read_byte(Proc * p, uint16_t address);
-void write_byte(Proc * p, uint16_t address, uint8_t value);
+/*
+ * The bus is a table of 4 KiB pages (Proc.read_page / write_page). A page that is plain
+ * memory, rom or ram, points straight at it, anything with side effects (the bank registers,
+ * vram tiles, io, work ram with cached code in it) is NULL and goes through the slow path
+ * in memory.c.
+ */
+
+void memory_map_pages(Proc * p, uint16_t address, uint32_t size, uint8_t * read, uint8_t * write);
+void memory_reset_pages(Proc * p);
+void memory_protect_code(Proc * p, uint16_t address, uint16_t bytes);
+
+uint8_t memory_read_slow(Proc * p, uint16_t address);
+void    memory_write_slow(Proc * p, uint16_t address, uint8_t value);
+
+/* every instruction goes through these, so they are inline (memory.c has the external definitions) */
+
+inline uint8_t read_byte(Proc * p, uint16_t address) {
+    uint8_t * page = p->read_page[address >> PAGE_SHIFT];
+    if (page) {
+        return page[address & (PAGE_SIZE - 1)];
+    }
+    return memory_read_slow(p, address);
+}
+
+inline void write_byte(Proc * p, uint16_t address, uint8_t value) {
+    uint8_t * page = p->write_page[address >> PAGE_SHIFT];
+    if (page) {
+        page[address & (PAGE_SIZE - 1)] = value;
+        return;
+    }
+    memory_write_slow(p, address, value);
+}
 
 uint16_t read_word(Proc * p, uint16_t address);
 void write_word(Proc * p, uint16_t address, uint16_t word);
 
-void write_tile(Proc * p, uint16_t address, uint8_t value);
-
-#endif
\ No newline at end of file
+#endif
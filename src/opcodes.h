@@ -0,0 +1,26 @@
+#ifndef OPCODES_H
+#define OPCODES_H
+
+#include <stdint.h>
+
+/* Decode metadata, see opcodes.c (generated by helper_scripts/make_switch.py --tables) */
+
+// bits of the F register, also used for the flags written by an opcode
+#define FLAG_ZERO       0x80
+#define FLAG_SUBTRACT   0x40
+#define FLAG_HALF_CARRY 0x20
+#define FLAG_CARRY      0x10
+
+typedef struct {
+    const char * mnemonic;
+    uint8_t length;
+    uint8_t cycles;       // when a conditional op is not taken
+    uint8_t cycles_taken;
+    uint8_t flags;        // FLAG_* bits the op writes
+    uint8_t ends_block;   // jumps, calls, returns and anything touching interrupts
+} OpcodeInfo;
+
+extern const OpcodeInfo opcode_info[256];
+extern const OpcodeInfo cb_opcode_info[256];
+
+#endif
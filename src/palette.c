@@ -0,0 +1,109 @@
+// palette.c
+#include <stdio.h>
+#include <string.h>
+
+#include "palette.h"
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+const ColorScheme COLORS_GREY = { { 0xFFFFFFFF, 0xFFC0C0C0, 0xFF606060, 0xFF000000 } };
+const ColorScheme COLORS_DMG = { { 0xFF9BBC0F, 0xFF8BAC0F, 0xFF306230, 0xFF0F380F } };
+
+int palette_parse_scheme(const char * name, ColorScheme * scheme) {
+    if (strcmp(name, "grey") == 0) {
+        *scheme = COLORS_GREY;
+        return 1;
+    }
+    if (strcmp(name, "dmg") == 0) {
+        *scheme = COLORS_DMG;
+        return 1;
+    }
+
+    unsigned colors[4];
+    int end = 0;
+    if (sscanf(name, "%6x,%6x,%6x,%6x%n", &colors[0], &colors[1], &colors[2], &colors[3], &end) != 4
+            || name[end]) {
+        return 0;
+    }
+    for (int i = 0; i < 4; i++) {
+        scheme->colors[i] = 0xFF000000 | colors[i];
+    }
+    return 1;
+}
+
+#if defined(__AVX2__)
+
+void palette_convert_line(const ColorScheme * scheme, const uint8_t * shades, uint32_t * pixels, int count) {
+    /* 8 pixels at a time, the shades are the indexes of a permute of the 4 colours */
+    const __m256i colors = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i *) scheme->colors));
+
+    int x = 0;
+    for (; x + 8 <= count; x += 8) {
+        __m256i index = _mm256_cvtepu8_epi32(_mm_loadl_epi64((const __m128i *) (shades + x)));
+        index = _mm256_and_si256(index, _mm256_set1_epi32(3));
+        _mm256_storeu_si256((__m256i *) (pixels + x), _mm256_permutevar8x32_epi32(colors, index));
+    }
+    for (; x < count; x++) {
+        pixels[x] = scheme->colors[shades[x] & 3];
+    }
+}
+
+#elif defined(__SSE2__)
+
+void palette_convert_line(const ColorScheme * scheme, const uint8_t * shades, uint32_t * pixels, int count) {
+    /* 16 pixels at a time. There's no variable shuffle in SSE2, so bit 0 of the shade picks
+     * between colours 0 / 1 and 2 / 3, then bit 1 picks between those
+     */
+    const __m128i c0 = _mm_set1_epi32(scheme->colors[0]);
+    const __m128i c2 = _mm_set1_epi32(scheme->colors[2]);
+    const __m128i c01 = _mm_xor_si128(c0, _mm_set1_epi32(scheme->colors[1]));
+    const __m128i c23 = _mm_xor_si128(c2, _mm_set1_epi32(scheme->colors[3]));
+
+    int x = 0;
+    for (; x + 16 <= count; x += 16) {
+        // each bit moved to the top of its byte, unpacking then spreads it to the top of a lane
+        __m128i bytes = _mm_loadu_si128((const __m128i *) (shades + x));
+        __m128i bit0 = _mm_slli_epi16(bytes, 7);
+        __m128i bit1 = _mm_slli_epi16(bytes, 6);
+
+        __m128i b0[4], b1[4];
+        b0[0] = _mm_unpacklo_epi8(bit0, bit0);
+        b0[2] = _mm_unpackhi_epi8(bit0, bit0);
+        b1[0] = _mm_unpacklo_epi8(bit1, bit1);
+        b1[2] = _mm_unpackhi_epi8(bit1, bit1);
+        for (int i = 0; i < 4; i += 2) {
+            b0[i + 1] = _mm_unpackhi_epi16(b0[i], b0[i]);
+            b0[i] = _mm_unpacklo_epi16(b0[i], b0[i]);
+            b1[i + 1] = _mm_unpackhi_epi16(b1[i], b1[i]);
+            b1[i] = _mm_unpacklo_epi16(b1[i], b1[i]);
+        }
+
+        for (int i = 0; i < 4; i++) {
+            // all ones in the lanes with the bit set
+            __m128i m0 = _mm_srai_epi32(b0[i], 31);
+            __m128i m1 = _mm_srai_epi32(b1[i], 31);
+
+            __m128i low = _mm_xor_si128(c0, _mm_and_si128(m0, c01));
+            __m128i high = _mm_xor_si128(c2, _mm_and_si128(m0, c23));
+            __m128i out = _mm_xor_si128(low, _mm_and_si128(m1, _mm_xor_si128(low, high)));
+            _mm_storeu_si128((__m128i *) (pixels + x + i * 4), out);
+        }
+    }
+    for (; x < count; x++) {
+        pixels[x] = scheme->colors[shades[x] & 3];
+    }
+}
+
+#else
+
+void palette_convert_line(const ColorScheme * scheme, const uint8_t * shades, uint32_t * pixels, int count) {
+    for (int x = 0; x < count; x++) {
+        pixels[x] = scheme->colors[shades[x] & 3];
+    }
+}
+
+#endif
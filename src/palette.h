@@ -0,0 +1,26 @@
+#ifndef PALETTE_H
+#define PALETTE_H
+
+#include <stdint.h>
+
+/*
+ * Turning the shades the ppu draws (0 lightest -> 3 darkest, after BGP / OBP0 / OBP1) into
+ * ARGB8888 for the screen. The colour scheme is just the 4 colours the shades look up, so
+ * any scheme costs the same per pixel.
+ */
+
+typedef struct {
+    uint32_t colors[4];
+} ColorScheme;
+
+extern const ColorScheme COLORS_GREY;
+// the green of the original screen
+extern const ColorScheme COLORS_DMG;
+
+// grey, dmg, or 4 RRGGBB hex colours lightest first separated by commas, 0 if it isn't any of them
+int  palette_parse_scheme(const char * name, ColorScheme * scheme);
+
+// count shades to ARGB8888
+void palette_convert_line(const ColorScheme * scheme, const uint8_t * shades, uint32_t * pixels, int count);
+
+#endif
@@ -0,0 +1,162 @@
+// ppu.c
+#include <string.h>
+
+#include "ppu.h"
+#include "io.h"
+#include "tile.h"
+
+typedef struct {
+    uint8_t y;
+    uint8_t x;
+    uint8_t tile;
+    uint8_t attributes;
+} Sprite;
+
+static inline int tile_index(uint8_t lcdc, uint8_t tile) {
+    /* 0x8000 addressing is unsigned, 0x8800 is signed from 0x9000 (tile 256 in the tileset) */
+    return lcdc & LCDC_TILE_DATA ? tile : 256 + (int8_t) tile;
+}
+
+static void render_background(Proc * p, uint8_t lcdc, int ly, uint8_t * colors) {
+    const uint8_t * map = &p->memory[lcdc & LCDC_BG_MAP ? 0x9C00 : 0x9800];
+    uint8_t y = ly + p->memory[IO_SCY];
+    uint8_t scx = p->memory[IO_SCX];
+
+    map += (y / TILE_HEIGHT) * (BACKGROUND_W / TILE_WIDTH);
+    for (int x = 0; x < SCREEN_WIDTH; x++) {
+        // wraps around at 256
+        uint8_t bx = x + scx;
+        const uint8_t * row = p->tileset[tile_index(lcdc, map[bx / TILE_WIDTH])][y % TILE_HEIGHT];
+        colors[x] = row[bx % TILE_WIDTH];
+    }
+}
+
+static void render_window(Proc * p, uint8_t lcdc, int ly, uint8_t * colors) {
+    /* the window has its own line counter, it only moves on lines the window was drawn on */
+    int wx = p->memory[IO_WX] - 7;
+    if (ly < p->memory[IO_WY] || wx >= SCREEN_WIDTH) return;
+
+    const uint8_t * map = &p->memory[lcdc & LCDC_WINDOW_MAP ? 0x9C00 : 0x9800];
+    int y = p->window_line++;
+
+    map += (y / TILE_HEIGHT) * (BACKGROUND_W / TILE_WIDTH);
+    for (int x = wx < 0 ? 0 : wx; x < SCREEN_WIDTH; x++) {
+        int wx_pixel = x - wx;
+        const uint8_t * row = p->tileset[tile_index(lcdc, map[wx_pixel / TILE_WIDTH])][y % TILE_HEIGHT];
+        colors[x] = row[wx_pixel % TILE_WIDTH];
+    }
+}
+
+static void render_sprites(Proc * p, uint8_t lcdc, int ly, const uint8_t * colors, uint8_t * line) {
+    int height = lcdc & LCDC_OBJ_TALL ? 16 : 8;
+
+    // the first 10 in oam that are on the line, then the lowest x is drawn on top (oam order for ties)
+    Sprite sprites[MAX_LINE_SPRITES];
+    int count = 0;
+    for (int i = 0; i < MAX_SPRITES && count < MAX_LINE_SPRITES; i++) {
+        Sprite s;
+        memcpy(&s, &p->memory[OAM_START + i * sizeof(Sprite)], sizeof(Sprite));
+
+        int top = s.y - 16;
+        if (ly < top || ly >= top + height) continue;
+
+        int j = count++;
+        while (j > 0 && sprites[j - 1].x > s.x) {
+            sprites[j] = sprites[j - 1];
+            j--;
+        }
+        sprites[j] = s;
+    }
+
+    uint8_t covered[SCREEN_WIDTH] = {0};
+    for (int i = 0; i < count; i++) {
+        const Sprite * s = &sprites[i];
+
+        int row = ly - (s->y - 16);
+        if (s->attributes & OBJ_FLIP_Y) row = height - 1 - row;
+
+        int tile = height == 16 ? (s->tile & 0xFE) + row / TILE_HEIGHT : s->tile;
+        const uint8_t * pixels = p->tileset[tile][row % TILE_HEIGHT];
+        const uint8_t * palette = p->palettes[s->attributes & OBJ_PALETTE ? PALETTE_OBJ1 : PALETTE_OBJ0];
+
+        for (int column = 0; column < TILE_WIDTH; column++) {
+            int x = s->x - 8 + column;
+            if (x < 0 || x >= SCREEN_WIDTH || covered[x]) continue;
+
+            uint8_t color = pixels[s->attributes & OBJ_FLIP_X ? 7 - column : column];
+            // colour 0 is see through
+            if (!color) continue;
+
+            // a sprite hides the ones under it even where it's behind the background itself
+            covered[x] = 1;
+            if ((s->attributes & OBJ_BEHIND_BG) && colors[x]) continue;
+
+            line[x] = palette[color];
+        }
+    }
+}
+
+void ppu_write_palette(Proc * p, uint16_t address, uint8_t value) {
+    /* 2 bits per colour, colour 0 in the lowest, looked up for every pixel so they're split out here */
+    uint8_t * palette = p->palettes[address - IO_BGP];
+
+    p->memory[address] = value;
+    for (int color = 0; color < 4; color++) {
+        palette[color] = (value >> (color * 2)) & 3;
+    }
+}
+
+static int skip_frame(Proc * p) {
+    FrameSkip * s = &p->frame_skip;
+
+    if (s->adaptive && triple_buffer_waiting(&p->frames)) return 1;
+
+    if (!s->every) return 0;
+    int position = s->position;
+    s->position = (position + 1) % s->every;
+    return position < s->skip;
+}
+
+void ppu_start_frame(Proc * p) {
+    p->window_line = 0;
+    p->frame_skip.skipping = skip_frame(p);
+}
+
+void ppu_end_frame(Proc * p) {
+    if (p->frame_skip.skipping) {
+        p->stats.frames_skipped++;
+        return;
+    }
+    // the next frame is drawn into whichever buffer nobody is looking at
+    p->framebuffer = triple_buffer_publish(&p->frames);
+}
+
+void ppu_render_line(Proc * p) {
+    int ly = p->memory[IO_LY];
+    if (ly >= SCREEN_HEIGHT || p->frame_skip.skipping) return;
+
+    // anything written to the tiles since the last line
+    tiles_update(p);
+
+    uint8_t lcdc = p->memory[IO_LCDC];
+    uint8_t * line = p->framebuffer[ly];
+
+    // colour before the palette, sprites behind the background need it
+    uint8_t colors[SCREEN_WIDTH];
+    if (lcdc & LCDC_BG_ON) {
+        render_background(p, lcdc, ly, colors);
+        if (lcdc & LCDC_WINDOW_ON) render_window(p, lcdc, ly, colors);
+
+        const uint8_t * bgp = p->palettes[PALETTE_BG];
+        for (int x = 0; x < SCREEN_WIDTH; x++) {
+            line[x] = bgp[colors[x]];
+        }
+    } else {
+        // background and window both off, the line is white under the sprites whatever BGP
+        // says, colour 0 everywhere so sprites behind the background still show
+        memset(colors, 0, sizeof(colors));
+        memset(line, 0, SCREEN_WIDTH);
+    }
+
+    if (lcdc & LCDC_OBJ_ON) render_sprites(p, lcdc, ly, colors, line);
+}
@@ -0,0 +1,58 @@
+#ifndef PPU_H
+#define PPU_H
+
+#include <stdint.h>
+
+#include "proc.h"
+
+/*
+ * Draws the screen a line at a time into Proc.framebuffer, each line is drawn when the lcd
+ * finishes mode 3 for it (io.c) so changes the game makes between lines show up like they
+ * would on the real screen. The framebuffer holds the shade (0 lightest -> 3 darkest) after
+ * the palettes, it's complete once vblank starts and ppu_end_frame publishes it to
+ * Proc.frames for the video thread.
+ */
+
+#define IO_SCY  0xFF42
+#define IO_SCX  0xFF43
+#define IO_BGP  0xFF47
+#define IO_OBP0 0xFF48
+#define IO_OBP1 0xFF49
+#define IO_WY   0xFF4A
+#define IO_WX   0xFF4B
+
+/* LCDC bits */
+#define LCDC_BG_ON          0x01
+#define LCDC_OBJ_ON         0x02
+#define LCDC_OBJ_TALL       0x04
+#define LCDC_BG_MAP         0x08
+#define LCDC_TILE_DATA      0x10
+#define LCDC_WINDOW_ON      0x20
+#define LCDC_WINDOW_MAP     0x40
+
+/* sprite attributes */
+#define OBJ_BEHIND_BG 0x80
+#define OBJ_FLIP_Y    0x40
+#define OBJ_FLIP_X    0x20
+#define OBJ_PALETTE   0x10
+
+#define OAM_START 0xFE00
+#define MAX_SPRITES 40
+// the most sprites the lcd can show on one line
+#define MAX_LINE_SPRITES 10
+
+// The gameboy screen buffer is larger than the visible screen
+#define BACKGROUND_H 256
+#define BACKGROUND_W 256
+
+// Proc.palettes, in the order of the registers from IO_BGP
+#define PALETTE_BG   0
+#define PALETTE_OBJ0 1
+#define PALETTE_OBJ1 2
+
+void ppu_write_palette(Proc * p, uint16_t address, uint8_t value);
+void ppu_start_frame(Proc * p);
+void ppu_render_line(Proc * p);
+void ppu_end_frame(Proc * p);
+
+#endif
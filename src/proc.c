@@ -1,4994 +1,982 @@
 // proc.c
+// needed for posix_memalign with -std=c99
+#define _POSIX_C_SOURCE 200112L
+
+#include <string.h>
+
 #include "proc.h"
 #include "memory.h"
+#include "opcodes.h"
+#include "idle.h"
+
+/* https:/www.pastraiser.com/cpu/gameboy/gameboy_opcodes.html */
+
+/*
+ * Every opcode is a handler (OpHandler in block.h) in one of the two tables at the bottom
+ * of this file. A handler returns 1 if it was a conditional JR/JP/CALL/RET that was taken so
+ * the step function can charge the taken cost from the opcode tables, 0 otherwise.
+ * Instructions are decoded into a MicroOp first and the bytes after the opcode are passed in
+ * as the operand.
+ */
+
+/*
+ * Defines a handler, PC is moved past the instruction before the body runs. The length is
+ * a constant in each handler rather than coming from the opcode tables so working out the
+ * next PC doesn't have to wait on loading the opcode.
+ */
+#define OPCODE(name, length) \
+    static inline int name##_body(Proc* p, uint16_t operand); \
+    static int name(Proc* p, uint16_t operand) { p->pc += length; return name##_body(p, operand); } \
+    static inline int name##_body(Proc* p, uint16_t operand)
 
-#define RESET_ZERO p->flagRegister.zero = CLEAR;
-#define SET_ZERO p->flagRegister.zero = SET;
+Proc* proc_create() {
+    // calloc only promises 16 byte alignment, the registers want their own cache line
+    Proc* p = NULL;
+    if (posix_memalign((void **) &p, CACHE_LINE, sizeof(Proc)) == 0) {
+        memset(p, 0, sizeof(Proc));
+        p->pc = 0x100;
+        p->sp = 0xFFFE;
+        p->skip_idle_loops = 1;
+        p->rom_map_bank[1] = 1;
+        triple_buffer_init(&p->frames);
+        p->framebuffer = p->frames.buffers[p->frames.back];
+        memory_reset_pages(p);
+        proc_initialize_memory(p);
+        io_init(p);
+        proc_enable_block_cache(p, 1);
+    }
+    return p;
+}
 
-#define RESET_SUBTRACT p->flagRegister.subtract = CLEAR;
-#define SET_SUBTRACT p->flagRegister.subtract = SET;
+void proc_delete(Proc* p) {
+    if (!p) return;
+    jit_delete(p->jit);
+    block_cache_delete(p->block_cache);
+    free(p);
+}
 
-#define RESET_HALF_CARRY p->flagRegister.half_carry = CLEAR;
-#define SET_HALF_CARRY p->flagRegister.half_carry = SET;
+/* ---------------------------------------------------------------------------------------
+ * helpers shared by the handlers
+ * --------------------------------------------------------------------------------------- */
 
-#define RESET_CARRY p->flagRegister.carry = CLEAR;
-#define SET_CARRY p->flagRegister.carry = SET;
+static inline uint16_t fetch_operand(Proc* p, uint16_t address) {
+    /* always reads the two bytes after the opcode, handlers only use what they need
+     * LITTLE ENDIAN, lower byte comes first
+     */
+    return get_16bit_value(read_byte(p, address + 2), read_byte(p, address + 1));
+}
 
-#define CHECK_AND_SET_ZERO(x) p->flagRegister.zero = (x == 0);
+static inline uint16_t get_bc(Proc* p) { return p->registers.bc; }
+static inline uint16_t get_de(Proc* p) { return p->registers.de; }
+static inline uint16_t get_hl(Proc* p) { return p->registers.hl; }
+
+static inline void set_bc(Proc* p, uint16_t value) { p->registers.bc = value; }
+static inline void set_de(Proc* p, uint16_t value) { p->registers.de = value; }
+static inline void set_hl(Proc* p, uint16_t value) { p->registers.hl = value; }
+
+/* sp and pc only exist as 16 bit values so just use the same naming for the macros below */
+static inline uint16_t get_sp(Proc* p) { return p->sp; }
+static inline void set_sp(Proc* p, uint16_t value) { p->sp = value; }
+
+/* ---------------------------------------------------------------------------------------
+ * flags
+ *
+ * ADD/ADC/SUB/SBC/CP/INC/DEC only store their operands and result in p->lazy, Z N H C are
+ * worked out when something reads them (conditional jumps, ADC/SBC, PUSH AF, DAA...) which is
+ * usually never since the next op overwrites them. F holds every flag the pending op doesn't
+ * write, so for INC/DEC the carry is still in F. Everything else is cheap enough to write F
+ * straight away.
+ * --------------------------------------------------------------------------------------- */
+
+static inline void resolve_flags(Proc* p) {
+    /* works out the flags of the pending op into F */
+    const LazyFlags * lazy = &p->lazy;
+    uint8_t f = p->registers.f;
+    uint8_t zero = (uint8_t) lazy->result ? 0 : FLAG_ZERO;
+
+    switch (lazy->op) {
+    case LAZY_NONE:
+        return;
+    case LAZY_ADD:
+        // Z 0 H C
+        f = zero
+          | (is_three_half_carry_add(lazy->a, lazy->b, lazy->carry) ? FLAG_HALF_CARRY : 0)
+          | (lazy->result > 0xFF ? FLAG_CARRY : 0);
+        break;
+    case LAZY_SUB:
+        // Z 1 H C
+        f = zero | FLAG_SUBTRACT
+          | (is_three_half_carry_sub(lazy->a, lazy->b, lazy->carry) ? FLAG_HALF_CARRY : 0)
+          | (lazy->result > 0xFF ? FLAG_CARRY : 0);
+        break;
+    case LAZY_INC:
+        // Z 0 H -, carried out of bit 3 if the lower 4 bits wrapped to 0
+        f = (f & FLAG_CARRY) | zero | ((lazy->result & 0x0F) == 0 ? FLAG_HALF_CARRY : 0);
+        break;
+    case LAZY_DEC:
+        // Z 1 H -
+        f = (f & FLAG_CARRY) | zero | FLAG_SUBTRACT | ((lazy->result & 0x0F) == 0x0F ? FLAG_HALF_CARRY : 0);
+        break;
+    }
 
-#define DECREMENT_AND_CHECK(x) \
-    if (is_half_carry_sub(x, 1)) {\
-        SET_HALF_CARRY;\
-    }\
-    x--;
+    p->registers.f = f;
+    p->lazy.op = LAZY_NONE;
+}
 
-#define INCREMENT_AND_CHECK(x) \
-    if (is_half_carry_add(x, 1)) {\
-        SET_HALF_CARRY;\
-    }\
-    x++;
+/* the conditions only need one flag, so don't work out the rest */
 
-#define SET_REG(A,B) \
-    *A = B;
-    
+static inline int flag_zero(Proc* p) {
+    if (p->lazy.op != LAZY_NONE) return (uint8_t) p->lazy.result == 0;
+    return (p->registers.f & FLAG_ZERO) != 0;
+}
 
-Proc* proc_create() {
-    Proc* p = calloc(1, sizeof(Proc));
-    if (p) {
-        p->pc = 0x100;
-        p->sp = 0xFFFE;
+static inline int flag_carry(Proc* p) {
+    // a subtract that borrowed wraps the 16 bit result above 0xFF too
+    if (p->lazy.op == LAZY_ADD || p->lazy.op == LAZY_SUB) return p->lazy.result > 0xFF;
+    return (p->registers.f & FLAG_CARRY) != 0;
+}
+
+static inline void set_flags(Proc* p, uint8_t f) {
+    /* for ops that write all four flags */
+    p->registers.f = f;
+    p->lazy.op = LAZY_NONE;
+}
+
+static inline void update_flags(Proc* p, uint8_t keep, uint8_t f) {
+    /* for ops that only write some of the flags, keep is the ones left alone */
+    resolve_flags(p);
+    p->registers.f = (p->registers.f & keep) | f;
+}
+
+static inline uint8_t lazy_add(Proc* p, uint8_t a, uint8_t b, uint8_t carry) {
+    p->lazy.op = LAZY_ADD;
+    p->lazy.a = a;
+    p->lazy.b = b;
+    p->lazy.carry = carry;
+    p->lazy.result = a + b + carry;
+    return p->lazy.result;
+}
+
+static inline uint8_t lazy_sub(Proc* p, uint8_t a, uint8_t b, uint8_t carry) {
+    p->lazy.op = LAZY_SUB;
+    p->lazy.a = a;
+    p->lazy.b = b;
+    p->lazy.carry = carry;
+    p->lazy.result = a - b - carry;
+    return p->lazy.result;
+}
+
+static inline uint8_t lazy_inc_dec(Proc* p, uint8_t op, uint8_t result) {
+    // INC/DEC keep the carry, so a pending add/sub has to leave its carry in F first
+    if (p->lazy.op == LAZY_ADD || p->lazy.op == LAZY_SUB) {
+        p->registers.f = (p->registers.f & ~FLAG_CARRY) | (p->lazy.result > 0xFF ? FLAG_CARRY : 0);
     }
-    proc_initialize_memory(p);
-    return p;
+
+    p->lazy.op = op;
+    p->lazy.result = result;
+    return result;
 }
 
-void proc_delete(Proc* p) {
-    if (!p) return;
-    free(p);
+uint8_t proc_get_f(Proc* p) {
+    /* the flags in the layout of the F register, Z N H C 0 0 0 0 */
+    resolve_flags(p);
+    return p->registers.f;
 }
 
-void proc_read_word(Proc *p) {
-    if (!p) return;
+void proc_set_f(Proc* p, uint8_t f) {
+    // lower 4 bits of F always read back as 0
+    set_flags(p, f & 0xF0);
+}
 
-    uint8_t eightbit_opcode = p->memory[p->pc];
-    /* set a variable instead of just ++ -- to account for changing PC value as inst */
-    int bytes_ate = 1;
-
-    /* the next 8 bits of data */
-    uint8_t d8 = 0;
-
-    uint8_t value_in_memory = 0;
-
-    uint16_t combined_value = 0;
-
-    /* https:/www.pastraiser.com/cpu/gameboy/gameboy_opcodes.html */
-    /* LITTLE ENDIAN I THINK */
-    switch (eightbit_opcode) {
-        case 0x0:
-            //  NOP
-            // 1 4
-            // - - - -
-            debug_print("NOP\n", NULL);
-			break;
-        case 0x1:
-            // LD BC,d16
-            // 3 12
-            // - - - -
-            debug_print("LD BC,d16\n", NULL);
-            /* Assuming B is most significant... so c gets first byte and B gets second */
-            SET_REG(&p->registers.c, p->memory[p->pc + 1]);
-            SET_REG(&p->registers.b, p->memory[p->pc + 2]);
-            bytes_ate = 3;
-			break;
-        case 0x2:
-            // LD (BC),A
-            // 1 8
-            // - - - -
-            debug_print("LD (BC),A\n", NULL);
-            write_byte(p, ((uint16_t)p->registers.b << 8) + (uint16_t)p->registers.c, p->registers.a);
-			break;
-        case 0x3:
-            // INC BC
-            // 1 8
-            // - - - -
-            debug_print("INC BC\n", NULL);
-            combined_value = get_16bit_value(p->registers.b, p->registers.c);
-            combined_value ++;
-            SET_REG(&p->registers.b, get_upper_8bit_value(combined_value));
-            SET_REG(&p->registers.c, get_lower_8bit_value(combined_value));
-			break;
-        case 0x4:
-            // INC B
-            // 1 4
-            // Z 0 H -
-            RESET_SUBTRACT;
-
-            debug_print("INC B\n", NULL);
-            INCREMENT_AND_CHECK(p->registers.b);
-            CHECK_AND_SET_ZERO(p->registers.b);
-			break;
-        case 0x5:
-            // DEC B
-            // 1 4
-            // Z 1 H -
-            SET_SUBTRACT;
-
-            debug_print("DEC B\n", NULL);
-            DECREMENT_AND_CHECK(p->registers.b);
-            CHECK_AND_SET_ZERO(p->registers.b);
-			break;
-        case 0x6:
-            // LD B,d8
-            // 2 8
-            // - - - -
-            SET_REG(&p->registers.b, p->memory[p->pc+1]);
-            bytes_ate = 2;
-            debug_print("LD B,d8\n", NULL);
-			break;
-        case 0x7: {
-            //  RLCA
-            // 1 4
-            // 0 0 0 C
-            RESET_SUBTRACT;
-            RESET_HALF_CARRY;
-
-            // grab carry bit
-            uint8_t c = p->registers.a >> 7;
-            // shift left 1 and drop carry on thurrr
-            SET_REG(&p->registers.a, (p->registers.a << 1) | c);
-
-            // set extra flags
-            p->flagRegister.carry = c;
-            p->flagRegister.zero = (p->registers.a == 0);
-
-            debug_print("RLCA\n", NULL);
-			break;
-        }
-        case 0x8:
-            // LD (a16),SP
-            // 3 20
-            // - - - -
-            debug_print("LD (a16),SP\n", NULL);
-            write_byte(
-                p,
-                p->memory[p->pc + 1] + (p->memory[p->pc + 2] << 8),
-                p->sp
-            );
-			break;
-        case 0x9:
-            // ADD HL,BC
-            // 1 8
-            // - 0 H C
-            RESET_SUBTRACT;
-            debug_print("ADD HL,BC\n", NULL);
-			break;
-        case 0xA:
-            // LD A,(BC)
-            // 1 8
-            // - - - -
-            SET_REG(&p->registers.a,
-            p->memory[(uint16_t)p->registers.c+(uint16_t)(p->registers.b<<8)]);
-            debug_print("LD A,(BC)\n", NULL);
-			break;
-        case 0xB:
-            // DEC BC
-            // 1 8
-            // - - - -
-            debug_print("DEC BC\n", NULL);
-            combined_value = get_16bit_value(p->registers.b, p->registers.c);
-            combined_value --;
-            SET_REG(&p->registers.b, get_upper_8bit_value(combined_value));
-            SET_REG(&p->registers.c, get_lower_8bit_value(combined_value));
-			break;
-        case 0xC:
-            // INC C
-            // 1 4
-            // Z 0 H -
-            RESET_SUBTRACT;
-
-            debug_print("INC C\n", NULL);
-            INCREMENT_AND_CHECK(p->registers.c);
-            CHECK_AND_SET_ZERO(p->registers.c);
-			break;
-        case 0xD:
-            // DEC C
-            // 1 4
-            // Z 1 H -
-            SET_SUBTRACT;
-
-            debug_print("DEC C\n", NULL);
-            DECREMENT_AND_CHECK(p->registers.c);
-            CHECK_AND_SET_ZERO(p->registers.c);
-			break;
-        case 0xE:
-            // LD C,d8
-            // 2 8
-            // - - - -
-            SET_REG(&p->registers.c, p->memory[p->pc + 1]);
-            bytes_ate = 2;
-            debug_print("LD C,d8\n", NULL);
-			break;
-        case 0xF: {
-            //  RRCA
-            // 1 4
-            // 0 0 0 C
-            RESET_SUBTRACT;
-            RESET_HALF_CARRY;
-
-            uint8_t c = p->registers.a & 0x01; // right bit
-            SET_REG(&p->registers.a, (p->registers.a >> 1) | (c << 7));
-
-            p->flagRegister.zero  = (p->registers.a == 0);
-            p->flagRegister.carry = c;
-            debug_print("RRCA\n", NULL);
-			break;
-        }
-        case 0x10:
-            // STOP 0
-            // 2 4
-            // - - - -
-            debug_print("STOP 0\n", NULL);
-			break;
-        case 0x11:
-            // LD DE,d16
-            // 3 12
-            // - - - -
-            SET_REG(&p->registers.e, p->memory[p->pc + 1]);
-            SET_REG(&p->registers.d, p->memory[p->pc + 2]);
-            bytes_ate = 3;
-            debug_print("LD DE,d16\n", NULL);
-			break;
-        case 0x12:
-            // LD (DE),A
-            // 1 8
-            // - - - -
-            write_byte(p, ((uint16_t)p->registers.d << 8) + (uint16_t)p->registers.e, p->registers.a);
-            debug_print("LD (DE),A\n", NULL);
-	    break;
-        case 0x13:
-            // INC DE
-            // 1 8
-            // - - - -
-            debug_print("INC DE\n", NULL);
-            combined_value = get_16bit_value(p->registers.d, p->registers.e);
-            combined_value ++;
-            SET_REG(&p->registers.d, get_upper_8bit_value(combined_value));
-            SET_REG(&p->registers.e, get_lower_8bit_value(combined_value));
-			break;
-        case 0x14:
-            // INC D
-            // 1 4
-            // Z 0 H -
-            RESET_SUBTRACT;
-
-            debug_print("INC D\n", NULL);
-            INCREMENT_AND_CHECK(p->registers.d);
-            CHECK_AND_SET_ZERO(p->registers.d);
-			break;
-        case 0x15:
-            // DEC D
-            // 1 4
-            // Z 1 H -
-            SET_SUBTRACT;
-
-            debug_print("DEC D\n", NULL);
-            DECREMENT_AND_CHECK(p->registers.d);
-            CHECK_AND_SET_ZERO(p->registers.d);
-			break;
-        case 0x16:
-            // LD D,d8
-            // 2 8
-            // - - - -
-            SET_REG(&p->registers.d, p->memory[p->pc + 1]);
-            bytes_ate = 2;
-            debug_print("LD D,d8\n", NULL);
-			break;
-        case 0x17: {
-            //  RLA
-            // 1 4
-            // 0 0 0 C
-            RESET_SUBTRACT;
-            RESET_HALF_CARRY;
-            // shift to get carry
-            uint8_t c = p->registers.a >> 7;
-            // left 1 and then move old carry bit into bit 0
-            SET_REG(&p->registers.a, (p->registers.a << 1) | p->flagRegister.carry);
-
-            p->flagRegister.zero = (p->registers.a == 0);
-            p->flagRegister.carry = c;
-            debug_print("RLA\n", NULL);
-			break;
-        }
-        case 0x18:
-            // JR r8
-            // 2 12
-            // - - - -
-            debug_print("JR r8\n", NULL);
-            p->pc += (int8_t) p->memory[p->pc + 1];
-            bytes_ate = 0;
-			break;
-        case 0x19:
-            // ADD HL,DE
-            // 1 8
-            // - 0 H C
-            RESET_SUBTRACT;
-            debug_print("ADD HL,DE\n", NULL);
-			break;
-        case 0x1A:
-            // LD A,(DE)
-            // 1 8
-            // - - - -
-            debug_print("LD A,(DE)\n", NULL);
-            SET_REG(&p->registers.a, p->memory[(uint16_t)p->registers.e + ((uint16_t)p->registers.d << 8)]);
-            SET_REG(&p->registers.a, p->memory[(uint16_t)p->registers.e+((uint16_t)p->registers.d << 8)]);
-			break;
-        case 0x1B:
-            // DEC DE
-            // 1 8
-            // - - - -
-            debug_print("DEC DE\n", NULL);
-            combined_value = get_16bit_value(p->registers.d, p->registers.e);
-            combined_value --;
-            SET_REG(&p->registers.d, get_upper_8bit_value(combined_value));
-            SET_REG(&p->registers.e, get_lower_8bit_value(combined_value));
-			break;
-        case 0x1C:
-            // INC E
-            // 1 4
-            // Z 0 H -
-            RESET_SUBTRACT;
-
-            debug_print("INC E\n", NULL);
-            INCREMENT_AND_CHECK(p->registers.e);
-            CHECK_AND_SET_ZERO(p->registers.e);
-			break;
-        case 0x1D:
-            // DEC E
-            // 1 4
-            // Z 1 H -
-            SET_SUBTRACT;
-
-            debug_print("DEC E\n", NULL);
-            DECREMENT_AND_CHECK(p->registers.e);
-            CHECK_AND_SET_ZERO(p->registers.e);
-			break;
-        case 0x1E:
-            // LD E,d8
-            // 2 8
-            // - - - -
-            SET_REG(&p->registers.e, p->memory[p->pc + 1]);
-            bytes_ate = 2;
-            debug_print("LD E,d8\n", NULL);
-			break;
-        case 0x1F: {
-            //  RRA
-            // 1 4
-            // 0 0 0 C
-            RESET_SUBTRACT;
-            RESET_HALF_CARRY;
-
-            uint8_t      c = p->registers.a & 0x01;
-            SET_REG(&p->registers.a, (p->registers.a >> 1) | (p->flagRegister.carry << 7));
-
-            p->flagRegister.zero  = (p->registers.a == 0);
-            p->flagRegister.carry = c;
-            debug_print("RRA\n", NULL);
-			break;
-        }
-        case 0x20:
-            // JR NZ,r8
-            // 2 12/8
-            // - - - -
-            debug_print("JR NZ,r8\n", NULL);
-            if (!p->flagRegister.zero) {
-                p->pc += (int8_t)p->memory[p->pc + 1];
-                bytes_ate = 0;
-            }
-			break;
-        case 0x21:
-            // LD HL,d16
-            // 3 12
-            // - - - -
-            SET_REG(&p->registers.l, p->memory[p->pc + 1]);
-            SET_REG(&p->registers.h, p->memory[p->pc + 2]);
-            bytes_ate = 3;
-            debug_print("LD HL,d16\n", NULL);
-			break;
-        case 0x22:
-            // LD (HL+),A
-            // 1 8
-            // - - - -
-            debug_print("LD (HL+),A\n", NULL);
-            write_byte(p, ((uint16_t)p->registers.h << 8) + (uint16_t)p->registers.l, p->registers.a);
-            proc_inc_hl(p);
-			break;
-        case 0x23:
-            // INC HL
-            // 1 8
-            // - - - -
-            debug_print("INC HL\n", NULL);
-            combined_value = get_16bit_value(p->registers.h, p->registers.l);
-            combined_value ++;
-            SET_REG(&p->registers.h, get_upper_8bit_value(combined_value));
-            SET_REG(&p->registers.l, get_lower_8bit_value(combined_value));
-			break;
-        case 0x24:
-            // INC H
-            // 1 4
-            // Z 0 H -
-            RESET_SUBTRACT;
-
-            debug_print("INC H\n", NULL);
-            INCREMENT_AND_CHECK(p->registers.h);
-            CHECK_AND_SET_ZERO(p->registers.h);
-			break;
-        case 0x25:
-            // DEC H
-            // 1 4
-            // Z 1 H -
-            SET_SUBTRACT;
-
-            debug_print("DEC H\n", NULL);
-            DECREMENT_AND_CHECK(p->registers.h);
-            CHECK_AND_SET_ZERO(p->registers.h);
-			break;
-        case 0x26:
-            // LD H,d8
-            // 2 8
-            // - - - -
-            SET_REG(&p->registers.h, p->memory[p->pc + 1]);
-            
-            bytes_ate = 2;
-            debug_print("LD H,d8\n", NULL);
-			break;
-        case 0x27:
-            //  DAA
-            // 1 4
-            // Z - 0 C
-            RESET_HALF_CARRY;
-
-            debug_print("DAA\n", NULL);
-			break;
-        case 0x28:
-            // JR Z,r8
-            // 2 12/8
-            // - - - -
-            debug_print("JR Z,r8\n", NULL);
-            if (p->flagRegister.zero) {
-                p->pc += (int8_t) p->memory[p->pc + 1];
-                bytes_ate = 0;
-            }
-			break;
-        case 0x29:
-            // ADD HL,HL
-            // 1 8
-            // - 0 H C
-            RESET_SUBTRACT;
-
-            debug_print("ADD HL,HL\n", NULL);
-			break;
-        case 0x2A:
-            // LD A,(HL+)
-            // 1 8
-            // - - - -
-            debug_print("LD A,(HL+)\n", NULL);
-            SET_REG(&p->registers.a, p->memory[((uint16_t)p->registers.h << 8) + (uint16_t)(p->registers.l)]);
-            proc_inc_hl(p);
-			break;
-        case 0x2B:
-            // DEC HL
-            // 1 8
-            // - - - -
-            debug_print("DEC HL\n", NULL);
-            combined_value = get_16bit_value(p->registers.h, p->registers.l);
-            combined_value --;
-            SET_REG(&p->registers.h, get_upper_8bit_value(combined_value));
-            SET_REG(&p->registers.l, get_lower_8bit_value(combined_value));
-			break;
-        case 0x2C:
-            // INC L
-            // 1 4
-            // Z 0 H -
-            RESET_SUBTRACT;
-
-            debug_print("INC L\n", NULL);
-            INCREMENT_AND_CHECK(p->registers.l);
-            CHECK_AND_SET_ZERO(p->registers.l);
-			break;
-        case 0x2D:
-            // DEC L
-            // 1 4
-            // Z 1 H -
-            SET_SUBTRACT;
-
-            debug_print("DEC L\n", NULL);
-            DECREMENT_AND_CHECK(p->registers.l);
-            CHECK_AND_SET_ZERO(p->registers.l);
-			break;
-        case 0x2E:
-            // LD L,d8
-            // 2 8
-            // - - - -
-            SET_REG(&p->registers.l, p->memory[p->pc + 1]);
-            bytes_ate = 2;
-            debug_print("LD L,d8\n", NULL);
-			break;
-        case 0x2F:
-            //  CPL
-            // 1 4
-            // - 1 1 -
-            SET_SUBTRACT;
-            SET_HALF_CARRY;
-            SET_REG(&p->registers.a, ~p->registers.a);
-            debug_print("CPL\n", NULL);
-			break;
-        case 0x30:
-            // JR NC,r8
-            // 2 12/8
-            // - - - -
-            debug_print("JR NC,r8\n", NULL);
-            if (!p->flagRegister.carry) {
-                p->pc += (int8_t) p->memory[p->pc + 1];
-                bytes_ate = 0;
-            }
-			break;
-        case 0x31:
-            // LD SP,d16
-            // 3 12
-            // - - - -
-            debug_print("LD SP,d16\n", NULL);
-            p->sp = p->memory[p->pc + 1] + (p->memory[p->pc + 2] << 8);
-            bytes_ate = 3;
-			break;
-        case 0x32:
-            // LD (HL-),A
-            // 1 8
-            // - - - -
-            debug_print("LD (HL-),A\n", NULL);
-            write_byte(p, ((uint16_t)p->registers.h << 8) + (uint16_t)p->registers.l, p->registers.a);
-            proc_dec_hl(p);
-			break;
-        case 0x33:
-            // INC SP
-            // 1 8
-            // - - - -
-            debug_print("INC SP\n", NULL);
-            p->sp ++;
-			break;
-        case 0x34:
-            // INC (HL)
-            // 1 12
-            // Z 0 H -
-            RESET_SUBTRACT;
-            combined_value = get_16bit_value(p->registers.h, p->registers.l);
-            value_in_memory = p->memory[combined_value];
-            INCREMENT_AND_CHECK(value_in_memory);
-            write_byte(p, combined_value, value_in_memory);
-            debug_print("INC (HL)\n", NULL);
-			break;
-        case 0x35:
-            // DEC (HL)
-            // 1 12
-            // Z 1 H -
-            SET_SUBTRACT;
-            combined_value = get_16bit_value(p->registers.h, p->registers.l);
-            value_in_memory = p->memory[combined_value];
-            DECREMENT_AND_CHECK(value_in_memory);
-            write_byte(p, combined_value, value_in_memory);
-            debug_print("DEC (HL)\n", NULL);
-			break;
-        case 0x36:
-            // LD (HL),d8
-            // 2 12
-            // - - - -
-            debug_print("LD (HL),d8\n", NULL);
-            write_byte(p, ((uint16_t)p->registers.h << 8) + (uint16_t)p->registers.l, p->memory[p->pc + 1]);
-            bytes_ate = 2;
-			break;
-        case 0x37:
-            //  SCF
-            // 1 4
-            // - 0 0 1
-            RESET_SUBTRACT;
-            RESET_HALF_CARRY;
-            SET_CARRY;
-            debug_print("SCF\n", NULL);
-			break;
-        case 0x38:
-            // JR C,r8
-            // 2 12/8
-            // - - - -
-            debug_print("JR C,r8\n", NULL);
-            if (p->flagRegister.carry) {
-                p->pc += (int8_t) p->memory[p->pc + 1];
-                bytes_ate = 0;
-            }
-			break;
-        case 0x39:
-            // ADD HL,SP
-            // 1 8
-            // - 0 H C
-            debug_print("ADD HL,SP\n", NULL);
-			break;
-        case 0x3A:
-            // LD A,(HL-)
-            // 1 8
-            // - - - -
-            debug_print("LD A,(HL-)\n", NULL);
-            SET_REG(&p->registers.a, p->memory[((uint16_t)p->registers.h << 8) + (uint16_t)(p->registers.l)]);
-            proc_dec_hl(p);
-            break;
-        case 0x3B:
-            // DEC SP
-            // 1 8
-            // - - - -
-            debug_print("DEC SP\n", NULL);
-            p->sp --;
-			break;
-        case 0x3C:
-            // INC A
-            // 1 4
-            // Z 0 H -
-            RESET_SUBTRACT;
-            debug_print("INC A\n", NULL);
-            INCREMENT_AND_CHECK(p->registers.a);
-            CHECK_AND_SET_ZERO(p->registers.a);
-			break;
-        case 0x3D:
-            // DEC A
-            // 1 4
-            // Z 1 H -
-            SET_SUBTRACT;
-
-            debug_print("DEC A\n", NULL);
-            DECREMENT_AND_CHECK(p->registers.a);
-            CHECK_AND_SET_ZERO(p->registers.a);
-			break;
-        case 0x3E:
-            // LD A,d8
-            // 2 8
-            // - - - -
-            debug_print("LD A,d8\n", NULL);
-            SET_REG(&p->registers.a, p->memory[p->pc + 1]);
-            bytes_ate = 2;
-			break;
-        case 0x3F:
-            //  CCF
-            // 1 4
-            // - 0 0 C
-            RESET_SUBTRACT;
-            RESET_HALF_CARRY;
-            p->flagRegister.carry = !p->flagRegister.carry;
-            debug_print("CCF\n", NULL);
-			break;
-        case 0x40:
-            // LD B,B
-            // 1 4
-            // - - - -
-            SET_REG(&p->registers.b,p->registers.b);
-            debug_print("LD B,B\n", NULL);
-			break;
-        case 0x41:
-            // LD B,C
-            // 1 4
-            // - - - -
-            SET_REG(&p->registers.b,p->registers.c);
-            debug_print("LD B,C\n", NULL);
-			break;
-        case 0x42:
-            // LD B,D
-            // 1 4
-            // - - - -
-            SET_REG(&p->registers.b,p->registers.d);
-            debug_print("LD B,D\n", NULL);
-			break;
-        case 0x43:
-            // LD B,E
-            // 1 4
-            // - - - -
-            SET_REG(&p->registers.b,p->registers.e);
-            debug_print("LD B,E\n", NULL);
-			break;
-        case 0x44:
-            // LD B,H
-            // 1 4
-            // - - - -
-            debug_print("LD B,H\n", NULL);
-			break;
-        case 0x45:
-            // LD B,L
-            // 1 4
-            // - - - -
-            SET_REG(&p->registers.b,p->registers.l);
-            debug_print("LD B,L\n", NULL);
-			break;
-        case 0x46:
-            // LD B,(HL)
-            // 1 8
-            // - - - -
-            SET_REG(&p->registers.b, p->memory[((uint16_t)p->registers.h << 8) + (uint16_t)(p->registers.l)]);
-            debug_print("LD B,(HL)\n", NULL);
-			break;
-        case 0x47:
-            // LD B,A
-            // 1 4
-            // - - - -
-            SET_REG(&p->registers.b,p->registers.a);
-            debug_print("LD B,A\n", NULL);
-			break;
-        case 0x48:
-            // LD C,B
-            // 1 4
-            // - - - -
-            SET_REG(&p->registers.c,p->registers.b);
-            debug_print("LD C,B\n", NULL);
-			break;
-        case 0x49:
-            // LD C,C
-            // 1 4
-            // - - - -
-            SET_REG(&p->registers.c,p->registers.c);
-            debug_print("LD C,C\n", NULL);
-			break;
-        case 0x4A:
-            // LD C,D
-            // 1 4
-            // - - - -
-            SET_REG(&p->registers.c,p->registers.d);
-            debug_print("LD C,D\n", NULL);
-			break;
-        case 0x4B:
-            // LD C,E
-            // 1 4
-            // - - - -
-            SET_REG(&p->registers.c,p->registers.e);
-            debug_print("LD C,E\n", NULL);
-			break;
-        case 0x4C:
-            // LD C,H
-            // 1 4
-            // - - - -
-            SET_REG(&p->registers.c,p->registers.h);
-            debug_print("LD C,H\n", NULL);
-			break;
-        case 0x4D:
-            // LD C,L
-            // 1 4
-            // - - - -
-            SET_REG(&p->registers.c,p->registers.l);
-            debug_print("LD C,L\n", NULL);
-			break;
-        case 0x4E:
-            // LD C,(HL)
-            // 1 8
-            // - - - -
-            SET_REG(&p->registers.c, p->memory[((uint16_t)p->registers.h << 8) + (uint16_t)(p->registers.l)]);
-            debug_print("LD C,(HL)\n", NULL);
-			break;
-        case 0x4F:
-            // LD C,A
-            // 1 4
-            // - - - -
-            SET_REG(&p->registers.c,p->registers.a);
-            debug_print("LD C,A\n", NULL);
-			break;
-        case 0x50:
-            // LD D,B
-            // 1 4
-            // - - - -
-            SET_REG(&p->registers.d,p->registers.b);
-            debug_print("LD D,B\n", NULL);
-			break;
-        case 0x51:
-            // LD D,C
-            // 1 4
-            // - - - -
-            SET_REG(&p->registers.d,p->registers.c);
-            debug_print("LD D,C\n", NULL);
-			break;
-        case 0x52:
-            // LD D,D
-            // 1 4
-            // - - - -
-            SET_REG(&p->registers.d,p->registers.d);
-            debug_print("LD D,D\n", NULL);
-			break;
-        case 0x53:
-            // LD D,E
-            // 1 4
-            // - - - -
-            SET_REG(&p->registers.d,p->registers.e);
-            debug_print("LD D,E\n", NULL);
-			break;
-        case 0x54:
-            // LD D,H
-            // 1 4
-            // - - - -
-            SET_REG(&p->registers.d,p->registers.h);
-            debug_print("LD D,H\n", NULL);
-			break;
-        case 0x55:
-            // LD D,L
-            // 1 4
-            // - - - -
-            SET_REG(&p->registers.d,p->registers.l);
-            debug_print("LD D,L\n", NULL);
-			break;
-        case 0x56:
-            // LD D,(HL)
-            // 1 8
-            // - - - -
-            SET_REG(&p->registers.d, p->memory[((uint16_t)p->registers.h << 8) + (uint16_t)(p->registers.l)]);
-            debug_print("LD D,(HL)\n", NULL);
-			break;
-        case 0x57:
-            // LD D,A
-            // 1 4
-            // - - - -
-            debug_print("LD D,A\n", NULL);
-            SET_REG(&p->registers.d,p->registers.a);
-			break;
-        case 0x58:
-            // LD E,B
-            // 1 4
-            // - - - -
-            SET_REG(&p->registers.e,p->registers.b);
-            debug_print("LD E,B\n", NULL);
-			break;
-        case 0x59:
-            // LD E,C
-            // 1 4
-            // - - - -
-            SET_REG(&p->registers.e,p->registers.c);
-            debug_print("LD E,C\n", NULL);
-			break;
-        case 0x5A:
-            // LD E,D
-            // 1 4
-            // - - - -
-            SET_REG(&p->registers.e,p->registers.d);
-            debug_print("LD E,D\n", NULL);
-			break;
-        case 0x5B:
-            // LD E,E
-            // 1 4
-            // - - - -
-            SET_REG(&p->registers.e,p->registers.e);
-            debug_print("LD E,E\n", NULL);
-			break;
-        case 0x5C:
-            // LD E,H
-            // 1 4
-            // - - - -
-            SET_REG(&p->registers.e,p->registers.h);
-            debug_print("LD E,H\n", NULL);
-			break;
-        case 0x5D:
-            // LD E,L
-            // 1 4
-            // - - - -
-            SET_REG(&p->registers.e,p->registers.l);
-            debug_print("LD E,L\n", NULL);
-			break;
-        case 0x5E:
-            // LD E,(HL)
-            // 1 8
-            // - - - -
-            SET_REG(&p->registers.e, p->memory[((uint16_t)p->registers.h << 8) + (uint16_t)(p->registers.l)]);
-            debug_print("LD E,(HL)\n", NULL);
-			break;
-        case 0x5F:
-            // LD E,A
-            // 1 4
-            // - - - -
-            SET_REG(&p->registers.e,p->registers.a);
-            debug_print("LD E,A\n", NULL);
-			break;
-        case 0x60:
-            // LD H,B
-            // 1 4
-            // - - - -
-            SET_REG(&p->registers.h,p->registers.b);
-            debug_print("LD H,B\n", NULL);
-			break;
-        case 0x61:
-            // LD H,C
-            // 1 4
-            // - - - -
-            SET_REG(&p->registers.h,p->registers.c);
-            debug_print("LD H,C\n", NULL);
-			break;
-        case 0x62:
-            // LD H,D
-            // 1 4
-            // - - - -
-            SET_REG(&p->registers.h,p->registers.d);
-            debug_print("LD H,D\n", NULL);
-			break;
-        case 0x63:
-            // LD H,E
-            // 1 4
-            // - - - -
-            SET_REG(&p->registers.h,p->registers.e);
-            debug_print("LD H,E\n", NULL);
-			break;
-        case 0x64:
-            // LD H,H
-            // 1 4
-            // - - - -
-            SET_REG(&p->registers.h,p->registers.h);
-            debug_print("LD H,H\n", NULL);
-			break;
-        case 0x65:
-            // LD H,L
-            // 1 4
-            // - - - -
-            SET_REG(&p->registers.h,p->registers.l);
-            debug_print("LD H,L\n", NULL);
-			break;
-        case 0x66:
-            // LD H,(HL)
-            // 1 8
-            // - - - -
-            SET_REG(&p->registers.h, p->memory[((uint16_t)p->registers.h << 8) + (uint16_t)(p->registers.l)]);
-            debug_print("LD H,(HL)\n", NULL);
-			break;
-        case 0x67:
-            // LD H,A
-            // 1 4
-            // - - - -
-            SET_REG(&p->registers.h,p->registers.a);
-            debug_print("LD H,A\n", NULL);
-			break;
-        case 0x68:
-            // LD L,B
-            // 1 4
-            // - - - -
-            SET_REG(&p->registers.l,p->registers.b);
-            debug_print("LD L,B\n", NULL);
-			break;
-        case 0x69:
-            // LD L,C
-            // 1 4
-            // - - - -
-            SET_REG(&p->registers.l,p->registers.c);
-            debug_print("LD L,C\n", NULL);
-			break;
-        case 0x6A:
-            // LD L,D
-            // 1 4
-            // - - - -
-            debug_print("LD L,D\n", NULL);
-            SET_REG(&p->registers.l,p->registers.d);
-			break;
-        case 0x6B:
-            // LD L,E
-            // 1 4
-            // - - - -
-            debug_print("LD L,E\n", NULL);
-            SET_REG(&p->registers.l,p->registers.e);
-			break;
-        case 0x6C:
-            // LD L,H
-            // 1 4
-            // - - - -
-            debug_print("LD L,H\n", NULL);
-            SET_REG(&p->registers.l,p->registers.h);
-			break;
-        case 0x6D:
-            // LD L,L
-            // 1 4
-            // - - - -
-            debug_print("LD L,L\n", NULL);
-            SET_REG(&p->registers.l,p->registers.l);
-			break;
-        case 0x6E:
-            // LD L,(HL)
-            // 1 8
-            // - - - -
-            SET_REG(&p->registers.l, p->memory[((uint16_t)p->registers.h << 8) + (uint16_t)(p->registers.l)]);
-            debug_print("LD L,(HL)\n", NULL);
-			break;
-        case 0x6F:
-            // LD L,A
-            // 1 4
-            // - - - -
-            debug_print("LD L,A\n", NULL);
-            SET_REG(&p->registers.l,p->registers.a);
-			break;
-        case 0x70:
-            // LD (HL),B
-            // 1 8
-            // - - - -
-            write_byte(p, p->registers.l + (p->registers.h << 8), p->registers.b);
-            debug_print("LD (HL),B\n", NULL);
-			break;
-        case 0x71:
-            // LD (HL),C
-            // 1 8
-            // - - - -
-            write_byte(p, (uint16_t)p->registers.l + ((uint16_t)p->registers.h << 8), p->registers.c);
-            debug_print("LD (HL),C\n", NULL);
-			break;
-        case 0x72:
-            // LD (HL),D
-            // 1 8
-            // - - - -
-            write_byte(p, (uint16_t)p->registers.l + ((uint16_t)p->registers.h << 8), p->registers.d);
-            debug_print("LD (HL),D\n", NULL);
-			break;
-        case 0x73:
-            // LD (HL),E
-            // 1 8
-            // - - - -
-            write_byte(p, (uint16_t)p->registers.l + ((uint16_t)p->registers.h << 8), p->registers.e);
-            debug_print("LD (HL),E\n", NULL);
-			break;
-        case 0x74:
-            // LD (HL),H
-            // 1 8
-            // - - - -
-            write_byte(p, (uint16_t)p->registers.l + ((uint16_t)p->registers.h << 8), p->registers.h);
-            debug_print("LD (HL),H\n", NULL);
-			break;
-        case 0x75:
-            // LD (HL),L
-            // 1 8
-            // - - - -
-            write_byte(p, (uint16_t)p->registers.l + ((uint16_t)p->registers.h << 8), p->registers.l);
-            debug_print("LD (HL),L\n", NULL);
-			break;
-        case 0x76:
-            //  HALT
-            // 1 4
-            // - - - -
-            debug_print("HALT\n", NULL);
-			break;
-        case 0x77:
-            // LD (HL),A
-            // 1 8
-            // - - - -
-            debug_print("LD (HL),A\n", NULL);
-            write_byte(p, (uint16_t)p->registers.l + ((uint16_t)p->registers.h << 8), p->registers.a);
-			break;
-        case 0x78:
-            // LD A,B
-            // 1 4
-            // - - - -
-            debug_print("LD A,B\n", NULL);
-            SET_REG(&p->registers.a,p->registers.b);
-			break;
-        case 0x79:
-            // LD A,C
-            // 1 4
-            // - - - -
-            debug_print("LD A,C\n", NULL);
-            SET_REG(&p->registers.a,p->registers.c);
-			break;
-        case 0x7A:
-            // LD A,D
-            // 1 4
-            // - - - -
-            debug_print("LD A,D\n", NULL);
-            SET_REG(&p->registers.a,p->registers.d);
-			break;
-        case 0x7B:
-            // LD A,E
-            // 1 4
-            // - - - -
-            debug_print("LD A,E\n", NULL);
-            SET_REG(&p->registers.a,p->registers.e);
-			break;
-        case 0x7C:
-            // LD A,H
-            // 1 4
-            // - - - -
-            debug_print("LD A,H\n", NULL);
-            SET_REG(&p->registers.a,p->registers.h);
-			break;
-        case 0x7D:
-            // LD A,L
-            // 1 4
-            // - - - -
-            debug_print("LD A,L\n", NULL);
-            SET_REG(&p->registers.a,p->registers.l);
-			break;
-        case 0x7E:
-            // LD A,(HL)
-            // 1 8
-            // - - - -
-            SET_REG(&p->registers.a, p->memory[((uint16_t)p->registers.h << 8) + (uint16_t)(p->registers.l)]);
-            debug_print("LD A,(HL)\n", NULL);
-			break;
-        case 0x7F:
-            // LD A,A
-            // 1 4
-            // - - - -
-            SET_REG(&p->registers.a,p->registers.a);
-            debug_print("LD A,A\n", NULL);
-			break;
-        case 0x80:
-            // ADD A,B
-            // 1 4
-            // Z 0 H C
-            debug_print("ADD A,B\n", NULL);
-            p->flagRegister.half_carry = is_half_carry_add(p->registers.a, p->registers.b);
-            p->flagRegister.carry = 0xFF < ((uint16_t) p->registers.a + (uint16_t) p->registers.b);
-
-            p->registers.a += p->registers.b;
-
-			CHECK_AND_SET_ZERO(p->registers.a);
-            RESET_SUBTRACT;
-			break;
-        case 0x81:
-            // ADD A,C
-            // 1 4
-            // Z 0 H C
-            debug_print("ADD A,C\n", NULL);
-            p->flagRegister.half_carry = is_half_carry_add(p->registers.a, p->registers.c);
-            p->flagRegister.carry = 0xFF < ((uint16_t) p->registers.a + (uint16_t) p->registers.c);
-
-            p->registers.a += p->registers.c;
-
-			CHECK_AND_SET_ZERO(p->registers.a);
-            RESET_SUBTRACT;
-			break;
-        case 0x82:
-            // ADD A,D
-            // 1 4
-            // Z 0 H C
-            debug_print("ADD A,D\n", NULL);
-            p->flagRegister.half_carry = is_half_carry_add(p->registers.a, p->registers.d);
-            p->flagRegister.carry = 0xFF < ((uint16_t) p->registers.a + (uint16_t) p->registers.d);
-
-            p->registers.a += p->registers.d;
-
-			CHECK_AND_SET_ZERO(p->registers.a);
-            RESET_SUBTRACT;
-			break;
-        case 0x83:
-            // ADD A,E
-            // 1 4
-            // Z 0 H C
-            debug_print("ADD A,E\n", NULL);
-            p->flagRegister.half_carry = is_half_carry_add(p->registers.a, p->registers.e);
-            p->flagRegister.carry = 0xFF < ((uint16_t) p->registers.a + (uint16_t) p->registers.e);
-
-            p->registers.a += p->registers.e;
-
-			CHECK_AND_SET_ZERO(p->registers.a);
-            RESET_SUBTRACT;
-			break;
-        case 0x84:
-            // ADD A,H
-            // 1 4
-            // Z 0 H C
-            debug_print("ADD A,H\n", NULL);
-            p->flagRegister.half_carry = is_half_carry_add(p->registers.a, p->registers.h);
-            p->flagRegister.carry = 0xFF < ((uint16_t) p->registers.a + (uint16_t) p->registers.h);
-
-            p->registers.a += p->registers.h;
-
-			CHECK_AND_SET_ZERO(p->registers.a);
-            RESET_SUBTRACT;
-			break;
-        case 0x85:
-            // ADD A,L
-            // 1 4
-            // Z 0 H C
-            debug_print("ADD A,L\n", NULL);
-            p->flagRegister.half_carry = is_half_carry_add(p->registers.a, p->registers.l);
-            p->flagRegister.carry = 0xFF < ((uint16_t) p->registers.a + (uint16_t) p->registers.l);
-
-            p->registers.a += p->registers.l;
-
-			CHECK_AND_SET_ZERO(p->registers.a);
-            RESET_SUBTRACT;
-			break;
-        case 0x86: {
-            // ADD A,(HL)
-            // 1 8
-            // Z 0 H C
-            debug_print("ADD A,(HL)\n", NULL);
-            uint8_t val = p->memory[((uint16_t)p->registers.h << 8) + (uint16_t)(p->registers.l)];
-            p->flagRegister.half_carry = is_half_carry_add(p->registers.a, val);
-            p->flagRegister.carry = 0xFF < ((uint16_t) p->registers.a + (uint16_t) val);
-
-            p->registers.a += val;
-
-			CHECK_AND_SET_ZERO(p->registers.a);
-            RESET_SUBTRACT;
-			break;
-        }
-        case 0x87:
-            // ADD A,A
-            // 1 4
-            // Z 0 H C
-            debug_print("ADD A,A\n", NULL);
-            p->flagRegister.half_carry = is_half_carry_add(p->registers.a, p->registers.a);
-            p->flagRegister.carry = 0xFF < ((uint16_t) p->registers.a + (uint16_t) p->registers.a);
-
-            p->registers.a += p->registers.a;
-
-			CHECK_AND_SET_ZERO(p->registers.a);
-            RESET_SUBTRACT;
-            break;
-        case 0x88: {
-            // ADC A,B
-            // 1 4
-            // Z 0 H C
-            uint8_t result = p->registers.a + p->registers.b + p->flagRegister.carry;
-            p->flagRegister.half_carry = is_three_half_carry_add(p->registers.a, p->registers.b, p->flagRegister.carry);
-            p->flagRegister.carry      = 0xFF < ((uint16_t) p->registers.a + (uint16_t) p->registers.b + (uint16_t) p->flagRegister.carry);
-            SET_REG(&p->registers.a, result);
-            RESET_SUBTRACT;
-            CHECK_AND_SET_ZERO(p->registers.a);
-            debug_print("ADC A,B\n", NULL);
-			break;
-        }
-        case 0x89: {
-            // ADC A,C
-            // 1 4
-            // Z 0 H C
-            uint8_t result = p->registers.a + p->registers.c + p->flagRegister.carry;
-            p->flagRegister.half_carry = is_three_half_carry_add(p->registers.a, p->registers.c, p->flagRegister.carry);
-            p->flagRegister.carry      = 0xFF < ((uint16_t) p->registers.a + (uint16_t) p->registers.c + (uint16_t) p->flagRegister.carry);
-            SET_REG(&p->registers.a, result);
-            RESET_SUBTRACT;
-            CHECK_AND_SET_ZERO(p->registers.a);
-            debug_print("ADC A,C\n", NULL);
-			break;
-        }
-        case 0x8A: {
-            // ADC A,D
-            // 1 4
-            // Z 0 H C
-            uint8_t result = p->registers.a + p->registers.d + p->flagRegister.carry;
-            p->flagRegister.half_carry = is_three_half_carry_add(p->registers.a, p->registers.d, p->flagRegister.carry);
-            p->flagRegister.carry      = 0xFF < ((uint16_t) p->registers.a + (uint16_t) p->registers.d + (uint16_t) p->flagRegister.carry);
-            SET_REG(&p->registers.a, result);
-            RESET_SUBTRACT;
-            CHECK_AND_SET_ZERO(p->registers.a);
-            debug_print("ADC A,D\n", NULL);
-			break;
-        }
-        case 0x8B: {
-            // ADC A,E
-            // 1 4
-            // Z 0 H C
-            uint8_t result = p->registers.a + p->registers.e + p->flagRegister.carry;
-            p->flagRegister.half_carry = is_three_half_carry_add(p->registers.a, p->registers.e, p->flagRegister.carry);
-            p->flagRegister.carry      = 0xFF < ((uint16_t) p->registers.a + (uint16_t) p->registers.e + (uint16_t) p->flagRegister.carry);
-            SET_REG(&p->registers.a, result);
-            RESET_SUBTRACT;
-            CHECK_AND_SET_ZERO(p->registers.a);
-            debug_print("ADC A,E\n", NULL);
-			break;
-        }
-        case 0x8C: {
-            // ADC A,H
-            // 1 4
-            // Z 0 H C
-            uint8_t result = p->registers.a + p->registers.h + p->flagRegister.carry;
-            p->flagRegister.half_carry = is_three_half_carry_add(p->registers.a, p->registers.h, p->flagRegister.carry);
-            p->flagRegister.carry      = 0xFF < ((uint16_t) p->registers.a + (uint16_t) p->registers.h + (uint16_t) p->flagRegister.carry);
-            SET_REG(&p->registers.a, result);
-            RESET_SUBTRACT;
-            CHECK_AND_SET_ZERO(p->registers.a);
-            debug_print("ADC A,H\n", NULL);
-			break;
-        }
-        case 0x8D: {
-            // ADC A,L
-            // 1 4
-            // Z 0 H C
-            uint8_t result = p->registers.a + p->registers.l + p->flagRegister.carry;
-            p->flagRegister.half_carry = is_three_half_carry_add(p->registers.a, p->registers.l, p->flagRegister.carry);
-            p->flagRegister.carry      = 0xFF < ((uint16_t) p->registers.a + (uint16_t) p->registers.l + (uint16_t) p->flagRegister.carry);
-            SET_REG(&p->registers.a, result);
-            RESET_SUBTRACT;
-            CHECK_AND_SET_ZERO(p->registers.a);
-            debug_print("ADC A,L\n", NULL);
-			break;
-        }
-        case 0x8E: {
-            // ADC A,(HL)
-            // 1 8
-            // Z 0 H C
-            uint8_t maccess = p->memory[((uint16_t)p->registers.h << 8) + (uint16_t)(p->registers.l)];
-            uint8_t result = p->registers.a + maccess + p->flagRegister.carry;
-            p->flagRegister.half_carry = is_three_half_carry_add(p->registers.a, maccess, p->flagRegister.carry);
-            p->flagRegister.carry      = 0xFF < ((uint16_t) p->registers.a + (uint16_t) maccess + (uint16_t) p->flagRegister.carry);
-            SET_REG(&p->registers.a, result);
-            RESET_SUBTRACT;
-            CHECK_AND_SET_ZERO(p->registers.a);
-            debug_print("ADC A,(HL)\n", NULL);
-			break;
-        }
-        case 0x8F: {
-            // ADC A,A
-            // 1 4
-            // Z 0 H C
-            uint8_t result = p->registers.a + p->registers.a + p->flagRegister.carry;
-            p->flagRegister.half_carry = is_three_half_carry_add(p->registers.a,p->registers.a, p->flagRegister.carry);
-            p->flagRegister.carry      = 0xFF < ((uint16_t) p->registers.a + (uint16_t) p->registers.a + (uint16_t) p->flagRegister.carry);
-            SET_REG(&p->registers.a, result);
-            RESET_SUBTRACT;
-            CHECK_AND_SET_ZERO(p->registers.a);
-            debug_print("ADC A,A\n", NULL);
-			break;
-        }
-        case 0x90: {
-            // SUB B
-            // 1 4
-            // Z 1 H C
-            uint16_t result = (uint16_t) p->registers.a - (uint16_t) p->registers.b;
-            p->flagRegister.carry = (result & 0xFF00) > 0;
-            p->flagRegister.half_carry = is_half_carry_sub(p->registers.a, p->registers.b);
-            SET_REG(&p->registers.a, result & 0xFF);
-            SET_SUBTRACT;
-            CHECK_AND_SET_ZERO(p->registers.a);
-            debug_print("SUB B\n", NULL);
-			break;
-        }
-        case 0x91: {
-            // SUB C
-            // 1 4
-            // Z 1 H C
-            uint16_t result = (uint16_t) p->registers.a - (uint16_t) p->registers.c;
-            p->flagRegister.carry = (result & 0xFF00) > 0;
-            p->flagRegister.half_carry = is_half_carry_sub(p->registers.a, p->registers.c);
-            SET_REG(&p->registers.a, result & 0xFF);
-            SET_SUBTRACT;
-            CHECK_AND_SET_ZERO(p->registers.a);
-            debug_print("SUB C\n", NULL);
-			break;
-        }
-        case 0x92: {
-            // SUB D
-            // 1 4
-            // Z 1 H C
-            uint16_t result = (uint16_t) p->registers.a - (uint16_t) p->registers.d;
-            p->flagRegister.carry = (result & 0xFF00) > 0;
-            p->flagRegister.half_carry = is_half_carry_sub(p->registers.a, p->registers.d);
-            SET_REG(&p->registers.a, result & 0xFF);
-            SET_SUBTRACT;
-            CHECK_AND_SET_ZERO(p->registers.a);
-            debug_print("SUB D\n", NULL);
-			break;
-        }
-        case 0x93: {
-            // SUB E
-            // 1 4
-            // Z 1 H C
-            uint16_t result = (uint16_t) p->registers.a - (uint16_t) p->registers.e;
-            p->flagRegister.carry = (result & 0xFF00) > 0;
-            p->flagRegister.half_carry = is_half_carry_sub(p->registers.a,
-                                                           p->registers.e);
-            SET_REG(&p->registers.a, result & 0xFF);
-            SET_SUBTRACT;
-            CHECK_AND_SET_ZERO(p->registers.a);
-            debug_print("SUB E\n", NULL);
-			break;
-        }
-        case 0x94: {
-            // SUB H
-            // 1 4
-            // Z 1 H C
-            uint16_t result = (uint16_t) p->registers.a - (uint16_t) p->registers.h;
-            p->flagRegister.carry = (result & 0xFF00) > 0;
-            p->flagRegister.half_carry = is_half_carry_sub(p->registers.a, p->registers.h);
-            SET_REG(&p->registers.a, result & 0xFF);
-            SET_SUBTRACT;
-            CHECK_AND_SET_ZERO(p->registers.a);
-            debug_print("SUB H\n", NULL);
-			break;
-        }
-        case 0x95: {
-            // SUB L
-            // 1 4
-            // Z 1 H C
-            uint16_t result = (uint16_t) p->registers.a - (uint16_t) p->registers.l;
-            p->flagRegister.carry = (result & 0xFF00) > 0;
-            p->flagRegister.half_carry = is_half_carry_sub(p->registers.a, p->registers.l);
-            SET_REG(&p->registers.a, result & 0xFF);
-            SET_SUBTRACT;
-            CHECK_AND_SET_ZERO(p->registers.a);
-            debug_print("SUB L\n", NULL);
-			break;
-        }
-        case 0x96: {
-            // SUB (HL)
-            // 1 8
-            // Z 1 H C
-            uint16_t val = p->memory[((uint16_t)p->registers.h << 8) + (uint16_t)(p->registers.l)];
-            uint16_t result = (uint16_t) p->registers.a - (uint16_t) val;
-            p->flagRegister.carry = (result & 0xFF00) > 0;
-            p->flagRegister.half_carry = is_half_carry_sub(p->registers.a, val);
-            SET_REG(&p->registers.a, result & 0xFF);
-            SET_SUBTRACT;
-            CHECK_AND_SET_ZERO(p->registers.a);
-            debug_print("SUB (HL)\n", NULL);
-			break;
-        }
-        case 0x97:
-            // SUB A
-            // 1 4
-            // Z 1 H C
-            SET_REG(&p->registers.a, 0x00);
-            p->flagRegister.half_carry = 0;
-            p->flagRegister.carry      = 0;
-            SET_SUBTRACT;
-            CHECK_AND_SET_ZERO(p->registers.a);
-            debug_print("SUB A\n", NULL);
-			break;
-        case 0x98: {
-            // SBC A,B
-            // 1 4
-            // Z 1 H C
-            SET_SUBTRACT;
-            int16_t result = (uint16_t) p->registers.a - (uint16_t) p->registers.b - (uint16_t) p->flagRegister.carry;
-            p->flagRegister.carry = (result & 0xFF00) > 0;
-            p->flagRegister.half_carry = is_three_half_carry_sub(p->registers.a, p->registers.b, p->flagRegister.carry);
-            SET_REG(&p->registers.a, result & 0xFF);
-            CHECK_AND_SET_ZERO(p->registers.a);
-            debug_print("SBC A,B\n", NULL);
-			break;
-        }
-        case 0x99: {
-            // SBC A,C
-            // 1 4
-            // Z 1 H C
-            SET_SUBTRACT;
-            int16_t result = (uint16_t) p->registers.a - (uint16_t) p->registers.c - (uint16_t) p->flagRegister.carry;
-            p->flagRegister.carry = (result & 0xFF00) > 0;
-            p->flagRegister.half_carry = is_three_half_carry_sub(p->registers.a, p->registers.c, p->flagRegister.carry);
-            SET_REG(&p->registers.a, result & 0xFF);
-            CHECK_AND_SET_ZERO(p->registers.a);
-            debug_print("SBC A,C\n", NULL);
-			break;
-        }
-        case 0x9A: {
-            // SBC A,D
-            // 1 4
-            // Z 1 H C
-            SET_SUBTRACT;
-            int16_t result = (uint16_t) p->registers.a - (uint16_t) p->registers.d - (uint16_t) p->flagRegister.carry;
-            p->flagRegister.carry = (result & 0xFF00) > 0;
-            p->flagRegister.half_carry = is_three_half_carry_sub(p->registers.a, p->registers.d, p->flagRegister.carry);
-            SET_REG(&p->registers.a, result & 0xFF);
-            CHECK_AND_SET_ZERO(p->registers.a);
-            debug_print("SBC A,D\n", NULL);
-			break;
-        }
-        case 0x9B: {
-            // SBC A,E
-            // 1 4
-            // Z 1 H C
-            SET_SUBTRACT;
-            int16_t result = (uint16_t) p->registers.a - (uint16_t) p->registers.e - (uint16_t) p->flagRegister.carry;
-            p->flagRegister.carry = (result & 0xFF00) > 0;
-            p->flagRegister.half_carry = is_three_half_carry_sub(p->registers.a, p->registers.e, p->flagRegister.carry);
-            SET_REG(&p->registers.a, result & 0xFF);
-            CHECK_AND_SET_ZERO(p->registers.a);
-            debug_print("SBC A,E\n", NULL);
-			break;
-        }
-        case 0x9C: {
-            // SBC A,H
-            // 1 4
-            // Z 1 H C
-            SET_SUBTRACT;
-            int16_t result = (uint16_t) p->registers.a - (uint16_t) p->registers.h - (uint16_t) p->flagRegister.carry;
-            p->flagRegister.carry = (result & 0xFF00) > 0;
-            p->flagRegister.half_carry = is_three_half_carry_sub(p->registers.a, p->registers.h, p->flagRegister.carry);
-            SET_REG(&p->registers.a, result & 0xFF);
-            CHECK_AND_SET_ZERO(p->registers.a);
-            debug_print("SBC A,H\n", NULL);
-			break;
-        }
-        case 0x9D: {
-            // SBC A,L
-            // 1 4
-            // Z 1 H C
-            SET_SUBTRACT;
-            int16_t result = (uint16_t) p->registers.a - (uint16_t) p->registers.l - (uint16_t) p->flagRegister.carry;
-            p->flagRegister.carry = (result & 0xFF00) > 0;
-            p->flagRegister.half_carry = is_three_half_carry_sub(p->registers.a, p->registers.l, p->flagRegister.carry);
-            SET_REG(&p->registers.a, result & 0xFF);
-            CHECK_AND_SET_ZERO(p->registers.a);
-            debug_print("SBC A,L\n", NULL);
-			break;
-        }
-        case 0x9E: {
-            // SBC A,(HL)
-            // 1 8
-            // Z 1 H C
-            SET_SUBTRACT;
-            int8_t     val = p->memory[((uint16_t)p->registers.h << 8) + (uint16_t)(p->registers.l)];
-            int16_t result = (uint16_t) p->registers.a - (uint16_t) val - (uint16_t) p->flagRegister.carry;
-            p->flagRegister.carry = (result & 0xFF00) > 0;
-            p->flagRegister.half_carry = is_three_half_carry_sub(p->registers.a, val, p->flagRegister.carry);
-            SET_REG(&p->registers.a, result & 0xFF);
-            CHECK_AND_SET_ZERO(p->registers.a);
-            debug_print("SBC A,(HL)\n", NULL);
-			break;
-        }
-        case 0x9F: {
-            // SBC A,A
-            // 1 4
-            // Z 1 H C
-            SET_SUBTRACT;
-            int16_t result = (uint16_t) p->registers.a - (uint16_t) p->registers.a - (uint16_t) p->flagRegister.carry;
-            p->flagRegister.carry = (result & 0xFF00) > 0;
-            p->flagRegister.half_carry = is_three_half_carry_sub(p->registers.a, p->registers.a, p->flagRegister.carry);
-            SET_REG(&p->registers.a, result & 0xFF);
-            CHECK_AND_SET_ZERO(p->registers.a);
-            debug_print("SBC A,A\n", NULL);
-			break;
-        }
-        case 0xA0:
-            // AND B
-            // 1 4
-            // Z 0 1 0
-            RESET_SUBTRACT;
-            SET_HALF_CARRY;
-            RESET_CARRY;
-            SET_REG(&p->registers.a, p->registers.a && p->registers.b);
-            p->flagRegister.zero = p->registers.a == 0;
-            debug_print("AND B\n", NULL);
-			break;
-        case 0xA1:
-            // AND C
-            // 1 4
-            // Z 0 1 0
-            RESET_SUBTRACT;
-            SET_HALF_CARRY;
-            RESET_CARRY;
-            SET_REG(&p->registers.a, p->registers.a && p->registers.c);
-            p->flagRegister.zero = p->registers.a == 0;
-            debug_print("AND C\n", NULL);
-			break;
-        case 0xA2:
-            // AND D
-            // 1 4
-            // Z 0 1 0
-            RESET_SUBTRACT;
-            SET_HALF_CARRY;
-            RESET_CARRY;
-            SET_REG(&p->registers.a, p->registers.a && p->registers.d);
-            p->flagRegister.zero = p->registers.a == 0;
-            debug_print("AND D\n", NULL);
-			break;
-        case 0xA3:
-            // AND E
-            // 1 4
-            // Z 0 1 0
-            RESET_SUBTRACT;
-            SET_HALF_CARRY;
-            RESET_CARRY;
-            SET_REG(&p->registers.a, p->registers.a && p->registers.e);
-            p->flagRegister.zero = p->registers.a == 0;
-            debug_print("AND E\n", NULL);
-			break;
-        case 0xA4:
-            // AND H
-            // 1 4
-            // Z 0 1 0
-            RESET_SUBTRACT;
-            SET_HALF_CARRY;
-            RESET_CARRY;
-            SET_REG(&p->registers.a, p->registers.a && p->registers.h);
-            p->flagRegister.zero = p->registers.a == 0;
-            debug_print("AND H\n", NULL);
-			break;
-        case 0xA5:
-            // AND L
-            // 1 4
-            // Z 0 1 0
-            RESET_SUBTRACT;
-            SET_HALF_CARRY;
-            RESET_CARRY;
-            SET_REG(&p->registers.a, p->registers.a && p->registers.l);
-            p->flagRegister.zero = p->registers.a == 0;
-            debug_print("AND L\n", NULL);
-			break;
-        case 0xA6:
-            // AND (HL)
-            // 1 8
-            // Z 0 1 0
-            RESET_SUBTRACT;
-            SET_HALF_CARRY;
-            RESET_CARRY;
-            SET_REG(&p->registers.a, p->registers.a && p->memory[((uint16_t)p->registers.h << 8) + (uint16_t)(p->registers.l)]);
-            p->flagRegister.zero = p->registers.a == 0;
-            debug_print("AND (HL)\n", NULL);
-			break;
-        case 0xA7:
-            // AND A
-            // 1 4
-            // Z 0 1 0
-            RESET_SUBTRACT;
-            SET_HALF_CARRY;
-            RESET_CARRY;
-            SET_REG(&p->registers.a, p->registers.a && p->registers.a);
-            p->flagRegister.zero = p->registers.a == 0;
-            debug_print("AND A\n", NULL);
-			break;
-        case 0xA8:
-            // XOR B
-            // 1 4
-            // Z 0 0 0
-            RESET_SUBTRACT;
-            RESET_HALF_CARRY;
-            RESET_CARRY;
-            debug_print("XOR B\n", NULL);
-			break;
-        case 0xA9:
-            // XOR C
-            // 1 4
-            // Z 0 0 0
-            RESET_SUBTRACT;
-            RESET_HALF_CARRY;
-            RESET_CARRY;
-            debug_print("XOR C\n", NULL);
-			break;
-        case 0xAA:
-            // XOR D
-            // 1 4
-            // Z 0 0 0
-            RESET_SUBTRACT;
-            RESET_HALF_CARRY;
-            RESET_CARRY;
-            debug_print("XOR D\n", NULL);
-			break;
-        case 0xAB:
-            // XOR E
-            // 1 4
-            // Z 0 0 0
-            RESET_SUBTRACT;
-            RESET_HALF_CARRY;
-            RESET_CARRY;
-            debug_print("XOR E\n", NULL);
-			break;
-        case 0xAC:
-            // XOR H
-            // 1 4
-            // Z 0 0 0
-            RESET_SUBTRACT;
-            RESET_HALF_CARRY;
-            RESET_CARRY;
-            debug_print("XOR H\n", NULL);
-			break;
-        case 0xAD:
-            // XOR L
-            // 1 4
-            // Z 0 0 0
-            RESET_SUBTRACT;
-            RESET_HALF_CARRY;
-            RESET_CARRY;
-            debug_print("XOR L\n", NULL);
-			break;
-        case 0xAE:
-            // XOR (HL)
-            // 1 8
-            // Z 0 0 0
-            RESET_SUBTRACT;
-            RESET_HALF_CARRY;
-            RESET_CARRY;
-            debug_print("XOR (HL)\n", NULL);
-			break;
-        case 0xAF:
-            // XOR A
-            // 1 4
-            // Z 0 0 0
-            RESET_SUBTRACT;
-            RESET_HALF_CARRY;
-            RESET_CARRY;
-            debug_print("XOR A\n", NULL);
-			break;
-        case 0xB0:
-            // OR B
-            // 1 4
-            // Z 0 0 0
-            RESET_SUBTRACT;
-            RESET_HALF_CARRY;
-            RESET_CARRY;
-            debug_print("OR B\n", NULL);
-			break;
-        case 0xB1:
-            // OR C
-            // 1 4
-            // Z 0 0 0
-            RESET_SUBTRACT;
-            RESET_HALF_CARRY;
-            RESET_CARRY;
-            debug_print("OR C\n", NULL);
-			break;
-        case 0xB2:
-            // OR D
-            // 1 4
-            // Z 0 0 0
-            RESET_SUBTRACT;
-            RESET_HALF_CARRY;
-            RESET_CARRY;
-            debug_print("OR D\n", NULL);
-			break;
-        case 0xB3:
-            // OR E
-            // 1 4
-            // Z 0 0 0
-            RESET_SUBTRACT;
-            RESET_HALF_CARRY;
-            RESET_CARRY;
-            debug_print("OR E\n", NULL);
-			break;
-        case 0xB4:
-            // OR H
-            // 1 4
-            // Z 0 0 0
-            RESET_SUBTRACT;
-            RESET_HALF_CARRY;
-            RESET_CARRY;
-            debug_print("OR H\n", NULL);
-			break;
-        case 0xB5:
-            // OR L
-            // 1 4
-            // Z 0 0 0
-            RESET_SUBTRACT;
-            RESET_HALF_CARRY;
-            RESET_CARRY;
-            debug_print("OR L\n", NULL);
-			break;
-        case 0xB6:
-            // OR (HL)
-            // 1 8
-            // Z 0 0 0
-            RESET_SUBTRACT;
-            RESET_HALF_CARRY;
-            RESET_CARRY;
-            debug_print("OR (HL)\n", NULL);
-			break;
-        case 0xB7:
-            // OR A
-            // 1 4
-            // Z 0 0 0
-            RESET_SUBTRACT;
-            RESET_HALF_CARRY;
-            RESET_CARRY;
-            debug_print("OR A\n", NULL);
-			break;
-        case 0xB8:
-            // CP B
-            // 1 4
-            // Z 1 H C
-            p->flagRegister.zero = p->registers.a == p->registers.b;
-            SET_SUBTRACT;
-            // set if "no borrow"
-            p->flagRegister.half_carry = !is_half_carry_sub(p->registers.a, p->registers.b);
-            p->flagRegister.carry = p->registers.a < p->registers.b;
-            debug_print("CP B\n", NULL);
-			break;
-        case 0xB9:
-            // CP C
-            // 1 4
-            // Z 1 H C
-            SET_SUBTRACT;
-            p->flagRegister.zero = p->registers.a == p->registers.c;
-            p->flagRegister.half_carry = !is_half_carry_sub(p->registers.a, p->registers.c);
-            p->flagRegister.carry = p->registers.a < p->registers.c;
-            debug_print("CP C\n", NULL);
-			break;
-        case 0xBA:
-            // CP D
-            // 1 4
-            // Z 1 H C
-            SET_SUBTRACT;
-            p->flagRegister.zero = p->registers.a == p->registers.d;
-            p->flagRegister.half_carry = !is_half_carry_sub(p->registers.a, p->registers.d);
-            p->flagRegister.carry = p->registers.a < p->registers.d;
-            debug_print("CP D\n", NULL);
-			break;
-        case 0xBB:
-            // CP E
-            // 1 4
-            // Z 1 H C
-            SET_SUBTRACT;
-            p->flagRegister.zero = p->registers.a == p->registers.e;
-            p->flagRegister.half_carry = !is_half_carry_sub(p->registers.a, p->registers.e);
-            p->flagRegister.carry = p->registers.a < p->registers.e;
-            debug_print("CP E\n", NULL);
-			break;
-        case 0xBC:
-            // CP H
-            // 1 4
-            // Z 1 H C
-            SET_SUBTRACT;
-            p->flagRegister.zero = p->registers.a == p->registers.h;
-            p->flagRegister.half_carry = !is_half_carry_sub(p->registers.a, p->registers.h);
-            p->flagRegister.carry = p->registers.a < p->registers.h;
-            debug_print("CP H\n", NULL);
-			break;
-        case 0xBD:
-            // CP L
-            // 1 4
-            // Z 1 H C
-            SET_SUBTRACT;
-            p->flagRegister.zero = p->registers.a == p->registers.l;
-            p->flagRegister.half_carry = !is_half_carry_sub(p->registers.a, p->registers.l);
-            p->flagRegister.carry = p->registers.a < p->registers.l;
-            debug_print("CP L\n", NULL);
-			break;
-        case 0xBE: {
-            // CP (HL)
-            // 1 8
-            // Z 1 H C
-            SET_SUBTRACT;
-            uint8_t val = p->memory[((uint16_t)p->registers.h << 8) + (uint16_t)(p->registers.l)];
-            p->flagRegister.zero = p->registers.a == val;
-            p->flagRegister.half_carry = !is_half_carry_sub(p->registers.a, val);
-            p->flagRegister.carry = p->registers.a <  val;
-            debug_print("CP (HL)\n", NULL);
-			break;
-        }
-        case 0xBF:
-            // CP A
-            // 1 4
-            // Z 1 H C
-            SET_SUBTRACT;
-            p->flagRegister.zero = 1;
-            p->flagRegister.half_carry = !is_half_carry_sub(p->registers.a, p->registers.a);
-            p->flagRegister.carry = 0;
-            debug_print("CP A\n", NULL);
-			break;
-        case 0xC0:
-            // RET NZ
-            // 1 20/8
-            // - - - -
-            debug_print("RET NZ\n", NULL);
-            if (p->flagRegister.zero == CLEAR) {
-                goto RETURN_CASE;
-            }
-			break;
-        case 0xC1:
-            // POP BC
-            // 1 12
-            // - - - -
-            debug_print("POP BC\n", NULL);
-            SET_REG(&p->registers.c, p->memory[p->sp]);
-            SET_REG(&p->registers.b, p->memory[p->sp - 1]);
-            p->sp += 2;
-			break;
-        case 0xC2:
-            // JP NZ,a16
-            // 3 16/12
-            // - - - -
-            debug_print("JP NZ,a16\n", NULL);
-            // jump to addr n if the zero flag is reset
-            if (!p->flagRegister.zero) {
-                p->pc = p->memory[p->pc + 1] + (p->memory[p->pc + 2] << 8);
-                bytes_ate = 0;
-            }
-			break;
-        case 0xC3:
-            // JP a16
-            // 3 16
-            // - - - -
-            debug_print("JP a16\n", NULL);
-            // jump to address nn
-            p->pc = p->memory[p->pc + 1] + (p->memory[p->pc + 2] << 8);
-            bytes_ate = 0;
-			break;
-        case 0xC4:
-            // CALL NZ,a16
-            // 3 24/12
-            // - - - -
-            debug_print("CALL NZ,a16\n", NULL);
-			break;
-        case 0xC5:
-            // PUSH BC
-            // 1 16
-            // - - - -
-            debug_print("PUSH BC\n", NULL);
-            p->memory[p->sp] = p->registers.c;
-            p->memory[p->sp - 1] = p->registers.b;
-            p->sp -= 2;
-			break;
-        case 0xC6:
-            // ADD A,d8
-            // 2 8
-            // Z 0 H C
-            debug_print("ADD A,d8\n", NULL);
-			d8 = p->memory[p->pc + 1];
-            p->flagRegister.half_carry = is_half_carry_add(p->registers.a, d8);
-            p->flagRegister.carry = 0xFF < ((uint16_t) p->registers.a + (uint16_t) d8);
-
-            p->registers.a += d8;
-			CHECK_AND_SET_ZERO(p->registers.a)
-            RESET_SUBTRACT;
-            bytes_ate = 2;
-            break;
-        case 0xC7:
-            // RST 00H
-            // 1 16
-            // - - - -
-            debug_print("RST 00H\n", NULL);
-			break;
-        case 0xC8:
-            // RET Z
-            // 1 20/8
-            // - - - -
-            debug_print("RET Z\n", NULL);
-            if (p->flagRegister.zero == SET) {
-                goto RETURN_CASE;
-            }
-			break;
-        case 0xC9: {
-            //  RET
-            // 1 16
-            // - - - -
-            debug_print("RET\n", NULL);
-            // Remember - stack grows DOWNWARD in value, when you pop you go up in value
-RETURN_CASE:;
-            uint8_t lower_bits = p->memory[p->sp++];
-            uint8_t upper_bits = p->memory[p->sp++];
-            combined_value = get_16bit_value(upper_bits, lower_bits);
-            // Jump to the address specified by the combined_value
-            p->pc = combined_value;
-			return;
+static inline uint16_t get_af(Proc* p) {
+    proc_get_f(p);
+    return p->registers.af;
+}
+
+static inline void set_af(Proc* p, uint16_t value) {
+    p->registers.a = get_upper_8bit_value(value);
+    proc_set_f(p, get_lower_8bit_value(value));
+}
+
+static inline void push_word(Proc* p, uint16_t value) {
+    /* Remember - stack grows DOWNWARD in value, upper byte goes in first */
+    write_byte(p, --p->sp, get_upper_8bit_value(value));
+    write_byte(p, --p->sp, get_lower_8bit_value(value));
+}
+
+static inline uint16_t pop_word(Proc* p) {
+    uint8_t lower = read_byte(p, p->sp++);
+    uint8_t upper = read_byte(p, p->sp++);
+    return get_16bit_value(upper, lower);
+}
+
+/* ---------------------------------------------------------------------------------------
+ * alu
+ * --------------------------------------------------------------------------------------- */
+
+static inline void alu_add(Proc* p, uint8_t value) {
+    // Z 0 H C
+    p->registers.a = lazy_add(p, p->registers.a, value, 0);
+}
+
+static inline void alu_adc(Proc* p, uint8_t value) {
+    // Z 0 H C
+    p->registers.a = lazy_add(p, p->registers.a, value, flag_carry(p));
+}
+
+static inline void alu_cp(Proc* p, uint8_t value) {
+    // Z 1 H C, subtract without keeping the result
+    lazy_sub(p, p->registers.a, value, 0);
+}
+
+static inline void alu_sub(Proc* p, uint8_t value) {
+    // Z 1 H C
+    p->registers.a = lazy_sub(p, p->registers.a, value, 0);
+}
+
+static inline void alu_sbc(Proc* p, uint8_t value) {
+    // Z 1 H C
+    p->registers.a = lazy_sub(p, p->registers.a, value, flag_carry(p));
+}
+
+static inline void alu_and(Proc* p, uint8_t value) {
+    // Z 0 1 0
+    p->registers.a &= value;
+    set_flags(p, (p->registers.a ? 0 : FLAG_ZERO) | FLAG_HALF_CARRY);
+}
+
+static inline void alu_xor(Proc* p, uint8_t value) {
+    // Z 0 0 0
+    p->registers.a ^= value;
+    set_flags(p, p->registers.a ? 0 : FLAG_ZERO);
+}
+
+static inline void alu_or(Proc* p, uint8_t value) {
+    // Z 0 0 0
+    p->registers.a |= value;
+    set_flags(p, p->registers.a ? 0 : FLAG_ZERO);
+}
+
+static inline uint8_t alu_inc(Proc* p, uint8_t value) {
+    // Z 0 H -
+    return lazy_inc_dec(p, LAZY_INC, value + 1);
+}
+
+static inline uint8_t alu_dec(Proc* p, uint8_t value) {
+    // Z 1 H -
+    return lazy_inc_dec(p, LAZY_DEC, value - 1);
+}
+
+static inline void alu_add_hl(Proc* p, uint16_t value) {
+    // - 0 H C, half carry is out of bit 11 for the 16 bit add
+    uint16_t hl = get_hl(p);
+    uint32_t result = hl + value;
+    update_flags(p, FLAG_ZERO,
+            (((hl & 0x0FFF) + (value & 0x0FFF)) > 0x0FFF ? FLAG_HALF_CARRY : 0)
+            | (result > 0xFFFF ? FLAG_CARRY : 0));
+    set_hl(p, result);
+}
+
+static inline uint16_t alu_add_sp(Proc* p, int8_t value) {
+    // 0 0 H C, the flags come from the unsigned add on the lower byte
+    // https://robdor.com/2016/08/10/gameboy-emulator-half-carry-flag/
+    uint8_t lower = get_lower_8bit_value(p->sp);
+    set_flags(p, (is_half_carry_add(lower, (uint8_t) value) ? FLAG_HALF_CARRY : 0)
+               | ((lower + (uint8_t) value) > 0xFF ? FLAG_CARRY : 0));
+    return p->sp + value;
+}
+
+static inline void alu_daa(Proc* p) {
+    // Z - 0 C, fixes up A to be binary coded decimal after an add or subtract
+    uint8_t f = proc_get_f(p);
+    uint8_t correction = 0;
+    uint8_t carry = f & FLAG_CARRY;
+
+    if ((f & FLAG_HALF_CARRY) || (!(f & FLAG_SUBTRACT) && (p->registers.a & 0x0F) > 0x09)) {
+        correction |= 0x06;
+    }
+    if (carry || (!(f & FLAG_SUBTRACT) && p->registers.a > 0x99)) {
+        correction |= 0x60;
+        carry = FLAG_CARRY;
+    }
+
+    p->registers.a = (f & FLAG_SUBTRACT) ? p->registers.a - correction : p->registers.a + correction;
+
+    set_flags(p, (p->registers.a ? 0 : FLAG_ZERO) | (f & FLAG_SUBTRACT) | carry);
+}
+
+/* rotates and shifts, Z 0 0 C */
+
+static inline uint8_t shift_flags(Proc* p, uint8_t value, uint8_t carry) {
+    set_flags(p, (value ? 0 : FLAG_ZERO) | (carry ? FLAG_CARRY : 0));
+    return value;
+}
+
+static inline uint8_t alu_rlc(Proc* p, uint8_t value) {
+    return shift_flags(p, (value << 1) | (value >> 7), value >> 7);
+}
+
+static inline uint8_t alu_rrc(Proc* p, uint8_t value) {
+    return shift_flags(p, (value >> 1) | (value << 7), value & 0x01);
+}
+
+static inline uint8_t alu_rl(Proc* p, uint8_t value) {
+    // old carry goes into bit 0
+    return shift_flags(p, (value << 1) | flag_carry(p), value >> 7);
+}
+
+static inline uint8_t alu_rr(Proc* p, uint8_t value) {
+    // old carry goes into bit 7
+    return shift_flags(p, (value >> 1) | (flag_carry(p) << 7), value & 0x01);
+}
+
+static inline uint8_t alu_sla(Proc* p, uint8_t value) {
+    return shift_flags(p, value << 1, value >> 7);
+}
+
+static inline uint8_t alu_sra(Proc* p, uint8_t value) {
+    // msb stays where it is
+    return shift_flags(p, (value >> 1) | (value & 0x80), value & 0x01);
+}
+
+static inline uint8_t alu_swap(Proc* p, uint8_t value) {
+    return shift_flags(p, (value << 4) | (value >> 4), 0);
+}
+
+static inline uint8_t alu_srl(Proc* p, uint8_t value) {
+    return shift_flags(p, value >> 1, value & 0x01);
+}
+
+static inline void alu_bit(Proc* p, int bit, uint8_t value) {
+    // Z 0 1 -
+    update_flags(p, FLAG_CARRY, (value & (1 << bit) ? 0 : FLAG_ZERO) | FLAG_HALF_CARRY);
+}
+
+/* ---------------------------------------------------------------------------------------
+ * handlers for the regular blocks of the table, generated with macros
+ * --------------------------------------------------------------------------------------- */
+
+/* LD r,r' - 0x40 -> 0x7F */
+#define LD_R_R(dst, src) \
+    OPCODE(ld_##dst##_##src, 1) { p->registers.dst = p->registers.src; return 0; }
+
+#define LD_R_ALL(dst) \
+    LD_R_R(dst, b) LD_R_R(dst, c) LD_R_R(dst, d) LD_R_R(dst, e) \
+    LD_R_R(dst, h) LD_R_R(dst, l) LD_R_R(dst, a) \
+    OPCODE(ld_##dst##_mhl, 1) { p->registers.dst = read_byte(p, get_hl(p)); return 0; } \
+    OPCODE(ld_mhl_##dst, 1) { write_byte(p, get_hl(p), p->registers.dst); return 0; }
+
+LD_R_ALL(b) LD_R_ALL(c) LD_R_ALL(d) LD_R_ALL(e)
+LD_R_ALL(h) LD_R_ALL(l) LD_R_ALL(a)
+
+/* LD r,d8 / INC r / DEC r */
+#define R_IMM_INC_DEC(r) \
+    OPCODE(ld_##r##_d8, 2) { p->registers.r = (uint8_t) operand; return 0; } \
+    OPCODE(inc_##r, 1) { p->registers.r = alu_inc(p, p->registers.r); return 0; } \
+    OPCODE(dec_##r, 1) { p->registers.r = alu_dec(p, p->registers.r); return 0; }
+
+R_IMM_INC_DEC(b) R_IMM_INC_DEC(c) R_IMM_INC_DEC(d) R_IMM_INC_DEC(e)
+R_IMM_INC_DEC(h) R_IMM_INC_DEC(l) R_IMM_INC_DEC(a)
+
+/* LD rr,d16 / INC rr / DEC rr / ADD HL,rr */
+#define PAIR_OPS(rr) \
+    OPCODE(ld_##rr##_d16, 3) { set_##rr(p, operand); return 0; } \
+    OPCODE(inc_##rr, 1) { set_##rr(p, get_##rr(p) + 1); return 0; } \
+    OPCODE(dec_##rr, 1) { set_##rr(p, get_##rr(p) - 1); return 0; } \
+    OPCODE(add_hl_##rr, 1) { alu_add_hl(p, get_##rr(p)); return 0; }
+
+PAIR_OPS(bc) PAIR_OPS(de) PAIR_OPS(hl) PAIR_OPS(sp)
+
+/* PUSH rr / POP rr */
+#define STACK_OPS(rr) \
+    OPCODE(push_##rr, 1) { push_word(p, get_##rr(p)); return 0; } \
+    OPCODE(pop_##rr, 1) { set_##rr(p, pop_word(p)); return 0; }
+
+STACK_OPS(bc) STACK_OPS(de) STACK_OPS(hl) STACK_OPS(af)
+
+/* ALU A,r - 0x80 -> 0xBF, plus the d8 versions */
+#define ALU_ALL(op) \
+    OPCODE(op##_a_b, 1) { alu_##op(p, p->registers.b); return 0; } \
+    OPCODE(op##_a_c, 1) { alu_##op(p, p->registers.c); return 0; } \
+    OPCODE(op##_a_d, 1) { alu_##op(p, p->registers.d); return 0; } \
+    OPCODE(op##_a_e, 1) { alu_##op(p, p->registers.e); return 0; } \
+    OPCODE(op##_a_h, 1) { alu_##op(p, p->registers.h); return 0; } \
+    OPCODE(op##_a_l, 1) { alu_##op(p, p->registers.l); return 0; } \
+    OPCODE(op##_a_mhl, 1) { alu_##op(p, read_byte(p, get_hl(p))); return 0; } \
+    OPCODE(op##_a_a, 1) { alu_##op(p, p->registers.a); return 0; } \
+    OPCODE(op##_a_d8, 2) { alu_##op(p, (uint8_t) operand); return 0; }
+
+ALU_ALL(add) ALU_ALL(adc) ALU_ALL(sub) ALU_ALL(sbc)
+ALU_ALL(and) ALU_ALL(xor) ALU_ALL(or)  ALU_ALL(cp)
+
+/* conditions for JR/JP/CALL/RET */
+#define COND_NZ (!flag_zero(p))
+#define COND_Z  (flag_zero(p))
+#define COND_NC (!flag_carry(p))
+#define COND_C  (flag_carry(p))
+
+#define BRANCH_OPS(cc) \
+    OPCODE(jr_##cc, 2) { \
+        if (!COND_##cc) return 0; \
+        p->pc += (int8_t) operand; \
+        return 1; \
+    } \
+    OPCODE(jp_##cc, 3) { \
+        if (!COND_##cc) return 0; \
+        p->pc = operand; \
+        return 1; \
+    } \
+    OPCODE(call_##cc, 3) { \
+        if (!COND_##cc) return 0; \
+        push_word(p, p->pc); \
+        p->pc = operand; \
+        return 1; \
+    } \
+    OPCODE(ret_##cc, 1) { \
+        if (!COND_##cc) return 0; \
+        p->pc = pop_word(p); \
+        return 1; \
+    }
+
+BRANCH_OPS(NZ) BRANCH_OPS(Z) BRANCH_OPS(NC) BRANCH_OPS(C)
+
+/* RST n, call to a fixed address */
+#define RST(n) \
+    OPCODE(rst_##n, 1) { push_word(p, p->pc); p->pc = 0x##n; return 0; }
+
+RST(00) RST(08) RST(10) RST(18) RST(20) RST(28) RST(30) RST(38)
+
+/* ---------------------------------------------------------------------------------------
+ * everything else in the main table
+ * --------------------------------------------------------------------------------------- */
+
+OPCODE(nop, 1) {
+    return 0;
+}
+
+OPCODE(illegal, 1) {
+    // the real cpu locks up here, just skip over it
+    debug_print("illegal opcode %02X at %04X\n", read_byte(p, p->pc - 1), p->pc - 1);
+    return 0;
+}
+
+OPCODE(ld_mbc_a, 1) { write_byte(p, get_bc(p), p->registers.a); return 0; }
+OPCODE(ld_mde_a, 1) { write_byte(p, get_de(p), p->registers.a); return 0; }
+OPCODE(ld_a_mbc, 1) { p->registers.a = read_byte(p, get_bc(p)); return 0; }
+OPCODE(ld_a_mde, 1) { p->registers.a = read_byte(p, get_de(p)); return 0; }
+
+OPCODE(ld_mhli_a, 1) {
+    // LD (HL+),A
+    write_byte(p, get_hl(p), p->registers.a);
+    proc_inc_hl(p);
+    return 0;
+}
+
+OPCODE(ld_mhld_a, 1) {
+    // LD (HL-),A
+    write_byte(p, get_hl(p), p->registers.a);
+    proc_dec_hl(p);
+    return 0;
+}
+
+OPCODE(ld_a_mhli, 1) {
+    // LD A,(HL+)
+    p->registers.a = read_byte(p, get_hl(p));
+    proc_inc_hl(p);
+    return 0;
+}
+
+OPCODE(ld_a_mhld, 1) {
+    // LD A,(HL-)
+    p->registers.a = read_byte(p, get_hl(p));
+    proc_dec_hl(p);
+    return 0;
+}
+
+OPCODE(ld_mhl_d8, 2) { write_byte(p, get_hl(p), (uint8_t) operand); return 0; }
+
+OPCODE(inc_mhl, 1) {
+    uint16_t hl = get_hl(p);
+    write_byte(p, hl, alu_inc(p, read_byte(p, hl)));
+    return 0;
+}
+
+OPCODE(dec_mhl, 1) {
+    uint16_t hl = get_hl(p);
+    write_byte(p, hl, alu_dec(p, read_byte(p, hl)));
+    return 0;
+}
+
+OPCODE(ld_ma16_sp, 3) {
+    // LD (a16),SP
+    write_byte(p, operand, get_lower_8bit_value(p->sp));
+    write_byte(p, operand + 1, get_upper_8bit_value(p->sp));
+    return 0;
+}
+
+/* rotates on A always clear the zero flag, unlike the CB versions */
+OPCODE(rlca, 1) { p->registers.a = alu_rlc(p, p->registers.a); p->registers.f &= ~FLAG_ZERO; return 0; }
+OPCODE(rrca, 1) { p->registers.a = alu_rrc(p, p->registers.a); p->registers.f &= ~FLAG_ZERO; return 0; }
+OPCODE(rla, 1)  { p->registers.a = alu_rl(p, p->registers.a);  p->registers.f &= ~FLAG_ZERO; return 0; }
+OPCODE(rra, 1)  { p->registers.a = alu_rr(p, p->registers.a);  p->registers.f &= ~FLAG_ZERO; return 0; }
+
+OPCODE(daa, 1) { alu_daa(p); return 0; }
+
+OPCODE(cpl, 1) {
+    // - 1 1 -
+    p->registers.a = ~p->registers.a;
+    update_flags(p, FLAG_ZERO | FLAG_CARRY, FLAG_SUBTRACT | FLAG_HALF_CARRY);
+    return 0;
+}
+
+OPCODE(scf, 1) {
+    // - 0 0 1
+    update_flags(p, FLAG_ZERO, FLAG_CARRY);
+    return 0;
+}
+
+OPCODE(ccf, 1) {
+    // - 0 0 C
+    update_flags(p, FLAG_ZERO | FLAG_CARRY, 0);
+    p->registers.f ^= FLAG_CARRY;
+    return 0;
+}
+
+OPCODE(stop, 2) {
+    // STOP 0, sleeps until a button is pressed and resets the divider
+    write_byte(p, IO_DIV, 0);
+    p->stopped = 1;
+    p->stats.halts++;
+    p->deadline = p->cycles;
+    return 0;
+}
+
+OPCODE(halt, 1) {
+    // sleeps until an interrupt is pending, proc_run_cycles does the waiting
+    p->halted = 1;
+    p->stats.halts++;
+    p->deadline = p->cycles;
+    return 0;
+}
+
+OPCODE(di, 1) {
+    p->ime = 0;
+    p->ei_pending = 0;
+    return 0;
+}
+
+OPCODE(ei, 1) {
+    // takes effect after the next instruction, see handle_interrupts
+    p->ei_pending = 1;
+    p->deadline = p->cycles;
+    return 0;
+}
+
+OPCODE(jr, 2) {
+    p->pc += (int8_t) operand;
+    return 0;
+}
+
+OPCODE(jp, 3) {
+    p->pc = operand;
+    return 0;
+}
+
+OPCODE(jp_hl, 1) {
+    // JP (HL), jumps to the address in HL, not the value in memory at HL
+    p->pc = get_hl(p);
+    return 0;
+}
+
+OPCODE(call, 3) {
+    push_word(p, p->pc);
+    p->pc = operand;
+    return 0;
+}
+
+OPCODE(ret, 1) {
+    p->pc = pop_word(p);
+    return 0;
+}
+
+OPCODE(reti, 1) {
+    // unlike EI this is straight away
+    p->pc = pop_word(p);
+    p->ime = 1;
+    p->deadline = p->cycles;
+    return 0;
+}
+
+OPCODE(ldh_ma8_a, 2) { write_byte(p, 0xFF00 + (uint8_t) operand, p->registers.a); return 0; }
+OPCODE(ldh_a_ma8, 2) { p->registers.a = read_byte(p, 0xFF00 + (uint8_t) operand); return 0; }
+OPCODE(ld_mc_a, 1) { write_byte(p, 0xFF00 + p->registers.c, p->registers.a); return 0; }
+OPCODE(ld_a_mc, 1) { p->registers.a = read_byte(p, 0xFF00 + p->registers.c); return 0; }
+OPCODE(ld_ma16_a, 3) { write_byte(p, operand, p->registers.a); return 0; }
+OPCODE(ld_a_ma16, 3) { p->registers.a = read_byte(p, operand); return 0; }
+
+OPCODE(add_sp_r8, 2) { p->sp = alu_add_sp(p, (int8_t) operand); return 0; }
+OPCODE(ld_hl_sp_r8, 2) { set_hl(p, alu_add_sp(p, (int8_t) operand)); return 0; }
+OPCODE(ld_sp_hl, 1) { p->sp = get_hl(p); return 0; }
+
+static int prefix_cb(Proc* p, uint16_t operand);
+
+/* ---------------------------------------------------------------------------------------
+ * CB prefixed handlers, fully regular so they are all generated
+ * --------------------------------------------------------------------------------------- */
+
+#define CB_REG(op, r) \
+    OPCODE(cb_##op##_##r, 2) { p->registers.r = alu_##op(p, p->registers.r); return 0; }
+
+#define CB_SHIFT(op) \
+    CB_REG(op, b) CB_REG(op, c) CB_REG(op, d) CB_REG(op, e) \
+    CB_REG(op, h) CB_REG(op, l) CB_REG(op, a) \
+    OPCODE(cb_##op##_mhl, 2) { \
+        uint16_t hl = get_hl(p); \
+        write_byte(p, hl, alu_##op(p, read_byte(p, hl))); \
+        return 0; \
+    }
+
+CB_SHIFT(rlc) CB_SHIFT(rrc) CB_SHIFT(rl)   CB_SHIFT(rr)
+CB_SHIFT(sla) CB_SHIFT(sra) CB_SHIFT(swap) CB_SHIFT(srl)
+
+#define CB_BIT_REG(n, r) \
+    OPCODE(cb_bit_##n##_##r, 2) { alu_bit(p, n, p->registers.r); return 0; } \
+    OPCODE(cb_res_##n##_##r, 2) { p->registers.r &= ~(1 << n); return 0; } \
+    OPCODE(cb_set_##n##_##r, 2) { p->registers.r |= (1 << n); return 0; }
+
+#define CB_BIT(n) \
+    CB_BIT_REG(n, b) CB_BIT_REG(n, c) CB_BIT_REG(n, d) CB_BIT_REG(n, e) \
+    CB_BIT_REG(n, h) CB_BIT_REG(n, l) CB_BIT_REG(n, a) \
+    OPCODE(cb_bit_##n##_mhl, 2) { alu_bit(p, n, read_byte(p, get_hl(p))); return 0; } \
+    OPCODE(cb_res_##n##_mhl, 2) { \
+        uint16_t hl = get_hl(p); \
+        write_byte(p, hl, read_byte(p, hl) & ~(1 << n)); \
+        return 0; \
+    } \
+    OPCODE(cb_set_##n##_mhl, 2) { \
+        uint16_t hl = get_hl(p); \
+        write_byte(p, hl, read_byte(p, hl) | (1 << n)); \
+        return 0; \
+    }
+
+CB_BIT(0) CB_BIT(1) CB_BIT(2) CB_BIT(3)
+CB_BIT(4) CB_BIT(5) CB_BIT(6) CB_BIT(7)
+
+/* ---------------------------------------------------------------------------------------
+ * dispatch tables, indexed by opcode
+ * --------------------------------------------------------------------------------------- */
+
+/* the operand order of every regular row, B C D E H L (HL) A */
+#define ROW(prefix, suffix) \
+    prefix##b##suffix, prefix##c##suffix, prefix##d##suffix, prefix##e##suffix, \
+    prefix##h##suffix, prefix##l##suffix, prefix##mhl##suffix, prefix##a##suffix
+
+static const OpHandler opcode_table[256] = {
+    /* 0x00 */ nop,       ld_bc_d16, ld_mbc_a,  inc_bc,    inc_b,     dec_b,     ld_b_d8,   rlca,
+    /* 0x08 */ ld_ma16_sp, add_hl_bc, ld_a_mbc, dec_bc,    inc_c,     dec_c,     ld_c_d8,   rrca,
+    /* 0x10 */ stop,      ld_de_d16, ld_mde_a,  inc_de,    inc_d,     dec_d,     ld_d_d8,   rla,
+    /* 0x18 */ jr,        add_hl_de, ld_a_mde,  dec_de,    inc_e,     dec_e,     ld_e_d8,   rra,
+    /* 0x20 */ jr_NZ,     ld_hl_d16, ld_mhli_a, inc_hl,    inc_h,     dec_h,     ld_h_d8,   daa,
+    /* 0x28 */ jr_Z,      add_hl_hl, ld_a_mhli, dec_hl,    inc_l,     dec_l,     ld_l_d8,   cpl,
+    /* 0x30 */ jr_NC,     ld_sp_d16, ld_mhld_a, inc_sp,    inc_mhl,   dec_mhl,   ld_mhl_d8, scf,
+    /* 0x38 */ jr_C,      add_hl_sp, ld_a_mhld, dec_sp,    inc_a,     dec_a,     ld_a_d8,   ccf,
+    /* 0x40 */ ROW(ld_b_, ),
+    /* 0x48 */ ROW(ld_c_, ),
+    /* 0x50 */ ROW(ld_d_, ),
+    /* 0x58 */ ROW(ld_e_, ),
+    /* 0x60 */ ROW(ld_h_, ),
+    /* 0x68 */ ROW(ld_l_, ),
+    /* 0x70 */ ld_mhl_b,  ld_mhl_c,  ld_mhl_d,  ld_mhl_e,  ld_mhl_h,  ld_mhl_l,  halt,      ld_mhl_a,
+    /* 0x78 */ ROW(ld_a_, ),
+    /* 0x80 */ ROW(add_a_, ),
+    /* 0x88 */ ROW(adc_a_, ),
+    /* 0x90 */ ROW(sub_a_, ),
+    /* 0x98 */ ROW(sbc_a_, ),
+    /* 0xA0 */ ROW(and_a_, ),
+    /* 0xA8 */ ROW(xor_a_, ),
+    /* 0xB0 */ ROW(or_a_, ),
+    /* 0xB8 */ ROW(cp_a_, ),
+    /* 0xC0 */ ret_NZ,    pop_bc,    jp_NZ,     jp,        call_NZ,   push_bc,   add_a_d8,  rst_00,
+    /* 0xC8 */ ret_Z,     ret,       jp_Z,      prefix_cb, call_Z,    call,      adc_a_d8,  rst_08,
+    /* 0xD0 */ ret_NC,    pop_de,    jp_NC,     illegal,   call_NC,   push_de,   sub_a_d8,  rst_10,
+    /* 0xD8 */ ret_C,     reti,      jp_C,      illegal,   call_C,    illegal,   sbc_a_d8,  rst_18,
+    /* 0xE0 */ ldh_ma8_a, pop_hl,    ld_mc_a,   illegal,   illegal,   push_hl,   and_a_d8,  rst_20,
+    /* 0xE8 */ add_sp_r8, jp_hl,     ld_ma16_a, illegal,   illegal,   illegal,   xor_a_d8,  rst_28,
+    /* 0xF0 */ ldh_a_ma8, pop_af,    ld_a_mc,   di,        illegal,   push_af,   or_a_d8,   rst_30,
+    /* 0xF8 */ ld_hl_sp_r8, ld_sp_hl, ld_a_ma16, ei,       illegal,   illegal,   cp_a_d8,   rst_38,
+};
+
+static const OpHandler cb_opcode_table[256] = {
+    /* 0x00 */ ROW(cb_rlc_, ),   ROW(cb_rrc_, ),
+    /* 0x10 */ ROW(cb_rl_, ),    ROW(cb_rr_, ),
+    /* 0x20 */ ROW(cb_sla_, ),   ROW(cb_sra_, ),
+    /* 0x30 */ ROW(cb_swap_, ),  ROW(cb_srl_, ),
+    /* 0x40 */ ROW(cb_bit_0_, ), ROW(cb_bit_1_, ),
+    /* 0x50 */ ROW(cb_bit_2_, ), ROW(cb_bit_3_, ),
+    /* 0x60 */ ROW(cb_bit_4_, ), ROW(cb_bit_5_, ),
+    /* 0x70 */ ROW(cb_bit_6_, ), ROW(cb_bit_7_, ),
+    /* 0x80 */ ROW(cb_res_0_, ), ROW(cb_res_1_, ),
+    /* 0x90 */ ROW(cb_res_2_, ), ROW(cb_res_3_, ),
+    /* 0xA0 */ ROW(cb_res_4_, ), ROW(cb_res_5_, ),
+    /* 0xB0 */ ROW(cb_res_6_, ), ROW(cb_res_7_, ),
+    /* 0xC0 */ ROW(cb_set_0_, ), ROW(cb_set_1_, ),
+    /* 0xD0 */ ROW(cb_set_2_, ), ROW(cb_set_3_, ),
+    /* 0xE0 */ ROW(cb_set_4_, ), ROW(cb_set_5_, ),
+    /* 0xF0 */ ROW(cb_set_6_, ), ROW(cb_set_7_, ),
+};
+
+OPCODE(prefix_cb, 0) {
+    /* decode() goes straight to the cb table, this only runs if something calls the table directly
+     * the cb handler moves pc past both bytes
+     */
+    return cb_opcode_table[(uint8_t) operand](p, operand);
+}
+
+/* ---------------------------------------------------------------------------------------
+ * decode and run
+ * --------------------------------------------------------------------------------------- */
+
+static inline int decode(Proc* p, uint16_t address, MicroOp* op) {
+    /* decodes the instruction at address, returns 1 if it ends a basic block */
+    uint8_t opcode = read_byte(p, address);
+    const OpcodeInfo * info = &opcode_info[opcode];
+
+    op->operand = fetch_operand(p, address);
+    op->handler = opcode_table[opcode];
+
+    if (opcode == 0xCB) {
+        // the cb op is the whole instruction, its timing and length include the prefix
+        info = &cb_opcode_info[(uint8_t) op->operand];
+        op->handler = cb_opcode_table[(uint8_t) op->operand];
+    }
+
+    op->length = info->length;
+    op->cycles = info->cycles;
+    op->cycles_taken = info->cycles_taken;
+
+    return info->ends_block;
+}
+
+static inline int execute(Proc* p, const MicroOp* op) {
+    int cycles = op->handler(p, op->operand) ? op->cycles_taken : op->cycles;
+    p->cycles += cycles;
+
+    return cycles;
+}
+
+int proc_read_word(Proc *p) {
+    /* runs a single instruction, returns the number of cycles it took */
+    if (!p) return 0;
+
+    MicroOp op;
+    decode(p, p->pc, &op);
+
+    debug_print("%04X %s\n", p->pc, opcode_info[read_byte(p, p->pc)].mnemonic);
+
+    return execute(p, &op);
+}
+
+static inline int is_cacheable(uint16_t address) {
+    /* rom, work ram and high ram, everything else is banked or too close to io to bother */
+    return address < 0x8000
+        || (address >= 0xC000 && address < 0xE000)
+        || (address >= 0xFF80 && address < 0xFFFF);
+}
+
+static inline uint16_t code_bank(Proc* p, uint16_t address) {
+    // the rom bank the code was read from, everything else only has the one
+    return address < 0x8000 ? p->rom_map_bank[address >> 14] : 0;
+}
+
+static Block * build_block(Proc* p, uint16_t start) {
+    Block * b = block_cache_new_block(p->block_cache);
+    if (!b) return NULL;
+
+    b->start = start;
+    b->bank = code_bank(p, start);
+    b->count = 0;
+    b->max_cycles = 0;
+    b->runs = 0;
+    b->rejected = 0;
+    b->native = NULL;
+    b->idle = 0;
+
+    uint16_t address = start;
+    int ends = 0;
+    // blocks stay in one rom bank, the bank is only checked for where they start and a bank
+    // switch stops the running block (cart_map)
+    uint16_t region = start & 0xC000;
+    while (!ends && b->count < MAX_BLOCK_OPS && is_cacheable(address) && (address & 0xC000) == region) {
+        MicroOp * op = &b->ops[b->count++];
+        ends = decode(p, address, op);
+        address += op->length;
+        b->max_cycles += op->cycles_taken;
+    }
+    b->bytes = (uint16_t) (address - start);
+
+    b->idle = idle_loop_detect(p, b);
+    if (b->idle) p->stats.idle_loops++;
+
+    block_cache_insert(p->block_cache, b);
+    // writes to ram with code in it have to check for it
+    memory_protect_code(p, b->start, b->bytes);
+    return b;
+}
+
+static void skip_idle_loop(Proc* p, Block* b, uint64_t iteration) {
+    /* b is a polling loop (idle.h) that just went all the way round, nothing it reads can
+     * change before the deadline so every time round until then is the same as this one
+     */
+    if (!p->skip_idle_loops || !b->valid || p->pc != b->start || p->cycles >= p->deadline) return;
+    if (!iteration || !idle_loop_reads_fixed(p, b->idle)) return;
+
+    // whole iterations only, the one that reaches the deadline runs normally
+    uint64_t skipped = (p->deadline - p->cycles) / iteration * iteration;
+    p->cycles += skipped;
+
+    p->stats.idle_skips++;
+    p->stats.idle_cycles += skipped;
+}
+
+int proc_run_block(Proc* p) {
+    /* runs the block at pc from the cache (building it if needed) until it ends or
+     * p->deadline passes, returns the number of cycles run
+     */
+    if (!p) return 0;
+
+    if (!p->block_cache || !is_cacheable(p->pc)) {
+        return proc_read_word(p);
+    }
+
+    Block * b = block_cache_lookup(p->block_cache, p->pc, code_bank(p, p->pc));
+    if (!b) {
+        b = build_block(p, p->pc);
+        if (!b) return proc_read_word(p);
+    }
+
+    if (p->jit) {
+        if (!b->native && !b->rejected && ++b->runs >= p->jit->threshold) {
+            jit_compile(p->jit, p, b);
         }
-        case 0xCA:
-            // JP Z,a16
-            // 3 16/12
-            // - - - -
-            debug_print("JP Z,a16\n", NULL);
-            // jump if z flag is set
-            if (p->flagRegister.zero) {
-                p->pc = p->memory[p->pc + 1] + (p->memory[p->pc + 2] << 8);
-                bytes_ate = 0;
-            }
-			
-			break;
-        case 0xCB:
-            // PREFIX CB
-            // 1 4
-            // - - - -
-            proc_handle_cb_prefix(p);
-            bytes_ate = 2;
-            debug_print("PREFIX CB\n", NULL);
-			break;
-        case 0xCC:
-            // CALL Z,a16
-            // 3 24/12
-            // - - - -
-            debug_print("CALL Z,a16\n", NULL);
-			break;
-        case 0xCD:
-            // CALL a16
-            // 3 24
-            // - - - -
-            debug_print("CALL a16\n", NULL);
-			break;
-        case 0xCE:
-            // ADC A,d8
-            // 2 8
-            // Z 0 H C
-            RESET_SUBTRACT;
-            d8 = p->memory[p->pc + 1];
-            bytes_ate = 2;
-            debug_print("ADC A,d8\n", NULL);
-			break;
-        case 0xCF:
-            // RST 08H
-            // 1 16
-            // - - - -
-            debug_print("RST 08H\n", NULL);
-			break;
-        case 0xD0:
-            // RET NC
-            // 1 20/8
-            // - - - -
-            debug_print("RET NC\n", NULL);
-            if (p->flagRegister.carry == CLEAR) {
-                goto RETURN_CASE;
-            }
-			break;
-        case 0xD1:
-            // POP DE
-            // 1 12
-            // - - - -
-            debug_print("POP DE\n", NULL);
-            SET_REG(&p->registers.e, p->memory[p->sp]);
-            SET_REG(&p->registers.d, p->memory[p->sp - 1]);
-            p->sp += 2;
-			break;
-        case 0xD2:
-            // JP NC,a16
-            // 3 16/12
-            // - - - -
-            debug_print("JP NC,a16\n", NULL);
-            
-            if (!p->flagRegister.carry) {
-                p->pc = p->memory[p->pc + 1] + (p->memory[p->pc + 2] << 8);
-                bytes_ate = 0;
-            }
-			
-			break;
-        case 0xD3:
-            break;
-        case 0xD4:
-            // CALL NC,a16
-            // 3 24/12
-            // - - - -
-            debug_print("CALL NC,a16\n", NULL);
-			break;
-        case 0xD5:
-            // PUSH DE
-            // 1 16
-            // - - - -
-            debug_print("PUSH DE\n", NULL);
-            p->memory[p->sp] = p->registers.e;
-            p->memory[p->sp - 1] = p->registers.d;
-            p->sp -= 2;
-			break;
-        case 0xD6: {
-            // SUB d8
-            // 2 8
-            // Z 1 H C
-            debug_print("SUB d8\n", NULL);
-            d8 = p->memory[p->pc + 1];
-            bytes_ate = 2;
-            uint16_t result = (uint16_t) p->registers.a - (uint16_t) d8;
-            p->flagRegister.carry = (result & 0xFF00) > 0;
-            p->flagRegister.half_carry = is_half_carry_sub(p->registers.a, d8);
-            SET_REG(&p->registers.a, result & 0xFF);
-            CHECK_AND_SET_ZERO(p->registers.a);
-			break;
+
+        // native code can't stop part way through, only use it when the whole block fits
+        if (b->native && p->cycles + b->max_cycles <= p->deadline) {
+            int cycles = jit_run(p, b);
+            if (b->idle) skip_idle_loop(p, b, cycles);
+            return cycles;
         }
-        case 0xD7:
-            // RST 10H
-            // 1 16
-            // - - - -
-            debug_print("RST 10H\n", NULL);
-			break;
-        case 0xD8:
-            // RET C
-            // 1 20/8
-            // - - - -
-            debug_print("RET C\n", NULL);
-            if (p->flagRegister.carry == SET) {
-                goto RETURN_CASE;
-            }
-			break;
-        case 0xD9:
-            //  RETI
-            // 1 16
-            // - - - -
-            debug_print("RETI\n", NULL);
-			break;
-        case 0xDA:
-            // JP C,a16
-            // 3 16/12
-            // - - - -
-            debug_print("JP C,a16\n", NULL);
-		    if (p->flagRegister.carry) {
-                p->pc = p->memory[p->pc + 1] + (p->memory[p->pc + 2] << 8);
-                bytes_ate = 0;
+    }
+
+    uint64_t start = p->cycles;
+    for (int i = 0; i < b->count; i++) {
+        execute(p, &b->ops[i]);
+
+        // stop if the block wrote over itself, pc is already pointing at the next instruction
+        if (!b->valid || p->cycles >= p->deadline) break;
+    }
+
+    if (b->idle) skip_idle_loop(p, b, p->cycles - start);
+
+    return p->cycles - start;
+}
+
+static void handle_interrupts(Proc* p) {
+    /* called between instructions whenever the deadline is hit */
+    if (p->ei_pending) {
+        // EI enables interrupts after the instruction following it, DI there cancels it
+        proc_read_word(p);
+        if (p->ei_pending) p->ime = 1;
+        p->ei_pending = 0;
+    }
+
+    uint8_t pending = p->memory[IO_IF] & p->memory[IO_IE] & 0x1F;
+    if (!pending) return;
+
+    // HALT wakes up on any pending interrupt, even with IME off
+    p->halted = 0;
+    if (!p->ime) return;
+
+    // the lowest bit goes first, its vector is 0x40 + 8 * bit
+    int n = 0;
+    while (!(pending & (1 << n))) n++;
+
+    p->memory[IO_IF] &= ~(1 << n);
+    p->ime = 0;
+    push_word(p, p->pc);
+    p->pc = 0x40 + 8 * n;
+    p->cycles += 20;
+}
+
+uint64_t proc_run_cycles(Proc* p, uint64_t cycles) {
+    /* runs whole instructions until at least the given number of cycles have passed,
+     * returns the number actually run so the caller can carry the overshoot into the next call
+     */
+    if (!p) return 0;
+
+    uint64_t start = p->cycles;
+    uint64_t end = start + cycles;
+    while (p->cycles < end) {
+        // run straight to whichever comes first, anything that needs to stop sooner lowers the deadline
+        uint64_t next = scheduler_next(&p->scheduler);
+        p->deadline = next < end ? next : end;
+
+        while (p->cycles < p->deadline) {
+            if (p->halted || p->stopped) {
+                // nothing can wake the cpu before the next event, skip straight to it
+                p->stats.halted_cycles += p->deadline - p->cycles;
+                p->cycles = p->deadline;
+            } else {
+                proc_run_block(p);
             }
-            break;
-        case 0xDB:
-            break;
-        case 0xDC:
-            // CALL C,a16
-            // 3 24/12
-            // - - - -
-            debug_print("CALL C,a16\n", NULL);
-			break;
-        case 0xDD:
-            break;
-        case 0xDE:
-            // SBC A,d8
-            // 2 8
-            // Z 1 H C
-            SET_SUBTRACT;
-            d8 = p->memory[p->pc + 1];
-            bytes_ate = 2;
-            debug_print("SBC A,d8\n", NULL);
-            CHECK_AND_SET_ZERO(p->registers.a);
-			break;
-        case 0xDF:
-            // RST 18H
-            // 1 16
-            // - - - -
-            debug_print("RST 18H\n", NULL);
-			break;
-        case 0xE0:
-            // LDH (a8),A
-            // 2 12
-            // - - - -
-            debug_print("LDH (a8),A\n", NULL);
-			p->memory[0xFF00 + p->memory[p->pc + 1]] = p->registers.a;
-            bytes_ate = 2;
-            break;
-        case 0xE1:
-            // POP HL
-            // 1 12
-            // - - - -
-            debug_print("POP HL\n", NULL);
-            SET_REG(&p->registers.l, p->memory[p->sp]);
-            SET_REG(&p->registers.h, p->memory[p->sp - 1]);
-            p->sp += 2;
-			break;
-        case 0xE2:
-            // LD (C),A
-            // 2 8
-            // - - - -
-            debug_print("LD (C),A\n", NULL);
-            // another possible error
-            write_byte(p, 0xFF00 + p->registers.c, p->registers.a);
-			break;
-        case 0xE3:
-            break;
-        case 0xE4:
-            break;
-        case 0xE5:
-            // PUSH HL
-            // 1 16
-            // - - - -
-            debug_print("PUSH HL\n", NULL);
-            write_byte(p, p->sp, p->registers.l);
-            write_byte(p, p->sp - 1, p->registers.h);
-            p->sp -= 2;
-			break;
-        case 0xE6:
-            // AND d8
-            // 2 8
-            // Z 0 1 0
-            RESET_SUBTRACT;
-            SET_HALF_CARRY;
-            RESET_CARRY;
-
-            d8 = p->memory[p->pc + 1];
-            bytes_ate = 2;
-            SET_REG(&p->registers.a, p->registers.a && d8);
-            p->flagRegister.zero = p->registers.a == 0;
-            debug_print("AND d8\n", NULL);
-			break;
-        case 0xE7:
-            // RST 20H
-            // 1 16
-            // - - - -
-            debug_print("RST 20H\n", NULL);
-			break;
-        case 0xE8:
-            // ADD SP,r8
-            // 2 16
-            // 0 0 H C
-            RESET_ZERO;
-            RESET_SUBTRACT;
-            debug_print("ADD SP,r8\n", NULL);
-			break;
-        case 0xE9:
-            // JP (HL)
-            // 1 4
-            // - - - -
-            debug_print("JP (HL)\n", NULL);
-            // todo i think this is right
-            p->pc = p->memory[((uint16_t)p->registers.h << 8) + (uint16_t)(p->registers.l)];
-            bytes_ate = 0;
-			break;
-        case 0xEA:
-            // LD (a16),A
-            // 3 16
-            // - - - -
-            debug_print("LD (a16),A\n", NULL);
-            write_byte(p, (p->memory[p->pc + 2] << 8) + p->memory[p->pc + 1], p->registers.a);
-			bytes_ate = 3;
-            break;
-        case 0xEB:
-            break;
-        case 0xEC:
-            break;
-        case 0xED:
-            break;
-        case 0xEE:
-            // XOR d8
-            // 2 8
-            // Z 0 0 0
-            RESET_SUBTRACT;
-            RESET_HALF_CARRY;
-            RESET_CARRY;
-
-            d8 = p->memory[p->pc + 1];
-            bytes_ate = 2;
-
-            CHECK_AND_SET_ZERO(p->registers.a);
-            debug_print("XOR d8\n", NULL);
-			break;
-        case 0xEF:
-            // RST 28H
-            // 1 16
-            // - - - -
-            debug_print("RST 28H\n", NULL);
-			break;
-        case 0xF0:
-            // LDH A,(a8)
-            // 2 12
-            // - - - -
-            debug_print("LDH A,(a8)\n", NULL);
-            SET_REG(&p->registers.a, p->memory[0xFF00 + p->memory[p->pc + 1]]);
-            bytes_ate = 2;
-			break;
-        case 0xF1:
-            // POP AF
-            // 1 12
-            // Z N H C
-            // TODO not sure what it means to check if zero?
-            debug_print("POP AF\n", NULL);
-            SET_REG(&p->registers.f, p->memory[p->sp]);
-            SET_REG(&p->registers.a, p->memory[p->sp - 1]);
-            p->sp += 2;
-			break;
-        case 0xF2:
-            // LD A,(C)
-            // 2 8
-            // - - - -
-            // i think the 2 is wrong... idk possible error
-            SET_REG(&p->registers.a, p->memory[p->registers.c + 0xFF00]);
-            debug_print("LD A,(C)\n", NULL);
-			break;
-        case 0xF3:
-            //  DI
-            // 1 4
-            // - - - -
-            debug_print("DI\n", NULL);
-			break;
-        case 0xF4:
-            break;
-        case 0xF5:
-            // PUSH AF
-            // 1 16
-            // - - - -
-            debug_print("PUSH AF\n", NULL);
-            write_byte(p, p->sp, p->registers.f);
-            write_byte(p, p->sp - 1, p->registers.a);
-            p->sp -= 2;
-			break;
-        case 0xF6:
-            // OR d8
-            // 2 8
-            // Z 0 0 0
-            RESET_SUBTRACT;
-            RESET_HALF_CARRY;
-            RESET_CARRY;
-
-            d8 = p->memory[p->pc + 1];
-            bytes_ate = 2;
-
-            CHECK_AND_SET_ZERO(p->registers.a);
-            debug_print("OR d8\n", NULL);
-			break;
-        case 0xF7:
-            // RST 30H
-            // 1 16
-            // - - - -
-            debug_print("RST 30H\n", NULL);
-			break;
-        case 0xF8:
-            // LD HL,SP+r8
-            // 2 12
-            // 0 0 H C
-            RESET_ZERO;
-            RESET_SUBTRACT;
-
-            debug_print("LD HL,SP+r8\n", NULL);
-            int8_t data  = p->memory[p->pc + 1];
-            uint16_t val = data + p->sp;
-
-            SET_REG(&p->registers.h, (val & 0xFF00) >> 8);
-            SET_REG(&p->registers.l, val & 0x00FF);
-            // https://robdor.com/2016/08/10/gameboy-emulator-half-carry-flag/
-            p->flagRegister.half_carry = is_half_carry_add(data, p->sp);
-            // ERROR MaYBE SKETCH
-            p->flagRegister.carry = (data >= 0) ? (p->sp > val) : (p->sp < val);
-            bytes_ate = 2;
-			break;
-        case 0xF9:
-            // LD SP,HL
-            // 1 8
-            // - - - -
-            debug_print("LD SP,HL\n", NULL);
-            p->sp = ((uint16_t)p->registers.h << 8) + (uint16_t)p->registers.l;
-			break;
-        case 0xFA:
-            // LD A,(a16)
-            // 3 16
-            // - - - -
-            SET_REG(&p->registers.a, p->memory[p->memory[p->pc + 1] + (p->memory[p->pc + 2] << 8)]);
-            bytes_ate = 3;
-            debug_print("LD A,(a16)\n", NULL);
-			break;
-        case 0xFB:
-            //  EI
-            // 1 4
-            // - - - -
-            debug_print("EI\n", NULL);
-			break;
-        case 0xFC:
-            break;
-        case 0xFD:
-            break;
-        case 0xFE: {
-            // CP d8
-            // 2 8
-            // Z 1 H C
-            SET_SUBTRACT;
-            d8 = p->memory[p->pc + 1];
-            p->flagRegister.zero = p->registers.a == d8;
-            p->flagRegister.half_carry = !is_half_carry_sub(p->registers.a, d8);
-            p->flagRegister.carry = p->registers.a < d8;
-            bytes_ate = 2;
-            debug_print("CP d8\n", NULL);
-			break;
         }
-        case 0xFF:
-            // RST 38H
-            // 1 16
-            // - - - -
-            debug_print("RST 38H\n", NULL);
-			break;
+
+        io_run_events(p);
+        handle_interrupts(p);
     }
 
-    p->pc += bytes_ate;
+    return p->cycles - start;
 }
 
-// TODO ...
-void proc_handle_cb_prefix(Proc *p) {
-
-    switch (p->memory[++p->pc]) {
-        case 0x0: {
-            // RLC B
-            // 2 8
-            // Z 0 0 C
-            RESET_SUBTRACT;
-            RESET_HALF_CARRY;
-            // grab carry bit
-            uint8_t c = p->registers.b >> 7;
-            // shift left 1 and drop carry on thurrr
-            SET_REG(&p->registers.b, (p->registers.b << 1) | c);
-
-            // set extra flags
-            p->flagRegister.carry = c;
-            p->flagRegister.zero = (p->registers.b == 0);
-
-            debug_print("RLC B\n", NULL);
-			break;
-        }
-        case 0x1: {
-            // RLC C
-            // 2 8
-            // Z 0 0 C
-            RESET_SUBTRACT;
-            RESET_HALF_CARRY;
-            // grab carry bit
-            uint8_t c = p->registers.c >> 7;
-            // shift left 1 and drop carry on thurrr
-            SET_REG(&p->registers.c, (p->registers.c << 1) | c);
-
-            // set extra flags
-            p->flagRegister.carry = c;
-            p->flagRegister.zero = (p->registers.c == 0);
-
-            debug_print("RLC C\n", NULL);
-			break;
-        }
-        case 0x2: {
-            // RLC D
-            // 2 8
-            // Z 0 0 C
-            RESET_SUBTRACT;
-            RESET_HALF_CARRY;
-            // grab carry bit
-            uint8_t c = p->registers.d >> 7;
-            // shift left 1 and drop carry on thurrr
-            SET_REG(&p->registers.d, (p->registers.d << 1) | c);
-
-            // set extra flags
-            p->flagRegister.carry = c;
-            p->flagRegister.zero = (p->registers.d == 0);
-
-            debug_print("RLC D\n", NULL);
-			break;
-        }
-        case 0x3: {
-            // RLC E
-            // 2 8
-            // Z 0 0 C
-            RESET_SUBTRACT;
-            RESET_HALF_CARRY;
-
-            // grab carry bit
-            uint8_t c = p->registers.e >> 7;
-            // shift left 1 and drop carry on thurrr
-            SET_REG(&p->registers.e, (p->registers.e << 1) | c);
-
-            // set extra flags
-            p->flagRegister.carry = c;
-            p->flagRegister.zero = (p->registers.e == 0);
-
-            debug_print("RLC E\n", NULL);
-			break;
-        }
-        case 0x4: {
-            // RLC H
-            // 2 8
-            // Z 0 0 C
-            RESET_SUBTRACT;
-            RESET_HALF_CARRY;
-
-            // grab carry bit
-            uint8_t c = p->registers.h >> 7;
-            // shift left 1 and drop carry on thurrr
-            SET_REG(&p->registers.h, (p->registers.h << 1) | c);
-
-            // set extra flags
-            p->flagRegister.carry = c;
-            p->flagRegister.zero = (p->registers.h == 0);
-
-            debug_print("RLC H\n", NULL);
-			break;
-        }
-        case 0x5: {
-            // RLC L
-            // 2 8
-            // Z 0 0 C
-            RESET_SUBTRACT;
-            RESET_HALF_CARRY;
-            // grab carry bit
-            uint8_t c = p->registers.l >> 7;
-            // shift left 1 and drop carry on thurrr
-            SET_REG(&p->registers.l, (p->registers.l << 1) | c);
-
-            // set extra flags
-            p->flagRegister.carry = c;
-            p->flagRegister.zero = (p->registers.l == 0);
-            debug_print("RLC L\n", NULL);
-			break;
-        }
-        case 0x6: {
-            // RLC (HL)
-            // 2 16
-            // Z 0 0 C
-            // grab carry bit
-            uint8_t c = p->memory[((uint16_t)p->registers.h << 8) + (uint16_t)(p->registers.l)] >> 7;
-            // shift left 1 and drop carry on thurrr
-            p->memory[((uint16_t)p->registers.h << 8) + (uint16_t)(p->registers.l)] = (p->memory[((uint16_t)p->registers.h << 8) + (uint16_t)(p->registers.l)] << 1) | c;
-
-            // set extra flags
-            p->flagRegister.carry = c;
-            p->flagRegister.zero = (p->memory[((uint16_t)p->registers.h << 8) + (uint16_t)(p->registers.l)] == 0);
-            RESET_SUBTRACT;
-            RESET_HALF_CARRY;
-            debug_print("RLC (HL)\n", NULL);
-			break;
-        }
-        case 0x7: {
-            // RLC A
-            // 2 8
-            // Z 0 0 C
-            RESET_SUBTRACT;
-            RESET_HALF_CARRY;
-            // grab carry bit
-            uint8_t c = p->registers.a >> 7;
-            // shift left 1 and drop carry on thurrr
-            SET_REG(&p->registers.a, (p->registers.a << 1) | c);
-
-            // set extra flags
-            p->flagRegister.carry = c;
-            p->flagRegister.zero = (p->registers.a == 0);
-            debug_print("RLC A\n", NULL);
-			break;
-        }
-        case 0x8: {
-            // RRC B
-            // 2 8
-            // Z 0 0 C
-            RESET_SUBTRACT;
-            RESET_HALF_CARRY;
-            uint8_t c = p->registers.b & 0x01; // right bit
-            SET_REG(&p->registers.b, (p->registers.b >> 1) | (c << 7));
-
-            p->flagRegister.zero  = (p->registers.b == 0);
-            p->flagRegister.carry = c;
-            debug_print("RRC B\n", NULL);
-			break;
-        }
-        case 0x9: {
-            // RRC C
-            // 2 8
-            // Z 0 0 C
-            RESET_SUBTRACT;
-            RESET_HALF_CARRY;
-            uint8_t c = p->registers.c & 0x01; // right bit
-            SET_REG(&p->registers.c, (p->registers.c >> 1) | (c << 7));
-
-            p->flagRegister.zero  = (p->registers.c == 0);
-            p->flagRegister.carry = c;
-            debug_print("RRC C\n", NULL);
-			break;
-        }
-        case 0xA: {
-            // RRC D
-            // 2 8
-            // Z 0 0 C
-            RESET_SUBTRACT;
-            RESET_HALF_CARRY;
-            uint8_t c = p->registers.d & 0x01; // right bit
-            SET_REG(&p->registers.d, (p->registers.d >> 1) | (c << 7));
-
-            p->flagRegister.zero  = (p->registers.d == 0);
-            p->flagRegister.carry = c;
-            debug_print("RRC D\n", NULL);
-			break;
-        }
-        case 0xB: {
-            // RRC E
-            // 2 8
-            // Z 0 0 C
-            RESET_SUBTRACT;
-            RESET_HALF_CARRY;
-            uint8_t c = p->registers.e & 0x01; // right bit
-            SET_REG(&p->registers.e, (p->registers.e >> 1) | (c << 7));
-
-            p->flagRegister.zero  = (p->registers.e == 0);
-            p->flagRegister.carry = c;
-            debug_print("RRC E\n", NULL);
-			break;
-        }
-        case 0xC: {
-            // RRC H
-            // 2 8
-            // Z 0 0 C
-            RESET_SUBTRACT;
-            RESET_HALF_CARRY;
-            uint8_t c = p->registers.h & 0x01; // right bit
-            SET_REG(&p->registers.h, (p->registers.h >> 1) | (c << 7));
-
-            p->flagRegister.zero  = (p->registers.h == 0);
-            p->flagRegister.carry = c;
-            debug_print("RRC H\n", NULL);
-			break;
-        }
-        case 0xD: {
-            // RRC L
-            // 2 8
-            // Z 0 0 C
-            RESET_SUBTRACT;
-            RESET_HALF_CARRY;
-            uint8_t c = p->registers.l & 0x01; // right bit
-            SET_REG(&p->registers.l, (p->registers.l >> 1) | (c << 7));
-
-            p->flagRegister.zero  = (p->registers.l == 0);
-            p->flagRegister.carry = c;
-            debug_print("RRC L\n", NULL);
-			break;
-        }
-        case 0xE: {
-            // RRC (HL)
-            // 2 16
-            // Z 0 0 C
-            RESET_SUBTRACT;
-            RESET_HALF_CARRY;
-            uint8_t c = p->memory[((uint16_t)p->registers.h << 8) + (uint16_t)(p->registers.l)] & 0x01; // right bit
-            p->memory[((uint16_t)p->registers.h << 8) + (uint16_t)(p->registers.l)] = (p->memory[((uint16_t)p->registers.h << 8) + (uint16_t)(p->registers.l)] >> 1) | (c << 7);
-
-            p->flagRegister.zero  = (p->memory[((uint16_t)p->registers.h << 8) + (uint16_t)(p->registers.l)] == 0);
-            p->flagRegister.carry = c;
-            debug_print("RRC (HL)\n", NULL);
-			break;
-        }
-        case 0xF: {
-            // RRC A
-            // 2 8
-            // Z 0 0 C
-            RESET_SUBTRACT;
-            RESET_HALF_CARRY;
-            uint8_t c = p->registers.a & 0x01; // right bit
-            SET_REG(&p->registers.a, (p->registers.a >> 1) | (c << 7));
-
-            p->flagRegister.zero  = (p->registers.a == 0);
-            p->flagRegister.carry = c;
-            debug_print("RRC A\n", NULL);
-			break;
-        }
-        case 0x10: {
-            // RL B
-            // 2 8
-            // Z 0 0 C
-            RESET_SUBTRACT;
-            RESET_HALF_CARRY;
-            // shift to get carry
-            uint8_t c = p->registers.b >> 7;
-            // left 1 and then move old carry bit into bit 0
-            SET_REG(&p->registers.b, (p->registers.b << 1) | p->flagRegister.carry);
-
-            p->flagRegister.zero = (p->registers.b == 0);
-            p->flagRegister.carry = c;
-            debug_print("RL B\n", NULL);
-			break;
-        }
-        case 0x11: {
-            // RL C
-            // 2 8
-            // Z 0 0 C
-            RESET_SUBTRACT;
-            RESET_HALF_CARRY;
-            // shift to get carry
-            uint8_t c = p->registers.c >> 7;
-            // left 1 and then move old carry bit into bit 0
-            SET_REG(&p->registers.c, (p->registers.c << 1) | p->flagRegister.carry);
-
-            p->flagRegister.zero = (p->registers.c == 0);
-            p->flagRegister.carry = c;
-            debug_print("RL C\n", NULL);
-			break;
-        }
-        case 0x12: {
-            // RL D
-            // 2 8
-            // Z 0 0 C
-            RESET_SUBTRACT;
-            RESET_HALF_CARRY;
-            // shift to get carry
-            uint8_t c = p->registers.d >> 7;
-            // left 1 and then move old carry bit into bit 0
-            SET_REG(&p->registers.d, (p->registers.d << 1) | p->flagRegister.carry);
-
-            p->flagRegister.zero = (p->registers.d == 0);
-            p->flagRegister.carry = c;
-            debug_print("RL D\n", NULL);
-			break;
-        }
-        case 0x13: {
-            // RL E
-            // 2 8
-            // Z 0 0 C
-            RESET_SUBTRACT;
-            RESET_HALF_CARRY;
-            // shift to get carry
-            uint8_t c = p->registers.e >> 7;
-            // left 1 and then move old carry bit into bit 0
-            SET_REG(&p->registers.e, (p->registers.e << 1) | p->flagRegister.carry);
-
-            p->flagRegister.zero = (p->registers.e == 0);
-            p->flagRegister.carry = c;
-            debug_print("RL E\n", NULL);
-			break;
-        }
-        case 0x14: {
-            // RL H
-            // 2 8
-            // Z 0 0 C
-            RESET_SUBTRACT;
-            RESET_HALF_CARRY;
-            // shift to get carry
-            uint8_t c = p->registers.h >> 7;
-            // left 1 and then move old carry bit into bit 0
-            SET_REG(&p->registers.h, (p->registers.h << 1) | p->flagRegister.carry);
-
-            p->flagRegister.zero = (p->registers.h == 0);
-            p->flagRegister.carry = c;
-            debug_print("RL H\n", NULL);
-			break;
-        }
-        case 0x15: {
-            // RL L
-            // 2 8
-            // Z 0 0 C
-            RESET_SUBTRACT;
-            RESET_HALF_CARRY;
-            // shift to get carry
-            uint8_t c = p->registers.l >> 7;
-            // left 1 and then move old carry bit into bit 0
-            SET_REG(&p->registers.l, (p->registers.l << 1) | p->flagRegister.carry);
-
-            p->flagRegister.zero = (p->registers.l == 0);
-            p->flagRegister.carry = c;
-            debug_print("RL L\n", NULL);
-			break;
-        }
-        case 0x16: {
-            // RL (HL)
-            // 2 16
-            // Z 0 0 C
-            RESET_SUBTRACT;
-            RESET_HALF_CARRY;
-            // shift to get carry
-            uint8_t c = p->memory[((uint16_t)p->registers.h << 8) + (uint16_t)(p->registers.l)] >> 7;
-            // left 1 and then move old carry bit into bit 0
-            p->memory[((uint16_t)p->registers.h << 8) + (uint16_t)(p->registers.l)] = (p->memory[((uint16_t)p->registers.h << 8) + (uint16_t)(p->registers.l)]<< 1) | p->flagRegister.carry;
-
-            p->flagRegister.zero = (p->memory[((uint16_t)p->registers.h << 8) + (uint16_t)(p->registers.l)] == 0);
-            p->flagRegister.carry = c;
-            debug_print("RL (HL)\n", NULL);
-			break;
-        }
-        case 0x17: {
-            // RL A
-            // 2 8
-            // Z 0 0 C
-            RESET_SUBTRACT;
-            RESET_HALF_CARRY;
-            // shift to get carry
-            uint8_t c = p->registers.a >> 7;
-            // left 1 and then move old carry bit into bit 0
-            SET_REG(&p->registers.a, (p->registers.a << 1) | p->flagRegister.carry);
-
-            p->flagRegister.zero = (p->registers.a == 0);
-            p->flagRegister.carry = c;
-            debug_print("RL A\n", NULL);
-			break;
-        }
-        case 0x18: {
-            // RR B
-            // 2 8
-            // Z 0 0 C
-            RESET_SUBTRACT;
-            RESET_HALF_CARRY;
-            uint8_t      c = p->registers.b & 0x01;
-            SET_REG(&p->registers.b, (p->registers.b >> 1) | (p->flagRegister.carry << 7));
-
-            p->flagRegister.zero  = (p->registers.b == 0);
-            p->flagRegister.carry = c;
-            debug_print("RR B\n", NULL);
-			break;
-        }
-        case 0x19: {
-            // RR C
-            // 2 8
-            // Z 0 0 C
-            RESET_SUBTRACT;
-            RESET_HALF_CARRY;
-            uint8_t      c = p->registers.c & 0x01;
-            SET_REG(&p->registers.c, (p->registers.c >> 1) | (p->flagRegister.carry << 7));
-
-            p->flagRegister.zero  = (p->registers.c == 0);
-            p->flagRegister.carry = c;
-            debug_print("RR C\n", NULL);
-			break;
-        }
-        case 0x1A: {
-            // RR D
-            // 2 8
-            // Z 0 0 C
-            RESET_SUBTRACT;
-            RESET_HALF_CARRY;
-            uint8_t      c = p->registers.d & 0x01;
-            SET_REG(&p->registers.d, (p->registers.d >> 1) | (p->flagRegister.carry << 7));
-
-            p->flagRegister.zero  = (p->registers.d == 0);
-            p->flagRegister.carry = c;
-            debug_print("RR D\n", NULL);
-			break;
-        }
-        case 0x1B: {
-            // RR E
-            // 2 8
-            // Z 0 0 C
-            RESET_SUBTRACT;
-            RESET_HALF_CARRY;
-            uint8_t      c = p->registers.e & 0x01;
-            SET_REG(&p->registers.e, (p->registers.e >> 1) | (p->flagRegister.carry << 7));
-
-            p->flagRegister.zero  = (p->registers.e == 0);
-            p->flagRegister.carry = c;
-            debug_print("RR E\n", NULL);
-			break;
-        }
-        case 0x1C: {
-            // RR H
-            // 2 8
-            // Z 0 0 C
-            RESET_SUBTRACT;
-            RESET_HALF_CARRY;
-            uint8_t      c = p->registers.h & 0x01;
-            SET_REG(&p->registers.h, (p->registers.h >> 1) | (p->flagRegister.carry << 7));
-
-            p->flagRegister.zero  = (p->registers.h == 0);
-            p->flagRegister.carry = c;
-            debug_print("RR H\n", NULL);
-			break;
-        }
-        case 0x1D: {
-            // RR L
-            // 2 8
-            // Z 0 0 C
-            RESET_SUBTRACT;
-            RESET_HALF_CARRY;
-            uint8_t      c = p->registers.l & 0x01;
-            SET_REG(&p->registers.l, (p->registers.l >> 1) | (p->flagRegister.carry << 7));
-
-            p->flagRegister.zero  = (p->registers.l == 0);
-            p->flagRegister.carry = c;
-            debug_print("RR L\n", NULL);
-			break;
-        }
-        case 0x1E: {
-            // RR (HL)
-            // 2 16
-            // Z 0 0 C
-            RESET_SUBTRACT;
-            RESET_HALF_CARRY;
-            uint8_t      c = p->memory[((uint16_t)p->registers.h << 8) + (uint16_t)(p->registers.l)] & 0x01;
-            p->memory[((uint16_t)p->registers.h << 8) + (uint16_t)(p->registers.l)] = (p->memory[((uint16_t)p->registers.h << 8) + (uint16_t)(p->registers.l)] >> 1) | (p->flagRegister.carry << 7);
-
-            p->flagRegister.zero  = (p->memory[((uint16_t)p->registers.h << 8) + (uint16_t)(p->registers.l)] == 0);
-            p->flagRegister.carry = c;
-            debug_print("RR (HL)\n", NULL);
-			break;
-        }
-        case 0x1F: {
-            // RR A
-            // 2 8
-            // Z 0 0 C
-            RESET_SUBTRACT;
-            RESET_HALF_CARRY;
-            uint8_t      c = p->registers.a & 0x01;
-            SET_REG(&p->registers.a, (p->registers.a >> 1) | (p->flagRegister.carry << 7));
-
-            p->flagRegister.zero  = (p->registers.a == 0);
-            p->flagRegister.carry = c;
-            debug_print("RR A\n", NULL);
-			break;
-        }
-        case 0x20:
-            // SLA B
-            // 2 8
-            // Z 0 0 C
-            RESET_SUBTRACT;
-            RESET_HALF_CARRY;
-            p->flagRegister.carry = (p->registers.b >> 7);
-            p->registers.b        = (p->registers.b << 1);
-            p->flagRegister.zero  = (p->registers.b == 0);
-            debug_print("SLA B\n", NULL);
-			break;
-        case 0x21:
-            // SLA C
-            // 2 8
-            // Z 0 0 C
-            RESET_SUBTRACT;
-            RESET_HALF_CARRY;
-            p->flagRegister.carry = (p->registers.c >> 7);
-            p->registers.c        = p->registers.c << 1;
-            p->flagRegister.zero  = (p->registers.c == 0);
-            debug_print("SLA C\n", NULL);
-			break;
-        case 0x22:
-            // SLA D
-            // 2 8
-            // Z 0 0 C
-            RESET_SUBTRACT;
-            RESET_HALF_CARRY;
-            p->flagRegister.carry = (p->registers.d >> 7);
-            p->registers.d        = p->registers.d << 1;
-            p->flagRegister.zero  = (p->registers.d == 0);
-            debug_print("SLA D\n", NULL);
-			break;
-        case 0x23:
-            // SLA E
-            // 2 8
-            // Z 0 0 C
-            RESET_SUBTRACT;
-            RESET_HALF_CARRY;
-            p->flagRegister.carry = (p->registers.e >> 7);
-            p->registers.e        = p->registers.e << 1;
-            p->flagRegister.zero  = (p->registers.e == 0);
-            debug_print("SLA E\n", NULL);
-			break;
-        case 0x24:
-            // SLA H
-            // 2 8
-            // Z 0 0 C
-            RESET_SUBTRACT;
-            RESET_HALF_CARRY;
-            p->flagRegister.carry = (p->registers.h >> 7);
-            p->registers.h        = p->registers.h << 1;
-            p->flagRegister.zero  = (p->registers.h == 0);
-            debug_print("SLA H\n", NULL);
-			break;
-        case 0x25:
-            // SLA L
-            // 2 8
-            // Z 0 0 C
-            RESET_SUBTRACT;
-            RESET_HALF_CARRY;
-            p->flagRegister.carry = (p->registers.l >> 7);
-            p->registers.l        = p->registers.l << 1;
-            p->flagRegister.zero  = (p->registers.l == 0);
-            debug_print("SLA L\n", NULL);
-			break;
-        case 0x26:
-            // SLA (HL)
-            // 2 16
-            // Z 0 0 C
-            RESET_SUBTRACT;
-            RESET_HALF_CARRY;
-            p->flagRegister.carry = (p->memory[((uint16_t)p->registers.h << 8) + (uint16_t)(p->registers.l)] >> 7);
-            p->memory[((uint16_t)p->registers.h << 8) + (uint16_t)(p->registers.l)] = p->memory[((uint16_t)p->registers.h << 8) + (uint16_t)(p->registers.l)] << 1;
-            p->flagRegister.zero  = (p->memory[((uint16_t)p->registers.h << 8) + (uint16_t)(p->registers.l)]== 0);
-            debug_print("SLA (HL)\n", NULL);
-			break;
-        case 0x27:
-            // SLA A
-            // 2 8
-            // Z 0 0 C
-            RESET_SUBTRACT;
-            RESET_HALF_CARRY;
-            p->flagRegister.carry = (p->registers.a >> 7);
-            p->registers.a        = p->registers.a << 1;
-            p->flagRegister.zero  = (p->registers.a == 0);
-            debug_print("SLA A\n", NULL);
-			break;
-        case 0x28: {
-            // SRA B
-            // 2 8
-            // Z 0 0 0
-            RESET_SUBTRACT;
-            RESET_HALF_CARRY;
-            uint8_t c   = p->registers.b & 0x01;
-            uint8_t msb = p->registers.b & 0x80; // grab 1000 0000
-            SET_REG(&p->registers.b, (p->registers.b >> 1) | msb);
-
-            p->flagRegister.zero = (p->registers.b == 0);
-            p->flagRegister.carry = c;
-            debug_print("SRA B\n", NULL);
-			break;
-        }
-        case 0x29: {
-            // SRA C
-            // 2 8
-            // Z 0 0 0
-            RESET_SUBTRACT;
-            RESET_HALF_CARRY;
-            uint8_t c   = p->registers.c & 0x01;
-            uint8_t msb = p->registers.c & 0x80; // grab 1000 0000
-            SET_REG(&p->registers.c, (p->registers.c >> 1) | msb);
-
-            p->flagRegister.zero = (p->registers.c == 0);
-            p->flagRegister.carry = c;
-            debug_print("SRA C\n", NULL);
-			break;
-        }
-        case 0x2A: {
-            // SRA D
-            // 2 8
-            // Z 0 0 0
-            RESET_SUBTRACT;
-            RESET_HALF_CARRY;
-            uint8_t c   = p->registers.d & 0x01;
-            uint8_t msb = p->registers.d & 0x80; // grab 1000 0000
-            SET_REG(&p->registers.d, (p->registers.d >> 1) | msb);
-
-            p->flagRegister.zero = (p->registers.d == 0);
-            p->flagRegister.carry = c;
-            debug_print("SRA D\n", NULL);
-			break;
-        }
-        case 0x2B: {
-            // SRA E
-            // 2 8
-            // Z 0 0 0
-            RESET_SUBTRACT;
-            RESET_HALF_CARRY;
-            uint8_t c   = p->registers.e & 0x01;
-            uint8_t msb = p->registers.e & 0x80; // grab 1000 0000
-            SET_REG(&p->registers.e, (p->registers.e >> 1) | msb);
-
-            p->flagRegister.zero = (p->registers.e == 0);
-            p->flagRegister.carry = c;
-            debug_print("SRA E\n", NULL);
-			break;
-        }
-        case 0x2C: {
-            // SRA H
-            // 2 8
-            // Z 0 0 0
-            RESET_SUBTRACT;
-            RESET_HALF_CARRY;
-            uint8_t c   = p->registers.h & 0x01;
-            uint8_t msb = p->registers.h & 0x80; // grab 1000 0000
-            SET_REG(&p->registers.h, (p->registers.h >> 1) | msb);
-
-            p->flagRegister.zero = (p->registers.h == 0);
-            p->flagRegister.carry = c;
-            debug_print("SRA H\n", NULL);
-			break;
-        }
-        case 0x2D: {
-            // SRA L
-            // 2 8
-            // Z 0 0 0
-            RESET_SUBTRACT;
-            RESET_HALF_CARRY;
-            uint8_t c   = p->registers.l & 0x01;
-            uint8_t msb = p->registers.l & 0x80; // grab 1000 0000
-            SET_REG(&p->registers.l, (p->registers.l >> 1) | msb);
-
-            p->flagRegister.zero = (p->registers.l == 0);
-            p->flagRegister.carry = c;
-            debug_print("SRA L\n", NULL);
-			break;
-        }
-        case 0x2E: {
-            // SRA (HL)
-            // 2 16
-            // Z 0 0 0
-            RESET_SUBTRACT;
-            RESET_HALF_CARRY;
-            uint16_t val = p->memory[((uint16_t)p->registers.h << 8) + (uint16_t) p->registers.l];
-            uint8_t c    = val & 0x01;
-            uint8_t msb  = val & 0x80; // grab 1000 0000
-            p->memory[((uint16_t)p->registers.h << 8) + (uint16_t) p->registers.l] = (val >> 1) | msb;
-
-            p->flagRegister.zero = (p->memory[((uint16_t)p->registers.h << 8) + (uint16_t) p->registers.l] == 0);
-            p->flagRegister.carry = c;
-            debug_print("SRA (HL)\n", NULL);
-			break;
-        }
-        case 0x2F: {
-            // SRA A
-            // 2 8
-            // Z 0 0 0
-            RESET_SUBTRACT;
-            RESET_HALF_CARRY;
-            uint8_t c   = p->registers.a & 0x01;
-            uint8_t msb = p->registers.a & 0x80; // grab 1000 0000
-            SET_REG(&p->registers.a, (p->registers.a >> 1) | msb); // idk why fam 
-
-            p->flagRegister.zero = (p->registers.a == 0);
-            p->flagRegister.carry = c;
-            debug_print("SRA A\n", NULL);
-			break;
-        }
-        case 0x30:
-            // SWAP B
-            // 2 8
-            // Z 0 0 0
-            RESET_SUBTRACT;
-            RESET_HALF_CARRY;
-            RESET_CARRY;
-            debug_print("SWAP B\n", NULL);
-			break;
-        case 0x31:
-            // SWAP C
-            // 2 8
-            // Z 0 0 0
-            RESET_SUBTRACT;
-            RESET_HALF_CARRY;
-            RESET_CARRY;
-            debug_print("SWAP C\n", NULL);
-			break;
-        case 0x32:
-            // SWAP D
-            // 2 8
-            // Z 0 0 0
-            RESET_SUBTRACT;
-            RESET_HALF_CARRY;
-            RESET_CARRY;
-            debug_print("SWAP D\n", NULL);
-			break;
-        case 0x33:
-            // SWAP E
-            // 2 8
-            // Z 0 0 0
-            RESET_SUBTRACT;
-            RESET_HALF_CARRY;
-            RESET_CARRY;
-            debug_print("SWAP E\n", NULL);
-			break;
-        case 0x34:
-            // SWAP H
-            // 2 8
-            // Z 0 0 0
-            RESET_SUBTRACT;
-            RESET_HALF_CARRY;
-            RESET_CARRY;
-            debug_print("SWAP H\n", NULL);
-			break;
-        case 0x35:
-            // SWAP L
-            // 2 8
-            // Z 0 0 0
-            RESET_SUBTRACT;
-            RESET_HALF_CARRY;
-            RESET_CARRY;
-            debug_print("SWAP L\n", NULL);
-			break;
-        case 0x36:
-            // SWAP (HL)
-            // 2 16
-            // Z 0 0 0
-            RESET_SUBTRACT;
-            RESET_HALF_CARRY;
-            RESET_CARRY;
-            debug_print("SWAP (HL)\n", NULL);
-			break;
-        case 0x37:
-            // SWAP A
-            // 2 8
-            // Z 0 0 0
-            RESET_SUBTRACT;
-            RESET_HALF_CARRY;
-            RESET_CARRY;
-            debug_print("SWAP A\n", NULL);
-			break;
-        case 0x38:
-            // SRL B
-            // 2 8
-            // Z 0 0 C
-            RESET_SUBTRACT;
-            RESET_HALF_CARRY;
-            p->flagRegister.carry = (p->registers.b & 0x01);
-            p->registers.b        = (p->registers.b >> 1) & 0x7F; // MSB -> 0
-            p->flagRegister.zero  = (p->registers.b == 0);
-            debug_print("SRL B\n", NULL);
-			break;
-        case 0x39:
-            // SRL C
-            // 2 8
-            // Z 0 0 C
-            RESET_SUBTRACT;
-            RESET_HALF_CARRY;
-            p->flagRegister.carry = (p->registers.c & 0x01);
-            p->registers.c        = (p->registers.c >> 1) & 0x7F; // MSB -> 0
-            p->flagRegister.zero  = (p->registers.c == 0);
-            debug_print("SRL C\n", NULL);
-			break;
-        case 0x3A:
-            // SRL D
-            // 2 8
-            // Z 0 0 C
-            RESET_SUBTRACT;
-            RESET_HALF_CARRY;
-            p->flagRegister.carry = (p->registers.d & 0x01);
-            p->registers.d        = (p->registers.d >> 1) & 0x7F; // MSB -> 0
-            p->flagRegister.zero  = (p->registers.d == 0);
-            debug_print("SRL D\n", NULL);
-			break;
-        case 0x3B:
-            // SRL E
-            // 2 8
-            // Z 0 0 C
-            RESET_SUBTRACT;
-            RESET_HALF_CARRY;
-            p->flagRegister.carry = (p->registers.e & 0x01);
-            p->registers.e        = (p->registers.e >> 1) & 0x7F; // MSB -> 0
-            p->flagRegister.zero  = (p->registers.e == 0);
-            debug_print("SRL E\n", NULL);
-			break;
-        case 0x3C:
-            // SRL H
-            // 2 8
-            // Z 0 0 C
-            RESET_SUBTRACT;
-            RESET_HALF_CARRY;
-            p->flagRegister.carry = (p->registers.h & 0x01);
-            p->registers.h        = (p->registers.h >> 1) & 0x7F; // MSB -> 0
-            p->flagRegister.zero  = (p->registers.h == 0);
-            debug_print("SRL H\n", NULL);
-			break;
-        case 0x3D:
-            // SRL L
-            // 2 8
-            // Z 0 0 C
-            RESET_SUBTRACT;
-            RESET_HALF_CARRY;
-            p->flagRegister.carry = (p->registers.l & 0x01);
-            p->registers.l        = (p->registers.l >> 1) & 0x7F; // MSB -> 0
-            p->flagRegister.zero  = (p->registers.l == 0);
-            debug_print("SRL L\n", NULL);
-			break;
-        case 0x3E:
-            // SRL (HL)
-            // 2 16
-            // Z 0 0 C
-            RESET_SUBTRACT;
-            RESET_HALF_CARRY;
-            p->flagRegister.carry = (p->memory[((uint16_t)p->registers.h << 8) + (uint16_t)(p->registers.l)] & 0x01);
-            p->memory[((uint16_t)p->registers.h << 8) + (uint16_t)(p->registers.l)] = (p->memory[((uint16_t)p->registers.h << 8) + (uint16_t)(p->registers.l)] >> 1) & 0x7F; // MSB -> 0
-            p->flagRegister.zero  = (p->memory[((uint16_t)p->registers.h << 8) + (uint16_t)(p->registers.l)] == 0);
-            debug_print("SRL (HL)\n", NULL);
-			break;
-        case 0x3F: {
-            // SRL A
-            // 2 8
-            // Z 0 0 C
-            RESET_SUBTRACT;
-            RESET_HALF_CARRY;
-            p->flagRegister.carry = (p->registers.a & 0x01);
-            p->registers.a        = (p->registers.a >> 1) & 0x7F; // MSB -> 0
-            p->flagRegister.zero  = (p->registers.a == 0);
-            debug_print("SRL A\n", NULL);
-			break;
-        }
-        case 0x40:
-            // BIT 0,B
-            // 2 8
-            // Z 0 1 -
-            RESET_SUBTRACT;
-            SET_HALF_CARRY;
-            debug_print("BIT 0,B\n", NULL);
-
-            if( p->registers.b == (p->registers.b & 0xFE) ){
-                SET_ZERO;
-            }
-			break;
-        case 0x41:
-            // BIT 0,C
-            // 2 8
-            // Z 0 1 -
-            RESET_SUBTRACT;
-            SET_HALF_CARRY;
-            debug_print("BIT 0,C\n", NULL);
-
-            if( p->registers.c == (p->registers.c & 0xFE) ){
-                SET_ZERO;
-            }
-			break;
-        case 0x42:
-            // BIT 0,D
-            // 2 8
-            // Z 0 1 -
-            RESET_SUBTRACT;
-            SET_HALF_CARRY;
-            debug_print("BIT 0,D\n", NULL);
-
-            if( p->registers.d == (p->registers.d & 0xFE) ){
-                SET_ZERO;
-            }
-			break;
-        case 0x43:
-            // BIT 0,E
-            // 2 8
-            // Z 0 1 -
-            RESET_SUBTRACT;
-            SET_HALF_CARRY;
-            debug_print("BIT 0,E\n", NULL);
-
-            if( p->registers.e == (p->registers.e & 0xFE) ){
-                SET_ZERO;
-            }
-			break;
-        case 0x44:
-            // BIT 0,H
-            // 2 8
-            // Z 0 1 -
-            RESET_SUBTRACT;
-            SET_HALF_CARRY;
-            debug_print("BIT 0,H\n", NULL);
-
-            if( p->registers.h == (p->registers.h & 0xFE) ){
-                SET_ZERO;
-            }
-			break;
-        case 0x45:
-            // BIT 0,L
-            // 2 8
-            // Z 0 1 -
-            RESET_SUBTRACT;
-            SET_HALF_CARRY;
-            debug_print("BIT 0,L\n", NULL);
-
-            if( p->registers.l == (p->registers.l & 0xFE) ){
-                SET_ZERO;
-            }
-			break;
-        case 0x46:
-            // BIT 0,(HL)
-            // 2 16
-            // Z 0 1 -
-            RESET_SUBTRACT;
-            SET_HALF_CARRY;
-            debug_print("BIT 0,(HL)\n", NULL);
-
-            if( p->memory[p->registers.l + (p->registers.h << 8)] == \
-                (p->memory[p->registers.l + (p->registers.h << 8)] & 0xFE) ){
-                SET_ZERO;
-            }
-			break;
-        case 0x47:
-            // BIT 0,A
-            // 2 8
-            // Z 0 1 -
-            RESET_SUBTRACT;
-            SET_HALF_CARRY;
-            debug_print("BIT 0,A\n", NULL);
-
-            if( p->registers.a == (p->registers.a & 0xFE) ){
-                SET_ZERO;
-            }
-			break;
-        case 0x48:
-            // BIT 1,B
-            // 2 8
-            // Z 0 1 -
-            RESET_SUBTRACT;
-            SET_HALF_CARRY;
-            debug_print("BIT 1,B\n", NULL);
-
-            if( p->registers.b == (p->registers.b & 0xFD) ){
-                SET_ZERO;
-            }
-			break;
-        case 0x49:
-            // BIT 1,C
-            // 2 8
-            // Z 0 1 -
-            RESET_SUBTRACT;
-            SET_HALF_CARRY;
-            debug_print("BIT 1,C\n", NULL);
-
-            if( p->registers.c == (p->registers.c & 0xFD) ){
-                SET_ZERO;
-            }
-			break;
-        case 0x4A:
-            // BIT 1,D
-            // 2 8
-            // Z 0 1 -
-            RESET_SUBTRACT;
-            SET_HALF_CARRY;
-            debug_print("BIT 1,D\n", NULL);
-
-            if( p->registers.d == (p->registers.d & 0xFD) ){
-                SET_ZERO;
-            }
-			break;
-        case 0x4B:
-            // BIT 1,E
-            // 2 8
-            // Z 0 1 -
-            RESET_SUBTRACT;
-            SET_HALF_CARRY;
-            debug_print("BIT 1,E\n", NULL);
-
-            if( p->registers.e == (p->registers.e & 0xFD) ){
-                SET_ZERO;
-            }
-			break;
-        case 0x4C:
-            // BIT 1,H
-            // 2 8
-            // Z 0 1 -
-            RESET_SUBTRACT;
-            SET_HALF_CARRY;
-            debug_print("BIT 1,H\n", NULL);
-
-            if( p->registers.h == (p->registers.h & 0xFD) ){
-                SET_ZERO;
-            }
-			break;
-        case 0x4D:
-            // BIT 1,L
-            // 2 8
-            // Z 0 1 -
-            RESET_SUBTRACT;
-            SET_HALF_CARRY;
-            debug_print("BIT 1,L\n", NULL);
-
-            if( p->registers.l == p->registers.l & 0xFD) ){
-                SET_ZERO;
-            }
-			break;
-        case 0x4E:
-            // BIT 1,(HL)
-            // 2 16
-            // Z 0 1 -
-            RESET_SUBTRACT;
-            SET_HALF_CARRY;
-            debug_print("BIT 1,(HL)\n", NULL);
-
-            if( p->memory[p->registers.l + (p->registers.h << 8)] == \
-                (p->memory[p->registers.l + (p->registers.h << 8)] & 0xFD) ){
-                SET_ZERO;
-            }
-			break;
-        case 0x4F:
-            // BIT 1,A
-            // 2 8
-            // Z 0 1 -
-            RESET_SUBTRACT;
-            SET_HALF_CARRY;
-            debug_print("BIT 1,A\n", NULL);
-
-            if( p->registers.a == (p->registers.a & 0xFD) ){
-                SET_ZERO;
-            }
-			break;
-        case 0x50:
-            // BIT 2,B
-            // 2 8
-            // Z 0 1 -
-            RESET_SUBTRACT;
-            SET_HALF_CARRY;
-            debug_print("BIT 2,B\n", NULL);
-
-            if( p->registers.b == (p->registers.b & 0xFB) ){
-                SET_ZERO;
-            }
-			break;
-        case 0x51:
-            // BIT 2,C
-            // 2 8
-            // Z 0 1 -
-            RESET_SUBTRACT;
-            SET_HALF_CARRY;
-            debug_print("BIT 2,C\n", NULL);
-
-            if( p->registers.c == (p->registers.c & 0xFB) ){
-                SET_ZERO;
-            }
-			break;
-        case 0x52:
-            // BIT 2,D
-            // 2 8
-            // Z 0 1 -
-            RESET_SUBTRACT;
-            SET_HALF_CARRY;
-            debug_print("BIT 2,D\n", NULL);
-
-            if( p->registers.d == (p->registers.d & 0xFB) ){
-                SET_ZERO;
-            }
-			break;
-        case 0x53:
-            // BIT 2,E
-            // 2 8
-            // Z 0 1 -
-            RESET_SUBTRACT;
-            SET_HALF_CARRY;
-            debug_print("BIT 2,E\n", NULL);
-
-            if( p->registers.e == (p->registers.e & 0xFB) ){
-                SET_ZERO;
-            }
-			break;
-        case 0x54:
-            // BIT 2,H
-            // 2 8
-            // Z 0 1 -
-            RESET_SUBTRACT;
-            SET_HALF_CARRY;
-            debug_print("BIT 2,H\n", NULL);
-
-            if( p->registers.h == (p->registers.h & 0xFB) ){
-                SET_ZERO;
-            }
-			break;
-        case 0x55:
-            // BIT 2,L
-            // 2 8
-            // Z 0 1 -
-            RESET_SUBTRACT;
-            SET_HALF_CARRY;
-            debug_print("BIT 2,L\n", NULL);
-
-            if( p->registers.l == (p->registers.l & 0xFB) ){
-                SET_ZERO;
-            }
-			break;
-        case 0x56:
-            // BIT 2,(HL)
-            // 2 16
-            // Z 0 1 -
-            RESET_SUBTRACT;
-            SET_HALF_CARRY;
-            debug_print("BIT 2,(HL)\n", NULL);
-
-            if( p->memory[p->registers.l + (p->registers.h << 8)] == \
-                (p->memory[p->registers.l + (p->registers.h << 8)] & 0xFB) ){
-                SET_ZERO;
-            }
-			break;
-        case 0x57:
-            // BIT 2,A
-            // 2 8
-            // Z 0 1 -
-            RESET_SUBTRACT;
-            SET_HALF_CARRY;
-            debug_print("BIT 2,A\n", NULL);
-
-            if( p->registers.a == (p->registers.a & 0xFB) ){
-                SET_ZERO;
-            }
-			break;
-        case 0x58:
-            // BIT 3,B
-            // 2 8
-            // Z 0 1 -
-            RESET_SUBTRACT;
-            SET_HALF_CARRY;
-            debug_print("BIT 3,B\n", NULL);
-
-            if( p->registers.b == (p->registers.b & 0xF7) ){
-                SET_ZERO;
-            }
-			break;
-        case 0x59:
-            // BIT 3,C
-            // 2 8
-            // Z 0 1 -
-            RESET_SUBTRACT;
-            SET_HALF_CARRY;
-            debug_print("BIT 3,C\n", NULL);
-
-            if( p->registers.c == (p->registers.c & 0xF7) ){
-                SET_ZERO;
-            }
-			break;
-        case 0x5A:
-            // BIT 3,D
-            // 2 8
-            // Z 0 1 -
-            RESET_SUBTRACT;
-            SET_HALF_CARRY;
-            debug_print("BIT 3,D\n", NULL);
-
-            if( p->registers.d == (p->registers.d & 0xF7) ){
-                SET_ZERO;
-            }
-			break;
-        case 0x5B:
-            // BIT 3,E
-            // 2 8
-            // Z 0 1 -
-            RESET_SUBTRACT;
-            SET_HALF_CARRY;
-            debug_print("BIT 3,E\n", NULL);
-
-            if( p->registers.e == (p->registers.e & 0xF7) ){
-                SET_ZERO;
-            }
-			break;
-        case 0x5C:
-            // BIT 3,H
-            // 2 8
-            // Z 0 1 -
-            RESET_SUBTRACT;
-            SET_HALF_CARRY;
-            debug_print("BIT 3,H\n", NULL);
-
-            if( p->registers.h == (p->registers.h & 0xF7) ){
-                SET_ZERO;
-            }
-			break;
-        case 0x5D:
-            // BIT 3,L
-            // 2 8
-            // Z 0 1 -
-            RESET_SUBTRACT;
-            SET_HALF_CARRY;
-            debug_print("BIT 3,L\n", NULL);
-
-            if( p->registers.l == (p->registers.l & 0xF7) ){
-                SET_ZERO;
-            }
-			break;
-        case 0x5E:
-            // BIT 3,(HL)
-            // 2 16
-            // Z 0 1 -
-            RESET_SUBTRACT;
-            SET_HALF_CARRY;
-            debug_print("BIT 3,(HL)\n", NULL);
-
-            if( p->memory[p->registers.l + (p->registers.h << 8)] == \
-                (p->memory[p->registers.l + (p->registers.h << 8)] & 0xF7) ){
-                SET_ZERO;
-            }
-			break;
-        case 0x5F:
-            // BIT 3,A
-            // 2 8
-            // Z 0 1 -
-            RESET_SUBTRACT;
-            SET_HALF_CARRY;
-            debug_print("BIT 3,A\n", NULL);
-
-            if( p->registers.a == (p->registers.a & 0xF7) ){
-                SET_ZERO;
-            }
-			break;
-        case 0x60:
-            // BIT 4,B
-            // 2 8
-            // Z 0 1 -
-            RESET_SUBTRACT;
-            SET_HALF_CARRY;
-            debug_print("BIT 4,B\n", NULL);
-
-            if( p->registers.b == (p->registers.b & 0xEF) ){
-                SET_ZERO;
-            }
-			break;
-        case 0x61:
-            // BIT 4,C
-            // 2 8
-            // Z 0 1 -
-            RESET_SUBTRACT;
-            SET_HALF_CARRY;
-            debug_print("BIT 4,C\n", NULL);
-
-            if( p->registers.c == (p->registers.c & 0xEF) ){
-                SET_ZERO;
-            }
-			break;
-        case 0x62:
-            // BIT 4,D
-            // 2 8
-            // Z 0 1 -
-            RESET_SUBTRACT;
-            SET_HALF_CARRY;
-            debug_print("BIT 4,D\n", NULL);
-
-            if( p->registers.d == (p->registers.d & 0xEF) ){
-                SET_ZERO;
-            }
-			break;
-        case 0x63:
-            // BIT 4,E
-            // 2 8
-            // Z 0 1 -
-            RESET_SUBTRACT;
-            SET_HALF_CARRY;
-            debug_print("BIT 4,E\n", NULL);
-
-            if( p->registers.e == (p->registers.e & 0xEF) ){
-                SET_ZERO;
-            }
-			break;
-        case 0x64:
-            // BIT 4,H
-            // 2 8
-            // Z 0 1 -
-            RESET_SUBTRACT;
-            SET_HALF_CARRY;
-            debug_print("BIT 4,H\n", NULL);
-
-            if( p->registers.h == (p->registers.h & 0xEF) ){
-                SET_ZERO;
-            }
-			break;
-        case 0x65:
-            // BIT 4,L
-            // 2 8
-            // Z 0 1 -
-            RESET_SUBTRACT;
-            SET_HALF_CARRY;
-            debug_print("BIT 4,L\n", NULL);
-
-            if( p->registers.l == (p->registers.l & 0xEF) ){
-                SET_ZERO;
-            }
-			break;
-        case 0x66:
-            // BIT 4,(HL)
-            // 2 16
-            // Z 0 1 -
-            RESET_SUBTRACT;
-            SET_HALF_CARRY;
-            debug_print("BIT 4,(HL)\n", NULL);
-
-            if( p->memory[p->registers.l + (p->registers.h << 8)] == \
-                (p->memory[p->registers.l + (p->registers.h << 8)] & 0xEF) ){
-                SET_ZERO;
-            }
-			break;
-        case 0x67:
-            // BIT 4,A
-            // 2 8
-            // Z 0 1 -
-            RESET_SUBTRACT;
-            SET_HALF_CARRY;
-            debug_print("BIT 4,A\n", NULL);
-
-            if( p->registers.a == (p->registers.a & 0xEF) ){
-                SET_ZERO;
-            }
-			break;
-        case 0x68:
-            // BIT 5,B
-            // 2 8
-            // Z 0 1 -
-            RESET_SUBTRACT;
-            SET_HALF_CARRY;
-            debug_print("BIT 5,B\n", NULL);
-
-            if( p->registers.b == (p->registers.b & 0xDF) ){
-                SET_ZERO;
-            }
-			break;
-        case 0x69:
-            // BIT 5,C
-            // 2 8
-            // Z 0 1 -
-            RESET_SUBTRACT;
-            SET_HALF_CARRY;
-            debug_print("BIT 5,C\n", NULL);
-
-            if( p->registers.c == (p->registers.c & 0xDF) ){
-                SET_ZERO;
-            }
-			break;
-        case 0x6A:
-            // BIT 5,D
-            // 2 8
-            // Z 0 1 -
-            RESET_SUBTRACT;
-            SET_HALF_CARRY;
-            debug_print("BIT 5,D\n", NULL);
-
-            if( p->registers.d == (p->registers.d & 0xDF) ){
-                SET_ZERO;
-            }
-			break;
-        case 0x6B:
-            // BIT 5,E
-            // 2 8
-            // Z 0 1 -
-            RESET_SUBTRACT;
-            SET_HALF_CARRY;
-            debug_print("BIT 5,E\n", NULL);
-
-            if( p->registers.e == (p->registers.e & 0xDF) ){
-                SET_ZERO;
-            }
-			break;
-        case 0x6C:
-            // BIT 5,H
-            // 2 8
-            // Z 0 1 -
-            RESET_SUBTRACT;
-            SET_HALF_CARRY;
-            debug_print("BIT 5,H\n", NULL);
-
-            if( p->registers.h == (p->registers.h & 0xDF) ){
-                SET_ZERO;
-            }
-			break;
-        case 0x6D:
-            // BIT 5,L
-            // 2 8
-            // Z 0 1 -
-            RESET_SUBTRACT;
-            SET_HALF_CARRY;
-            debug_print("BIT 5,L\n", NULL);
-
-            if( p->registers.l == (p->registers.l & 0xDF) ){
-                SET_ZERO;
-            }
-			break;
-        case 0x6E:
-            // BIT 5,(HL)
-            // 2 16
-            // Z 0 1 -
-            RESET_SUBTRACT;
-            SET_HALF_CARRY;
-            debug_print("BIT 5,(HL)\n", NULL);
-
-            if( p->memory[p->registers.l + (p->registers.h << 8)] == \
-                (p->memory[p->registers.l + (p->registers.h << 8)] & 0xDF) ){
-                SET_ZERO;
-            }
-			break;
-        case 0x6F:
-            // BIT 5,A
-            // 2 8
-            // Z 0 1 -
-            RESET_SUBTRACT;
-            SET_HALF_CARRY;
-            debug_print("BIT 5,A\n", NULL);
-
-            if( p->registers.a == (p->registers.a & 0xDF) ){
-                SET_ZERO;
-            }
-			break;
-        case 0x70:
-            // BIT 6,B
-            // 2 8
-            // Z 0 1 -
-            RESET_SUBTRACT;
-            SET_HALF_CARRY;
-            debug_print("BIT 6,B\n", NULL);
-
-            if( p->registers.b == (p->registers.b & 0xBF) ){
-                SET_ZERO;
-            }
-			break;
-        case 0x71:
-            // BIT 6,C
-            // 2 8
-            // Z 0 1 -
-            RESET_SUBTRACT;
-            SET_HALF_CARRY;
-            debug_print("BIT 6,C\n", NULL);
-
-            if( p->registers.c == (p->registers.c & 0xBF) ){
-                SET_ZERO;
-            }
-			break;
-        case 0x72:
-            // BIT 6,D
-            // 2 8
-            // Z 0 1 -
-            RESET_SUBTRACT;
-            SET_HALF_CARRY;
-            debug_print("BIT 6,D\n", NULL);
-
-            if( p->registers.d == (p->registers.d & 0xBF) ){
-                SET_ZERO;
-            }
-			break;
-        case 0x73:
-            // BIT 6,E
-            // 2 8
-            // Z 0 1 -
-            RESET_SUBTRACT;
-            SET_HALF_CARRY;
-            debug_print("BIT 6,E\n", NULL);
-
-            if( p->registers.e == (p->registers.e & 0xBF) ){
-                SET_ZERO;
-            }
-			break;
-        case 0x74:
-            // BIT 6,H
-            // 2 8
-            // Z 0 1 -
-            RESET_SUBTRACT;
-            SET_HALF_CARRY;
-            debug_print("BIT 6,H\n", NULL);
-
-            if( p->registers.h == (p->registers.h & 0xBF) ){
-                SET_ZERO;
-            }
-			break;
-        case 0x75:
-            // BIT 6,L
-            // 2 8
-            // Z 0 1 -
-            RESET_SUBTRACT;
-            SET_HALF_CARRY;
-            debug_print("BIT 6,L\n", NULL);
-
-            if( p->registers.l == (p->registers.l & 0xBF) ){
-                SET_ZERO;
-            }
-			break;
-        case 0x76:
-            // BIT 6,(HL)
-            // 2 16
-            // Z 0 1 -
-            RESET_SUBTRACT;
-            SET_HALF_CARRY;
-            debug_print("BIT 6,(HL)\n", NULL);
-
-            if( p->memory[p->registers.l + (p->registers.h << 8)] == \
-                (p->memory[p->registers.l + (p->registers.h << 8)] & 0xBF) ){
-                SET_ZERO;
-            }
-			break;
-        case 0x77:
-            // BIT 6,A
-            // 2 8
-            // Z 0 1 -
-            RESET_SUBTRACT;
-            SET_HALF_CARRY;
-            debug_print("BIT 6,A\n", NULL);
-
-            if( p->registers.a == (p->registers.a & 0xBF) ){
-                SET_ZERO;
-            }
-			break;
-        case 0x78:
-            // BIT 7,B
-            // 2 8
-            // Z 0 1 -
-            RESET_SUBTRACT;
-            SET_HALF_CARRY;
-            debug_print("BIT 7,B\n", NULL);
-
-            if( p->registers.b == (p->registers.b & 0x7F) ){
-                SET_ZERO;
-            }
-			break;
-        case 0x79:
-            // BIT 7,C
-            // 2 8
-            // Z 0 1 -
-            RESET_SUBTRACT;
-            SET_HALF_CARRY;
-            debug_print("BIT 7,C\n", NULL);
-
-            if( p->registers.c == (p->registers.c & 0x7F) ){
-                SET_ZERO;
-            }
-			break;
-        case 0x7A:
-            // BIT 7,D
-            // 2 8
-            // Z 0 1 -
-            RESET_SUBTRACT;
-            SET_HALF_CARRY;
-            debug_print("BIT 7,D\n", NULL);
-
-            if( p->registers.d == (p->registers.d & 0x7F) ){
-                SET_ZERO;
-            }
-			break;
-        case 0x7B:
-            // BIT 7,E
-            // 2 8
-            // Z 0 1 -
-            RESET_SUBTRACT;
-            SET_HALF_CARRY;
-            debug_print("BIT 7,E\n", NULL);
-
-            if( p->registers.e == (p->registers.e & 0x7F) ){
-                SET_ZERO;
-            }
-			break;
-        case 0x7C:
-            // BIT 7,H
-            // 2 8
-            // Z 0 1 -
-            RESET_SUBTRACT;
-            SET_HALF_CARRY;
-            debug_print("BIT 7,H\n", NULL);
-
-            if( p->registers.h == (p->registers.h & 0x7F) ){
-                SET_ZERO;
-            }
-			break;
-        case 0x7D:
-            // BIT 7,L
-            // 2 8
-            // Z 0 1 -
-            RESET_SUBTRACT;
-            SET_HALF_CARRY;
-            debug_print("BIT 7,L\n", NULL);
-
-            if( p->registers.l == (p->registers.l & 0x7F) ){
-                SET_ZERO;
-            }
-			break;
-        case 0x7E:
-            // BIT 7,(HL)
-            // 2 16
-            // Z 0 1 -
-            RESET_SUBTRACT;
-            SET_HALF_CARRY;
-            debug_print("BIT 7,(HL)\n", NULL);
-
-            if( p->memory[p->registers.l + (p->registers.h << 8)] == \
-                (p->memory[p->registers.l + (p->registers.h << 8)] & 0x7F) ){
-                SET_ZERO;
-            }
-			break;
-        case 0x7F:
-            // BIT 7,A
-            // 2 8
-            // Z 0 1 -
-            RESET_SUBTRACT;
-            SET_HALF_CARRY;
-            debug_print("BIT 7,A\n", NULL);
-
-            if( p->registers.a == (p->registers.a & 0x7F) ){
-                SET_ZERO;
-            }
-			break;
-        case 0x80:
-            // RES 0,B
-            // 2 8
-            // - - - -
-            debug_print("RES 0,B\n", NULL);
-
-            // AND the current value in register b with 11111110
-            // to reset the 0th bit
-            SET_REG(&p->registers.b, p->registers.b & 0xFE);
-			break;
-        case 0x81:
-            // RES 0,C
-            // 2 8
-            // - - - -
-            debug_print("RES 0,C\n", NULL);
-
-            SET_REG(&p->registers.c, p->registers.c & 0xFE);
-			break;
-        case 0x82:
-            // RES 0,D
-            // 2 8
-            // - - - -
-            debug_print("RES 0,D\n", NULL);
-
-            SET_REG(&p->registers.d, p->registers.d & 0xFE);
-			break;
-        case 0x83:
-            // RES 0,E
-            // 2 8
-            // - - - -
-            debug_print("RES 0,E\n", NULL);
-
-            SET_REG(&p->registers.e, p->registers.e & 0xFE);
-			break;
-        case 0x84:
-            // RES 0,H
-            // 2 8
-            // - - - -
-            debug_print("RES 0,H\n", NULL);
-
-            SET_REG(&p->registers.h, p->registers.h & 0xFE);
-			break;
-        case 0x85:
-            // RES 0,L
-            // 2 8
-            // - - - -
-            debug_print("RES 0,L\n", NULL);
-
-            SET_REG(&p->registers.l, p->registers.l & 0xFE);
-			break;
-        case 0x86:
-            // RES 0,(HL)
-            // 2 16
-            // - - - -
-            debug_print("RES 0,(HL)\n", NULL);
-
-            p->memory[((uint16_t)p->registers.h << 8) + (uint16_t)(p->registers.l)] = p->memory[((uint16_t)p->registers.h << 8) + (uint16_t)(p->registers.l)] & 0xFE;
-			break;
-        case 0x87:
-            // RES 0,A
-            // 2 8
-            // - - - -
-            debug_print("RES 0,A\n", NULL);
-
-            SET_REG(&p->registers.a, p->registers.a & 0xFE);
-			break;
-        case 0x88:
-            // RES 1,B
-            // 2 8
-            // - - - -
-            debug_print("RES 1,B\n", NULL);
-
-            SET_REG(&p->registers.b, p->registers.b & 0xFD);
-			break;
-        case 0x89:
-            // RES 1,C
-            // 2 8
-            // - - - -
-            debug_print("RES 1,C\n", NULL);
-
-            SET_REG(&p->registers.c, p->registers.c & 0xFD);
-			break;
-        case 0x8A:
-            // RES 1,D
-            // 2 8
-            // - - - -
-            debug_print("RES 1,D\n", NULL);
-
-            SET_REG(&p->registers.d, p->registers.d & 0xFD);
-			break;
-        case 0x8B:
-            // RES 1,E
-            // 2 8
-            // - - - -
-            debug_print("RES 1,E\n", NULL);
-
-            SET_REG(&p->registers.e, p->registers.e & 0xFD);
-			break;
-        case 0x8C:
-            // RES 1,H
-            // 2 8
-            // - - - -
-            debug_print("RES 1,H\n", NULL);
-
-            SET_REG(&p->registers.h, p->registers.h & 0xFD);
-			break;
-        case 0x8D:
-            // RES 1,L
-            // 2 8
-            // - - - -
-            debug_print("RES 1,L\n", NULL);
-
-            SET_REG(&p->registers.l, p->registers.l & 0xFD);
-			break;
-        case 0x8E:
-            // RES 1,(HL)
-            // 2 16
-            // - - - -
-            debug_print("RES 1,(HL)\n", NULL);
-
-            p->memory[((uint16_t)p->registers.h << 8) + (uint16_t)(p->registers.l)] = p->memory[((uint16_t)p->registers.h << 8) + (uint16_t)(p->registers.l)] & 0xFD;
-			break;
-        case 0x8F:
-            // RES 1,A
-            // 2 8
-            // - - - -
-            debug_print("RES 1,A\n", NULL);
-
-            SET_REG(&p->registers.a, p->registers.a & 0xFD);
-			break;
-        case 0x90:
-            // RES 2,B
-            // 2 8
-            // - - - -
-            debug_print("RES 2,B\n", NULL);
-
-            // 11111011
-            SET_REG(&p->registers.b, p->registers.b & 0xFB);
-			break;
-        case 0x91:
-            // RES 2,C
-            // 2 8
-            // - - - -
-            debug_print("RES 2,C\n", NULL);
-            SET_REG(&p->registers.c, p->registers.c & 0xFB);
-			break;
-        case 0x92:
-            // RES 2,D
-            // 2 8
-            // - - - -
-            debug_print("RES 2,D\n", NULL);
-
-            SET_REG(&p->registers.d, p->registers.d & 0xFB);
-			break;
-        case 0x93:
-            // RES 2,E
-            // 2 8
-            // - - - -
-            debug_print("RES 2,E\n", NULL);
-
-            SET_REG(&p->registers.e, p->registers.e & 0xFB);
-			break;
-        case 0x94:
-            // RES 2,H
-            // 2 8
-            // - - - -
-            debug_print("RES 2,H\n", NULL);
-
-            SET_REG(&p->registers.h, p->registers.h & 0xFB);
-			break;
-        case 0x95:
-            // RES 2,L
-            // 2 8
-            // - - - -
-            debug_print("RES 2,L\n", NULL);
-
-            SET_REG(&p->registers.l, p->registers.l & 0xFB);
-			break;
-        case 0x96:
-            // RES 2,(HL)
-            // 2 16
-            // - - - -
-            debug_print("RES 2,(HL)\n", NULL);
-
-            p->memory[((uint16_t)p->registers.h << 8) + (uint16_t)(p->registers.l)] = p->memory[((uint16_t)p->registers.h << 8) + (uint16_t)(p->registers.l)] & 0xFB;
-			break;
-        case 0x97:
-            // RES 2,A
-            // 2 8
-            // - - - -
-            debug_print("RES 2,A\n", NULL);
-
-            SET_REG(&p->registers.a, p->registers.a & 0xFB);
-			break;
-        case 0x98:
-            // RES 3,B
-            // 2 8
-            // - - - -
-            debug_print("RES 3,B\n", NULL);
-
-            // 1111 0111
-            SET_REG(&p->registers.b, p->registers.b & 0xF7);
-			break;
-        case 0x99:
-            // RES 3,C
-            // 2 8
-            // - - - -
-            debug_print("RES 3,C\n", NULL);
-
-            SET_REG(&p->registers.c, p->registers.c & 0xF7);
-			break;
-        case 0x9A:
-            // RES 3,D
-            // 2 8
-            // - - - -
-            debug_print("RES 3,D\n", NULL);
-
-            SET_REG(&p->registers.d, p->registers.d & 0xF7);
-			break;
-        case 0x9B:
-            // RES 3,E
-            // 2 8
-            // - - - -
-            debug_print("RES 3,E\n", NULL);
-
-            SET_REG(&p->registers.e, p->registers.e & 0xF7);
-			break;
-        case 0x9C:
-            // RES 3,H
-            // 2 8
-            // - - - -
-            debug_print("RES 3,H\n", NULL);
-
-            SET_REG(&p->registers.h, p->registers.h & 0xF7);
-			break;
-        case 0x9D:
-            // RES 3,L
-            // 2 8
-            // - - - -
-            debug_print("RES 3,L\n", NULL);
-
-            SET_REG(&p->registers.l, p->registers.l & 0xF7);
-			break;
-        case 0x9E:
-            // RES 3,(HL)
-            // 2 16
-            // - - - -
-            debug_print("RES 3,(HL)\n", NULL);
-
-            p->memory[((uint16_t)p->registers.h << 8) + (uint16_t)(p->registers.l)] = p->memory[((uint16_t)p->registers.h << 8) + (uint16_t)(p->registers.l)] & 0xF7;
-			break;
-        case 0x9F:
-            // RES 3,A
-            // 2 8
-            // - - - -
-            debug_print("RES 3,A\n", NULL);
-
-            SET_REG(&p->registers.a, p->registers.a & 0xF7);
-			break;
-        case 0xA0:
-            // RES 4,B
-            // 2 8
-            // - - - -
-            debug_print("RES 4,B\n", NULL);
-
-            // 1110 1111
-            SET_REG(&p->registers.b, p->registers.b & 0xEF);
-			break;
-        case 0xA1:
-            // RES 4,C
-            // 2 8
-            // - - - -
-            debug_print("RES 4,C\n", NULL);
-
-            SET_REG(&p->registers.c, p->registers.c & 0xEF);
-			break;
-        case 0xA2:
-            // RES 4,D
-            // 2 8
-            // - - - -
-            debug_print("RES 4,D\n", NULL);
-
-            SET_REG(&p->registers.d, p->registers.d & 0xEF);
-			break;
-        case 0xA3:
-            // RES 4,E
-            // 2 8
-            // - - - -
-            debug_print("RES 4,E\n", NULL);
-
-            SET_REG(&p->registers.e, p->registers.e & 0xEF);
-			break;
-        case 0xA4:
-            // RES 4,H
-            // 2 8
-            // - - - -
-            debug_print("RES 4,H\n", NULL);
-
-            SET_REG(&p->registers.h, p->registers.h & 0xEF);
-			break;
-        case 0xA5:
-            // RES 4,L
-            // 2 8
-            // - - - -
-            debug_print("RES 4,L\n", NULL);
-
-            SET_REG(&p->registers.l, p->registers.l & 0xEF);
-			break;
-        case 0xA6:
-            // RES 4,(HL)
-            // 2 16
-            // - - - -
-            debug_print("RES 4,(HL)\n", NULL);
-
-            p->memory[((uint16_t)p->registers.h << 8) + (uint16_t)(p->registers.l)] = p->memory[((uint16_t)p->registers.h << 8) + (uint16_t)(p->registers.l)] & 0xEF;
-			break;
-        case 0xA7:
-            // RES 4,A
-            // 2 8
-            // - - - -
-            debug_print("RES 4,A\n", NULL);
-
-            SET_REG(&p->registers.a, p->registers.a & 0xEF);
-			break;
-        case 0xA8:
-            // RES 5,B
-            // 2 8
-            // - - - -
-            debug_print("RES 5,B\n", NULL);
-
-            // 1101 1111
-            SET_REG(&p->registers.b, p->registers.b & 0xDF);
-			break;
-        case 0xA9:
-            // RES 5,C
-            // 2 8
-            // - - - -
-            debug_print("RES 5,C\n", NULL);
-
-            SET_REG(&p->registers.c, p->registers.c & 0xDF);
-			break;
-        case 0xAA:
-            // RES 5,D
-            // 2 8
-            // - - - -
-            debug_print("RES 5,D\n", NULL);
-
-            SET_REG(&p->registers.d, p->registers.d & 0xDF);
-			break;
-        case 0xAB:
-            // RES 5,E
-            // 2 8
-            // - - - -
-            debug_print("RES 5,E\n", NULL);
-
-            SET_REG(&p->registers.e, p->registers.e & 0xDF);
-			break;
-        case 0xAC:
-            // RES 5,H
-            // 2 8
-            // - - - -
-            debug_print("RES 5,H\n", NULL);
-
-            SET_REG(&p->registers.h, p->registers.h & 0xDF);
-			break;
-        case 0xAD:
-            // RES 5,L
-            // 2 8
-            // - - - -
-            debug_print("RES 5,L\n", NULL);
-
-            SET_REG(&p->registers.l, p->registers.l & 0xDF);
-			break;
-        case 0xAE:
-            // RES 5,(HL)
-            // 2 16
-            // - - - -
-            debug_print("RES 5,(HL)\n", NULL);
-
-            p->memory[((uint16_t)p->registers.h << 8) + (uint16_t)(p->registers.l)] = p->memory[((uint16_t)p->registers.h << 8) + (uint16_t)(p->registers.l)] & 0xDF;
-			break;
-        case 0xAF:
-            // RES 5,A
-            // 2 8
-            // - - - -
-            debug_print("RES 5,A\n", NULL);
-
-            SET_REG(&p->registers.a, p->registers.a & 0xDF);
-			break;
-        case 0xB0:
-            // RES 6,B
-            // 2 8
-            // - - - -
-            debug_print("RES 6,B\n", NULL);
-
-            // 1011 1111
-            SET_REG(&p->registers.b, p->registers.b & 0xBF);
-			break;
-        case 0xB1:
-            // RES 6,C
-            // 2 8
-            // - - - -
-            debug_print("RES 6,C\n", NULL);
-
-            SET_REG(&p->registers.c, p->registers.c & 0xBF);
-			break;
-        case 0xB2:
-            // RES 6,D
-            // 2 8
-            // - - - -
-            debug_print("RES 6,D\n", NULL);
-
-            SET_REG(&p->registers.d, p->registers.d & 0xBF);
-			break;
-        case 0xB3:
-            // RES 6,E
-            // 2 8
-            // - - - -
-            debug_print("RES 6,E\n", NULL);
-
-            SET_REG(&p->registers.e, p->registers.e & 0xBF);
-			break;
-        case 0xB4:
-            // RES 6,H
-            // 2 8
-            // - - - -
-            debug_print("RES 6,H\n", NULL);
-
-            SET_REG(&p->registers.h, p->registers.h & 0xBF);
-			break;
-        case 0xB5:
-            // RES 6,L
-            // 2 8
-            // - - - -
-            debug_print("RES 6,L\n", NULL);
-
-            SET_REG(&p->registers.l, p->registers.l & 0xBF);
-			break;
-        case 0xB6:
-            // RES 6,(HL)
-            // 2 16
-            // - - - -
-            debug_print("RES 6,(HL)\n", NULL);
-
-            p->memory[((uint16_t)p->registers.h << 8) + (uint16_t)(p->registers.l)] = p->memory[((uint16_t)p->registers.h << 8) + (uint16_t)(p->registers.l)] & 0xBF;
-			break;
-        case 0xB7:
-            // RES 6,A
-            // 2 8
-            // - - - -
-            debug_print("RES 6,A\n", NULL);
-
-            SET_REG(&p->registers.a, p->registers.a & 0xBF);
-			break;
-        case 0xB8:
-            // RES 7,B
-            // 2 8
-            // - - - -
-            debug_print("RES 7,B\n", NULL);
-
-            // 0111 1111
-            SET_REG(&p->registers.b, p->registers.b & 0x7F);
-			break;
-        case 0xB9:
-            // RES 7,C
-            // 2 8
-            // - - - -
-            debug_print("RES 7,C\n", NULL);
-
-            SET_REG(&p->registers.c, p->registers.c & 0x7F);
-			break;
-        case 0xBA:
-            // RES 7,D
-            // 2 8
-            // - - - -
-            debug_print("RES 7,D\n", NULL);
-
-            SET_REG(&p->registers.d, p->registers.d & 0x7F);
-			break;
-        case 0xBB:
-            // RES 7,E
-            // 2 8
-            // - - - -
-            debug_print("RES 7,E\n", NULL);
-
-            SET_REG(&p->registers.e, p->registers.e & 0x7F);
-			break;
-        case 0xBC:
-            // RES 7,H
-            // 2 8
-            // - - - -
-            debug_print("RES 7,H\n", NULL);
-
-            SET_REG(&p->registers.h, p->registers.h & 0x7F);
-			break;
-        case 0xBD:
-            // RES 7,L
-            // 2 8
-            // - - - -
-            debug_print("RES 7,L\n", NULL);
-
-            SET_REG(&p->registers.l, p->registers.l & 0x7F);
-			break;
-        case 0xBE:
-            // RES 7,(HL)
-            // 2 16
-            // - - - -
-            debug_print("RES 7,(HL)\n", NULL);
-
-            p->memory[((uint16_t)p->registers.h << 8) + (uint16_t)(p->registers.l)] = p->memory[((uint16_t)p->registers.h << 8) + (uint16_t)(p->registers.l)] & 0x7F;
-			break;
-        case 0xBF:
-            // RES 7,A
-            // 2 8
-            // - - - -
-            debug_print("RES 7,A\n", NULL);
-
-            SET_REG(&p->registers.a, p->registers.a & 0x7F);
-			break;
-        case 0xC0:
-            // SET 0,B
-            // 2 8
-            // - - - -
-            debug_print("SET 0,B\n", NULL);
-            // OR the current value in register b with 00000001
-            // to set the 0th bit
-            SET_REG(&p->registers.b, p->registers.b | 0x1);
-			break;
-        case 0xC1:
-            // SET 0,C
-            // 2 8
-            // - - - -
-            debug_print("SET 0,C\n", NULL);
-            // OR the current value in register b with 00000001
-            // to set the 0th bit
-            SET_REG(&p->registers.c, p->registers.c | 0x1);
-			break;
-        case 0xC2:
-            // SET 0,D
-            // 2 8
-            // - - - -
-            debug_print("SET 0,D\n", NULL);
-            // OR the current value in register b with 00000001
-            // to set the 0th bit
-            SET_REG(&p->registers.d, p->registers.d | 0x1);
-			break;
-        case 0xC3:
-            // SET 0,E
-            // 2 8
-            // - - - -
-            debug_print("SET 0,E\n", NULL);
-            // OR the current value in register b with 00000001
-            // to set the 0th bit
-            SET_REG(&p->registers.e, p->registers.e | 0x1);
-			break;
-        case 0xC4:
-            // SET 0,H
-            // 2 8
-            // - - - -
-            debug_print("SET 0,H\n", NULL);
-            // OR the current value in register b with 00000001
-            // to set the 0th bit
-            SET_REG(&p->registers.h, p->registers.h | 0x1);
-			break;
-        case 0xC5:
-            // SET 0,L
-            // 2 8
-            // - - - -
-            debug_print("SET 0,L\n", NULL);
-            // OR the current value in register b with 00000001
-            // to set the 0th bit
-            SET_REG(&p->registers.l, p->registers.l | 0x1);
-			break;
-        case 0xC6:
-            // SET 0,(HL)
-            // 2 16
-            // - - - -
-            debug_print("SET 0,(HL)\n", NULL);
-            // OR the current value in register b with 00000001
-            // to set the 0th bit
-            p->memory[((uint16_t)p->registers.h << 8) + (uint16_t)(p->registers.l)] = p->memory[((uint16_t)p->registers.h << 8) + (uint16_t)(p->registers.l)] | 0x1;
-			break;
-        case 0xC7:
-            // SET 0,A
-            // 2 8
-            // - - - -
-            debug_print("SET 0,A\n", NULL);
-            // OR the current value in register b with 00000001
-            // to set the 0th bit
-            SET_REG(&p->registers.a, p->registers.a | 0x1);
-			break;
-        case 0xC8:
-            // SET 1,B
-            // 2 8
-            // - - - -
-            debug_print("SET 1,B\n", NULL);
-            SET_REG(&p->registers.b, p->registers.b | 0x2);
-			break;
-        case 0xC9:
-            // SET 1,C
-            // 2 8
-            // - - - -
-            debug_print("SET 1,C\n", NULL);
-            SET_REG(&p->registers.c, p->registers.c | 0x2);
-			break;
-        case 0xCA:
-            // SET 1,D
-            // 2 8
-            // - - - -
-            debug_print("SET 1,D\n", NULL);
-            SET_REG(&p->registers.d, p->registers.d | 0x2);
-			break;
-        case 0xCB:
-            // SET 1,E
-            // 2 8
-            // - - - -
-            debug_print("SET 1,E\n", NULL);
-            SET_REG(&p->registers.e, p->registers.e | 0x2);
-			break;
-        case 0xCC:
-            // SET 1,H
-            // 2 8
-            // - - - -
-            debug_print("SET 1,H\n", NULL);
-            SET_REG(&p->registers.h, p->registers.h | 0x2);
-			break;
-        case 0xCD:
-            // SET 1,L
-            // 2 8
-            // - - - -
-            debug_print("SET 1,L\n", NULL);
-            SET_REG(&p->registers.l, p->registers.l | 0x2);
-			break;
-        case 0xCE:
-            // SET 1,(HL)
-            // 2 16
-            // - - - -
-            debug_print("SET 1,(HL)\n", NULL);
-            p->memory[((uint16_t)p->registers.h << 8) + (uint16_t)(p->registers.l)] = p->memory[((uint16_t)p->registers.h << 8) + (uint16_t)(p->registers.l)] | 0x2;
-			break;
-        case 0xCF:
-            // SET 1,A
-            // 2 8
-            // - - - -
-            debug_print("SET 1,A\n", NULL);
-            SET_REG(&p->registers.a, p->registers.a | 0x2);
-			break;
-        case 0xD0:
-            // SET 2,B
-            // 2 8
-            // - - - -
-            debug_print("SET 2,B\n", NULL);
-            SET_REG(&p->registers.b, p->registers.b | 0x4);
-			break;
-        case 0xD1:
-            // SET 2,C
-            // 2 8
-            // - - - -
-            debug_print("SET 2,C\n", NULL);
-            SET_REG(&p->registers.c, p->registers.c | 0x4);
-			break;
-        case 0xD2:
-            // SET 2,D
-            // 2 8
-            // - - - -
-            debug_print("SET 2,D\n", NULL);
-            SET_REG(&p->registers.d, p->registers.d | 0x4);
-			break;
-        case 0xD3:
-            // SET 2,E
-            // 2 8
-            // - - - -
-            debug_print("SET 2,E\n", NULL);
-            SET_REG(&p->registers.e, p->registers.e | 0x4);
-			break;
-        case 0xD4:
-            // SET 2,H
-            // 2 8
-            // - - - -
-            debug_print("SET 2,H\n", NULL);
-            SET_REG(&p->registers.h, p->registers.h | 0x4);
-			break;
-        case 0xD5:
-            // SET 2,L
-            // 2 8
-            // - - - -
-            debug_print("SET 2,L\n", NULL);
-            SET_REG(&p->registers.l, p->registers.l | 0x4);
-			break;
-        case 0xD6:
-            // SET 2,(HL)
-            // 2 16
-            // - - - -
-            debug_print("SET 2,(HL)\n", NULL);
-            p->memory[((uint16_t)p->registers.h << 8) + (uint16_t)(p->registers.l)] = p->memory[((uint16_t)p->registers.h << 8) + (uint16_t)(p->registers.l)] | 0x4;
-			break;
-        case 0xD7:
-            // SET 2,A
-            // 2 8
-            // - - - -
-            debug_print("SET 2,A\n", NULL);
-            SET_REG(&p->registers.a, p->registers.a | 0x4);
-			break;
-        case 0xD8:
-            // SET 3,B
-            // 2 8
-            // - - - -
-            debug_print("SET 3,B\n", NULL);
-            SET_REG(&p->registers.b, p->registers.b | 0x8);
-			break;
-        case 0xD9:
-            // SET 3,C
-            // 2 8
-            // - - - -
-            debug_print("SET 3,C\n", NULL);
-            SET_REG(&p->registers.c, p->registers.c | 0x8);
-			break;
-        case 0xDA:
-            // SET 3,D
-            // 2 8
-            // - - - -
-            debug_print("SET 3,D\n", NULL);
-            SET_REG(&p->registers.d, p->registers.d | 0x8);
-			break;
-        case 0xDB:
-            // SET 3,E
-            // 2 8
-            // - - - -
-            debug_print("SET 3,E\n", NULL);
-            SET_REG(&p->registers.e, p->registers.e | 0x8);
-			break;
-        case 0xDC:
-            // SET 3,H
-            // 2 8
-            // - - - -
-            debug_print("SET 3,H\n", NULL);
-            SET_REG(&p->registers.h, p->registers.h | 0x8);
-			break;
-        case 0xDD:
-            // SET 3,L
-            // 2 8
-            // - - - -
-            debug_print("SET 3,L\n", NULL);
-            SET_REG(&p->registers.l, p->registers.l | 0x8);
-			break;
-        case 0xDE:
-            // SET 3,(HL)
-            // 2 16
-            // - - - -
-            debug_print("SET 3,(HL)\n", NULL);
-            p->memory[((uint16_t)p->registers.h << 8) + (uint16_t)(p->registers.l)] = p->memory[((uint16_t)p->registers.h << 8) + (uint16_t)(p->registers.l)] | 0x8;
-			break;
-        case 0xDF:
-            // SET 3,A
-            // 2 8
-            // - - - -
-            debug_print("SET 3,A\n", NULL);
-            SET_REG(&p->registers.a, p->registers.a | 0x8);
-			break;
-        case 0xE0:
-            // SET 4,B
-            // 2 8
-            // - - - -
-            debug_print("SET 4,B\n", NULL);
-            SET_REG(&p->registers.b, p->registers.b | 0x10);
-			break;
-        case 0xE1:
-            // SET 4,C
-            // 2 8
-            // - - - -
-            debug_print("SET 4,C\n", NULL);
-            SET_REG(&p->registers.c, p->registers.c | 0x10);
-			break;
-        case 0xE2:
-            // SET 4,D
-            // 2 8
-            // - - - -
-            debug_print("SET 4,D\n", NULL);
-            SET_REG(&p->registers.d, p->registers.d | 0x10);
-			break;
-        case 0xE3:
-            // SET 4,E
-            // 2 8
-            // - - - -
-            debug_print("SET 4,E\n", NULL);
-            SET_REG(&p->registers.e, p->registers.e | 0x10);
-			break;
-        case 0xE4:
-            // SET 4,H
-            // 2 8
-            // - - - -
-            debug_print("SET 4,H\n", NULL);
-            SET_REG(&p->registers.h, p->registers.h | 0x10);
-			break;
-        case 0xE5:
-            // SET 4,L
-            // 2 8
-            // - - - -
-            debug_print("SET 4,L\n", NULL);
-            SET_REG(&p->registers.l, p->registers.l | 0x10);
-			break;
-        case 0xE6:
-            // SET 4,(HL)
-            // 2 16
-            // - - - -
-            debug_print("SET 4,(HL)\n", NULL);
-            p->memory[((uint16_t)p->registers.h << 8) + (uint16_t)(p->registers.l)] = p->memory[((uint16_t)p->registers.h << 8) + (uint16_t)(p->registers.l)] | 0x10;
-			break;
-        case 0xE7:
-            // SET 4,A
-            // 2 8
-            // - - - -
-            debug_print("SET 4,A\n", NULL);
-            SET_REG(&p->registers.a, p->registers.a | 0x10);
-			break;
-        case 0xE8:
-            // SET 5,B
-            // 2 8
-            // - - - -
-            debug_print("SET 5,B\n", NULL);
-            SET_REG(&p->registers.b, p->registers.b | 0x20);
-			break;
-        case 0xE9:
-            // SET 5,C
-            // 2 8
-            // - - - -
-            debug_print("SET 5,C\n", NULL);
-            SET_REG(&p->registers.c, p->registers.c | 0x20);
-			break;
-        case 0xEA:
-            // SET 5,D
-            // 2 8
-            // - - - -
-            debug_print("SET 5,D\n", NULL);
-            SET_REG(&p->registers.d, p->registers.d | 0x20);
-			break;
-        case 0xEB:
-            // SET 5,E
-            // 2 8
-            // - - - -
-            debug_print("SET 5,E\n", NULL);
-            SET_REG(&p->registers.e, p->registers.e | 0x20);
-			break;
-        case 0xEC:
-            // SET 5,H
-            // 2 8
-            // - - - -
-            debug_print("SET 5,H\n", NULL);
-            SET_REG(&p->registers.h, p->registers.h | 0x20);
-			break;
-        case 0xED:
-            // SET 5,L
-            // 2 8
-            // - - - -
-            debug_print("SET 5,L\n", NULL);
-            SET_REG(&p->registers.l, p->registers.l | 0x20);
-			break;
-        case 0xEE:
-            // SET 5,(HL)
-            // 2 16
-            // - - - -
-            debug_print("SET 5,(HL)\n", NULL);
-            p->memory[((uint16_t)p->registers.h << 8) + (uint16_t)(p->registers.l)] = p->memory[((uint16_t)p->registers.h << 8) + (uint16_t)(p->registers.l)] | 0x20;
-			break;
-        case 0xEF:
-            // SET 5,A
-            // 2 8
-            // - - - -
-            debug_print("SET 5,A\n", NULL);
-            SET_REG(&p->registers.a, p->registers.a | 0x20);
-			break;
-        case 0xF0:
-            // SET 6,B
-            // 2 8
-            // - - - -
-            debug_print("SET 6,B\n", NULL);
-            SET_REG(&p->registers.b, p->registers.b | 0x40);
-			break;
-        case 0xF1:
-            // SET 6,C
-            // 2 8
-            // - - - -
-            debug_print("SET 6,C\n", NULL);
-            SET_REG(&p->registers.c, p->registers.c | 0x40);
-			break;
-        case 0xF2:
-            // SET 6,D
-            // 2 8
-            // - - - -
-            debug_print("SET 6,D\n", NULL);
-            SET_REG(&p->registers.d, p->registers.d | 0x40);
-			break;
-        case 0xF3:
-            // SET 6,E
-            // 2 8
-            // - - - -
-            debug_print("SET 6,E\n", NULL);
-            SET_REG(&p->registers.e, p->registers.e | 0x40);
-			break;
-        case 0xF4:
-            // SET 6,H
-            // 2 8
-            // - - - -
-            debug_print("SET 6,H\n", NULL);
-            SET_REG(&p->registers.h, p->registers.h | 0x40);
-			break;
-        case 0xF5:
-            // SET 6,L
-            // 2 8
-            // - - - -
-            debug_print("SET 6,L\n", NULL);
-            SET_REG(&p->registers.l, p->registers.l | 0x40);
-			break;
-        case 0xF6:
-            // SET 6,(HL)
-            // 2 16
-            // - - - -
-            debug_print("SET 6,(HL)\n", NULL);
-            p->memory[((uint16_t)p->registers.h << 8) + (uint16_t)(p->registers.l)] = p->memory[((uint16_t)p->registers.h << 8) + (uint16_t)(p->registers.l)] | 0x40;
-			break;
-        case 0xF7:
-            // SET 6,A
-            // 2 8
-            // - - - -
-            debug_print("SET 6,A\n", NULL);
-            SET_REG(&p->registers.a, p->registers.a | 0x40);
-			break;
-        case 0xF8:
-            // SET 7,B
-            // 2 8
-            // - - - -
-            debug_print("SET 7,B\n", NULL);
-            SET_REG(&p->registers.b, p->registers.b | 0x80);
-			break;
-        case 0xF9:
-            // SET 7,C
-            // 2 8
-            // - - - -
-            debug_print("SET 7,C\n", NULL);
-            SET_REG(&p->registers.c, p->registers.c | 0x80);
-			break;
-        case 0xFA:
-            // SET 7,D
-            // 2 8
-            // - - - -
-            debug_print("SET 7,D\n", NULL);
-            SET_REG(&p->registers.d, p->registers.d | 0x80);
-			break;
-        case 0xFB:
-            // SET 7,E
-            // 2 8
-            // - - - -
-            debug_print("SET 7,E\n", NULL);
-            SET_REG(&p->registers.e, p->registers.e | 0x80);
-			break;
-        case 0xFC:
-            // SET 7,H
-            // 2 8
-            // - - - -
-            debug_print("SET 7,H\n", NULL);
-            SET_REG(&p->registers.h, p->registers.h | 0x80);
-			break;
-        case 0xFD:
-            // SET 7,L
-            // 2 8
-            // - - - -
-            debug_print("SET 7,L\n", NULL);
-            SET_REG(&p->registers.l, p->registers.l | 0x80);
-			break;
-        case 0xFE:
-            // SET 7,(HL)
-            // 2 16
-            // - - - -
-            debug_print("SET 7,(HL)\n", NULL);
-            p->memory[((uint16_t)p->registers.h << 8) + (uint16_t)(p->registers.l)] = p->memory[((uint16_t)p->registers.h << 8) + (uint16_t)(p->registers.l)] | 0x80;
-			break;
-        case 0xFF:
-            // SET 7,A
-            // 2 8
-            // - - - -
-            debug_print("SET 7,A\n", NULL);
-            SET_REG(&p->registers.a, p->registers.a | 0x80);
-			break;
+void proc_enable_block_cache(Proc* p, int enabled) {
+    /* the cache can be switched on and off at any time, turning it off throws away all the blocks */
+    if (!p) return;
+
+    if (!enabled) {
+        // the jit only runs blocks from the cache
+        proc_enable_jit(p, 0);
     }
 
+    if (enabled && !p->block_cache) {
+        p->block_cache = block_cache_create();
+    } else if (!enabled && p->block_cache) {
+        block_cache_delete(p->block_cache);
+        p->block_cache = NULL;
+    }
 }
 
-void proc_dec_hl(Proc* p) {
-    if (p->registers.l == 0) {
-        p->registers.h--;
-        p->registers.l--; // should overflow
-    } else {
-        p->registers.l--;
+int proc_enable_jit(Proc* p, int enabled) {
+    /* can also be switched at any time, turns on the block cache as well since that's where
+     * the blocks come from. Returns 0 if there's no jit on this host
+     */
+    if (!p) return 0;
+
+    if (enabled && !p->jit) {
+        proc_enable_block_cache(p, 1);
+        p->jit = jit_create();
+    } else if (!enabled && p->jit) {
+        // the blocks point into the jit's code
+        block_cache_flush(p->block_cache);
+        jit_delete(p->jit);
+        p->jit = NULL;
     }
+
+    return p->jit != NULL;
+}
+
+void proc_dec_hl(Proc* p) {
+    p->registers.hl--;
 }
 
 void proc_inc_hl(Proc* p) {
-    if (p->registers.l == 0xFF) {
-        p->registers.h++;
-        p->registers.l++;
-    } else {
-        p->registers.l++;
-    }
+    p->registers.hl++;
 }
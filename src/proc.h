@@ -5,52 +5,154 @@
 #include <stdlib.h>
 
 #include "helpers.h"
+#include "block.h"
+#include "jit.h"
+#include "scheduler.h"
+#include "io.h"
+#include "frames.h"
+#include "apu.h"
 
 #define MEM_SIZE (1 << 16)
-#define NUM_TILES 256
+// the memory bus is a table of 4 KiB pages (memory.h)
+#define PAGE_SHIFT CODE_PAGE_SHIFT
+#define PAGE_SIZE (1 << PAGE_SHIFT)
+#define NUM_PAGES (MEM_SIZE >> PAGE_SHIFT)
+// 0x8000 -> 0x97FF, 16 bytes each
+#define NUM_TILES 384
 #define TILE_HEIGHT 8
 #define TILE_WIDTH 8
 
-// excluding the flags register
+// clock speed of the cpu in cycles per second (4.194304 MHz)
+#define CLOCK_SPEED 4194304
+// 154 scanlines of 456 cycles each
+#define CYCLES_PER_FRAME 70224
+
+// the cpu state is kept to the start of one cache line
+#define CACHE_LINE 64
+
+/*
+ * The pairs are unions so BC/DE/HL/AF can be used as a 16 bit value without putting it back
+ * together from two bytes, which byte comes first depends on the host.
+ */
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+#define REGISTER_PAIR(upper, lower) union { struct { uint8_t upper; uint8_t lower; }; uint16_t upper##lower; }
+#else
+#define REGISTER_PAIR(upper, lower) union { struct { uint8_t lower; uint8_t upper; }; uint16_t upper##lower; }
+#endif
+
+// f holds the flags in the usual Z N H C 0 0 0 0 layout, except what LazyFlags still owes it
 typedef struct {
-    uint8_t a;
-    uint8_t b;
-    uint8_t c;
-    uint8_t d;
-    uint8_t e;
-    uint8_t f;
-    uint8_t h;
-    uint8_t l;
+    REGISTER_PAIR(a, f);
+    REGISTER_PAIR(b, c);
+    REGISTER_PAIR(d, e);
+    REGISTER_PAIR(h, l);
 } Registers;
 
-enum FlagState {
-    SET   = 1,
-    CLEAR = 0
+// the op behind LazyFlags, LAZY_NONE when f is up to date
+enum LazyOp {
+    LAZY_NONE = 0,
+    LAZY_ADD,
+    LAZY_SUB,
+    LAZY_INC,
+    LAZY_DEC
 };
 
 typedef struct {
-    int zero;
-    int subtract;
-    int half_carry;
-    int carry;
-} FlagRegister;
+    // the last ADD/ADC/SUB/SBC/CP/INC/DEC, the flags are worked out from it when something reads them
+    uint8_t op;
+    uint8_t a;
+    uint8_t b;
+    uint8_t carry;
+    // 9 bits for add and sub, bit 8 is the carry
+    uint16_t result;
+} LazyFlags;
+
+struct Cart;
 
 typedef struct {
-    uint8_t memory[MEM_SIZE];
+    // times HALT or STOP was run and the cycles skipped while waiting
+    uint64_t halts;
+    uint64_t halted_cycles;
+
+    // busy-wait loops found, times one was skipped and the cycles skipped over
+    uint64_t idle_loops;
+    uint64_t idle_skips;
+    uint64_t idle_cycles;
+
+    // frames started (vblanks), ones the ppu skipped drawing and tiles decoded from vram over them
+    uint64_t frames;
+    uint64_t frames_skipped;
+    uint64_t tiles_decoded;
+} ProcStats;
 
+typedef struct Proc {
+    /* everything the interpreter touches on every instruction is first, the struct is
+     * allocated cache line aligned so it all shares one line
+     */
     Registers registers;
-    FlagRegister flagRegister;
-    
     uint16_t pc;
     uint16_t sp;
+    LazyFlags lazy;
 
+    // total clock cycles run since power on
+    uint64_t cycles;
+    // proc_run_block stops here, the next event or sooner if something needs handling
+    uint64_t deadline;
+
+    // interrupt master enable, EI sets it one instruction late
+    uint8_t ime;
+    uint8_t ei_pending;
+    // HALT waits for an interrupt, STOP for a button, either way the cycles are skipped over
+    uint8_t halted;
+    uint8_t stopped;
+    // fast forward through busy-wait loops (idle.h), on by default
+    uint8_t skip_idle_loops;
+
+    // pre-decoded blocks used by proc_run_cycles, NULL when turned off
+    BlockCache * block_cache;
+    // compiles hot blocks from the cache, NULL when turned off or not available
+    Jit * jit;
+
+    // every read and write goes through these, NULL pages take the slow path (memory.h)
+    uint8_t * read_page[NUM_PAGES];
+    uint8_t * write_page[NUM_PAGES];
+
+    // rom banks the cart has switched in at 0x0000 and 0x4000
+    uint16_t rom_map_bank[2];
+    struct Cart * cart;
+
+    Scheduler scheduler;
+    IoState io;
+    Apu apu;
+
+    ProcStats stats;
+
+    uint8_t memory[MEM_SIZE] __attribute__((aligned(CACHE_LINE)));
+
+    // [tile][y][x], decoded from vram by tiles_update, tile_dirty has a bit for each tile written since (tile.h)
     uint8_t tileset [NUM_TILES][TILE_HEIGHT][TILE_WIDTH];
-} Proc;
+    uint64_t tile_dirty[NUM_TILES / 64];
+
+    // shades drawn by the ppu a line at a time into framebuffer, which is the back buffer of
+    // frames. It's handed over to the presenter at vblank (ppu.h, frames.h)
+    TripleBuffer frames;
+    uint8_t (*framebuffer)[SCREEN_WIDTH];
+    FrameSkip frame_skip;
+    // line of the window drawn next
+    uint8_t window_line;
+    // BGP, OBP0 and OBP1 as the shade for each colour, updated when they're written (ppu.h)
+    uint8_t palettes[3][4];
+} __attribute__((aligned(CACHE_LINE))) Proc;
 
 Proc*          proc_create();
 void           proc_delete(Proc* p);
-void           proc_read_word(Proc* p);
-void           proc_handle_cb_prefix(Proc *p);
+int            proc_read_word(Proc* p);
+uint64_t       proc_run_cycles(Proc* p, uint64_t cycles);
+int            proc_run_block(Proc* p);
+void           proc_enable_block_cache(Proc* p, int enabled);
+int            proc_enable_jit(Proc* p, int enabled);
+uint8_t        proc_get_f(Proc* p);
+void           proc_set_f(Proc* p, uint8_t f);
 void           proc_initialize_memory(Proc* p);
 
 void           proc_dec_hl(Proc* p);
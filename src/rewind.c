@@ -0,0 +1,254 @@
+// rewind.c
+#include <stdlib.h>
+#include <string.h>
+
+#include "rewind.h"
+#include "state.h"
+#include "timing.h"
+
+static void xor_states(uint8_t * out, const uint8_t * a, const uint8_t * b, size_t size) {
+    /* a word at a time, memcpy so the buffers don't have to be aligned */
+    size_t i = 0;
+    for (; i + 8 <= size; i += 8) {
+        uint64_t x, y;
+        memcpy(&x, a + i, 8);
+        memcpy(&y, b + i, 8);
+        x ^= y;
+        memcpy(out + i, &x, 8);
+    }
+    for (; i < size; i++) {
+        out[i] = a[i] ^ b[i];
+    }
+}
+
+/* ---------------------------------------------------------------------------------------
+ * the packed snapshots, oldest to newest round data
+ * --------------------------------------------------------------------------------------- */
+
+static void drop_oldest(Rewind * r) {
+    r->used -= r->entries[r->first].size;
+    r->first = (r->first + 1) % r->depth;
+    r->count--;
+}
+
+static void drop_newest(Rewind * r) {
+    RewindEntry * e = &r->entries[(r->first + r->count - 1) % r->depth];
+    r->used -= e->size;
+    r->head = e->offset;
+    r->count--;
+}
+
+static size_t reserve(Rewind * r, size_t size) {
+    /* where size bytes can go, dropping the oldest until there's room. SIZE_MAX if it never fits */
+    if (size > r->budget || r->depth < 2) return SIZE_MAX;
+
+    for (;;) {
+        // the newest whole snapshot counts towards the depth
+        if (r->count + 1 >= r->depth) {
+            drop_oldest(r);
+            continue;
+        }
+        if (!r->count) return 0;
+
+        // free space is after the newest and before the oldest, wrapping round at the end
+        size_t tail = r->entries[r->first].offset;
+        if (r->head > tail) {
+            if (r->head + size <= r->budget) return r->head;
+            if (size <= tail) return 0;
+        } else if (r->head < tail) {
+            if (r->head + size <= tail) return r->head;
+        }
+        drop_oldest(r);
+    }
+}
+
+static void commit(Rewind * r) {
+    /* the snapshot before pending is stored as the two xored, then pending is the newest */
+    uint64_t start = timing_thread_cpu_ns();
+
+    if (r->has_latest) {
+        xor_states(r->delta, r->latest, r->pending, r->state_size);
+        size_t packed = state_pack(r->delta, r->state_size, r->packed, r->state_size - 1);
+
+        RewindEntry entry = { 0, packed ? packed : r->state_size, packed != 0 };
+        entry.offset = reserve(r, entry.size);
+        if (entry.offset != SIZE_MAX) {
+            memcpy(r->data + entry.offset, packed ? r->packed : r->delta, entry.size);
+            r->entries[(r->first + r->count) % r->depth] = entry;
+            r->count++;
+            r->used += entry.size;
+            r->head = entry.offset + entry.size;
+            r->stored += entry.size;
+        } else {
+            // the older ones can't be got back to without this one
+            while (r->count) drop_oldest(r);
+        }
+    }
+
+    uint8_t * newest = r->pending;
+    r->pending = r->latest;
+    r->latest = newest;
+    r->has_latest = 1;
+
+    r->delta_ns += timing_thread_cpu_ns() - start;
+}
+
+/* ---------------------------------------------------------------------------------------
+ * worker
+ * --------------------------------------------------------------------------------------- */
+
+static void * rewind_worker(void * arg) {
+    Rewind * r = (Rewind *) arg;
+
+    pthread_mutex_lock(&r->lock);
+    for (;;) {
+        while (!r->busy && !r->quit) pthread_cond_wait(&r->wake, &r->lock);
+        if (r->quit) break;
+
+        pthread_mutex_unlock(&r->lock);
+        commit(r);
+        pthread_mutex_lock(&r->lock);
+
+        r->busy = 0;
+        pthread_cond_broadcast(&r->done);
+    }
+    pthread_mutex_unlock(&r->lock);
+    return NULL;
+}
+
+static void rewind_wait(Rewind * r) {
+    /* until the worker is done with the last capture, nothing can start it again but this thread */
+    if (!r->threaded) return;
+
+    pthread_mutex_lock(&r->lock);
+    while (r->busy) pthread_cond_wait(&r->done, &r->lock);
+    pthread_mutex_unlock(&r->lock);
+}
+
+/* ---------------------------------------------------------------------------------------
+ * capturing and stepping back
+ * --------------------------------------------------------------------------------------- */
+
+int rewind_init(Rewind * r, const Proc * p, size_t budget, uint32_t depth, uint32_t interval, int threaded) {
+    memset(r, 0, sizeof(Rewind));
+    r->budget = budget;
+    r->depth = depth;
+    r->interval = interval ? interval : 1;
+
+    r->state_size = state_bound(p);
+    r->latest = malloc(r->state_size);
+    r->pending = malloc(r->state_size);
+    r->delta = malloc(r->state_size);
+    r->packed = malloc(r->state_size);
+    r->data = malloc(budget);
+    r->entries = calloc(depth, sizeof(RewindEntry));
+    if (!r->latest || !r->pending || !r->delta || !r->packed || !r->data || !r->entries) {
+        rewind_free(r);
+        return 0;
+    }
+
+    if (threaded) {
+        pthread_mutex_init(&r->lock, NULL);
+        pthread_cond_init(&r->wake, NULL);
+        pthread_cond_init(&r->done, NULL);
+        // without the thread it all happens on capture instead
+        r->threaded = pthread_create(&r->thread, NULL, rewind_worker, r) == 0;
+        if (!r->threaded) {
+            pthread_mutex_destroy(&r->lock);
+            pthread_cond_destroy(&r->wake);
+            pthread_cond_destroy(&r->done);
+        }
+    }
+    return 1;
+}
+
+void rewind_free(Rewind * r) {
+    if (r->threaded) {
+        pthread_mutex_lock(&r->lock);
+        r->quit = 1;
+        pthread_cond_signal(&r->wake);
+        pthread_mutex_unlock(&r->lock);
+        pthread_join(r->thread, NULL);
+
+        pthread_mutex_destroy(&r->lock);
+        pthread_cond_destroy(&r->wake);
+        pthread_cond_destroy(&r->done);
+        r->threaded = 0;
+    }
+
+    free(r->latest);
+    free(r->pending);
+    free(r->delta);
+    free(r->packed);
+    free(r->data);
+    free(r->entries);
+    r->latest = r->pending = r->delta = r->packed = r->data = NULL;
+    r->entries = NULL;
+}
+
+int rewind_capture(Rewind * r, const Proc * p) {
+    uint64_t start = timing_thread_cpu_ns();
+
+    if (r->threaded) {
+        pthread_mutex_lock(&r->lock);
+        int busy = r->busy;
+        pthread_mutex_unlock(&r->lock);
+        if (busy) {
+            r->skipped++;
+            return 0;
+        }
+    }
+
+    // the worker isn't looking at pending until it's told to
+    if (!state_save(p, r->pending, r->state_size, 0)) return 0;
+    r->captures++;
+
+    if (r->threaded) {
+        pthread_mutex_lock(&r->lock);
+        r->busy = 1;
+        pthread_cond_signal(&r->wake);
+        pthread_mutex_unlock(&r->lock);
+        r->capture_ns += timing_thread_cpu_ns() - start;
+    } else {
+        r->capture_ns += timing_thread_cpu_ns() - start;
+        commit(r);
+    }
+    return 1;
+}
+
+void rewind_frame(Rewind * r, const Proc * p) {
+    if (++r->frames < r->interval) return;
+
+    r->frames = 0;
+    rewind_capture(r, p);
+}
+
+int rewind_step_back(Rewind * r, Proc * p) {
+    rewind_wait(r);
+    if (!r->has_latest || !state_load(p, r->latest, r->state_size)) return 0;
+
+    // the one before it, the oldest stays once there's nothing older
+    if (r->count) {
+        const RewindEntry * e = &r->entries[(r->first + r->count - 1) % r->depth];
+        const uint8_t * delta = r->data + e->offset;
+        if (e->packed) {
+            state_unpack(delta, e->size, r->delta, r->state_size);
+            delta = r->delta;
+        }
+        xor_states(r->latest, r->latest, delta, r->state_size);
+        drop_newest(r);
+    }
+
+    r->frames = 0;
+    return 1;
+}
+
+uint32_t rewind_snapshots(Rewind * r) {
+    rewind_wait(r);
+    return r->count + r->has_latest;
+}
+
+size_t rewind_used(Rewind * r) {
+    rewind_wait(r);
+    return r->used;
+}
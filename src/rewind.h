@@ -0,0 +1,86 @@
+#ifndef REWIND_H
+#define REWIND_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <pthread.h>
+
+#include "proc.h"
+
+/*
+ * Rewind, a state (state.h) is captured every interval frames and kept in memory. Only the
+ * newest is kept whole, each one before it is stored as the xor against the one after packed
+ * with state_pack. Most of memory and the tiles don't change from one frame to the next so the
+ * xor is mostly runs of 0 and packs down to almost nothing.
+ *
+ * The packed snapshots go round in data, the oldest are dropped when it's full or when there
+ * are depth of them. With a worker thread the cpu thread only copies the state out and the
+ * worker does the rest, a capture that comes while it's still busy with the last one is
+ * skipped rather than waited for.
+ */
+
+typedef struct {
+    size_t offset;
+    uint32_t size;
+    // the xor didn't pack any smaller so it's stored as it is
+    uint8_t packed;
+} RewindEntry;
+
+typedef struct {
+    uint32_t interval;
+    uint32_t depth;
+    size_t budget;
+
+    // one state_save, the newest snapshot whole and the one captured waiting for the worker
+    size_t state_size;
+    uint8_t * latest;
+    uint8_t * pending;
+    int has_latest;
+    // room for the xor and it packed
+    uint8_t * delta;
+    uint8_t * packed;
+
+    // the older snapshots, entries from first are oldest to newest and their data is in budget
+    uint8_t * data;
+    size_t head;
+    size_t used;
+    RewindEntry * entries;
+    uint32_t first;
+    uint32_t count;
+
+    uint32_t frames;
+
+    int threaded;
+    pthread_t thread;
+    pthread_mutex_t lock;
+    pthread_cond_t wake;
+    pthread_cond_t done;
+    int busy;
+    int quit;
+
+    // snapshots captured and skipped while the worker was busy, bytes stored for them and the
+    // cpu time each side spent
+    uint64_t captures;
+    uint64_t skipped;
+    uint64_t stored;
+    uint64_t capture_ns;
+    uint64_t delta_ns;
+} Rewind;
+
+// budget bytes for up to depth snapshots (4 whole states on top), 0 if it couldn't be set up
+int      rewind_init(Rewind * r, const Proc * p, size_t budget, uint32_t depth, uint32_t interval, int threaded);
+void     rewind_free(Rewind * r);
+
+// call at the end of every frame, captures every interval
+void     rewind_frame(Rewind * r, const Proc * p);
+// 1 if it was taken, 0 if the worker was still busy
+int      rewind_capture(Rewind * r, const Proc * p);
+// loads the newest snapshot into p and drops it so the next one is older, 0 if there's none
+int      rewind_step_back(Rewind * r, Proc * p);
+
+// snapshots that can be stepped back through
+uint32_t rewind_snapshots(Rewind * r);
+// bytes of the budget in use
+size_t   rewind_used(Rewind * r);
+
+#endif
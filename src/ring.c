@@ -0,0 +1,68 @@
+// ring.c
+#include <stdlib.h>
+#include <string.h>
+
+#include "ring.h"
+
+int audio_ring_init(AudioRing * r, uint32_t capacity) {
+    uint32_t size = 1;
+    while (size < capacity) size <<= 1;
+
+    memset(r, 0, sizeof(AudioRing));
+    r->samples = calloc(size, sizeof(StereoSample));
+    if (!r->samples) return 0;
+
+    r->capacity = size;
+    return 1;
+}
+
+void audio_ring_free(AudioRing * r) {
+    free(r->samples);
+    r->samples = NULL;
+    r->capacity = 0;
+}
+
+uint32_t audio_ring_fill(AudioRing * r) {
+    uint32_t head = __atomic_load_n(&r->head, __ATOMIC_ACQUIRE);
+    uint32_t tail = __atomic_load_n(&r->tail, __ATOMIC_ACQUIRE);
+    return head - tail;
+}
+
+static void ring_copy(StereoSample * to, uint32_t to_mask, uint32_t to_index,
+        const StereoSample * from, uint32_t from_mask, uint32_t from_index, uint32_t count) {
+    /* one of the two is the ring, the mask of the other is ~0 so it never wraps */
+    for (uint32_t i = 0; i < count; i++) {
+        to[(to_index + i) & to_mask] = from[(from_index + i) & from_mask];
+    }
+}
+
+uint32_t audio_ring_write(AudioRing * r, const StereoSample * samples, uint32_t count) {
+    uint32_t head = r->head;
+    // the consumer's samples have to be read before they're written over
+    uint32_t tail = __atomic_load_n(&r->tail, __ATOMIC_ACQUIRE);
+    uint32_t space = r->capacity - (head - tail);
+
+    if (count > space) {
+        r->overruns += count - space;
+        count = space;
+    }
+
+    ring_copy(r->samples, r->capacity - 1, head, samples, ~0u, 0, count);
+    __atomic_store_n(&r->head, head + count, __ATOMIC_RELEASE);
+    return count;
+}
+
+uint32_t audio_ring_read(AudioRing * r, StereoSample * samples, uint32_t count) {
+    uint32_t tail = r->tail;
+    uint32_t head = __atomic_load_n(&r->head, __ATOMIC_ACQUIRE);
+    uint32_t fill = head - tail;
+
+    if (count > fill) {
+        r->underruns += count - fill;
+        count = fill;
+    }
+
+    ring_copy(samples, ~0u, 0, r->samples, r->capacity - 1, tail, count);
+    __atomic_store_n(&r->tail, tail + count, __ATOMIC_RELEASE);
+    return count;
+}
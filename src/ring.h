@@ -0,0 +1,43 @@
+#ifndef RING_H
+#define RING_H
+
+#include <stdint.h>
+
+/*
+ * Single producer single consumer ring of stereo samples, the apu writes on the cpu thread
+ * and the audio callback (or the wav sink) reads. head and tail only ever move forward and
+ * each is only written by one side, so there are no locks, a full ring drops what doesn't fit
+ * and an empty one gives back less than asked for.
+ */
+
+typedef struct {
+    int16_t left;
+    int16_t right;
+} StereoSample;
+
+typedef struct {
+    StereoSample * samples;
+    // a power of 2 so the indexes can run freely and be masked
+    uint32_t capacity;
+
+    // written by the producer, samples that didn't fit
+    uint32_t head __attribute__((aligned(64)));
+    uint64_t overruns;
+
+    // written by the consumer, samples asked for that weren't there yet
+    uint32_t tail __attribute__((aligned(64)));
+    uint64_t underruns;
+} AudioRing;
+
+// capacity is rounded up to a power of 2, 0 if it couldn't be allocated
+int      audio_ring_init(AudioRing * r, uint32_t capacity);
+void     audio_ring_free(AudioRing * r);
+
+// producer, returns how many were written
+uint32_t audio_ring_write(AudioRing * r, const StereoSample * samples, uint32_t count);
+// consumer, returns how many were read
+uint32_t audio_ring_read(AudioRing * r, StereoSample * samples, uint32_t count);
+// samples waiting to be read, from either side
+uint32_t audio_ring_fill(AudioRing * r);
+
+#endif
@@ -0,0 +1,88 @@
+#include "scheduler.h"
+
+/* external definition of the inline in scheduler.h */
+extern inline uint64_t scheduler_next(const Scheduler * s);
+
+static void swap(Scheduler * s, int i, int j) {
+    Event e = s->heap[i];
+    s->heap[i] = s->heap[j];
+    s->heap[j] = e;
+
+    s->position[s->heap[i].type] = i;
+    s->position[s->heap[j].type] = j;
+}
+
+static void sift_up(Scheduler * s, int i) {
+    while (i > 0) {
+        int parent = (i - 1) / 2;
+        if (s->heap[parent].time <= s->heap[i].time) break;
+
+        swap(s, i, parent);
+        i = parent;
+    }
+}
+
+static void sift_down(Scheduler * s, int i) {
+    while (1) {
+        int smallest = i;
+        int left = 2 * i + 1;
+        int right = left + 1;
+
+        if (left < s->count && s->heap[left].time < s->heap[smallest].time) smallest = left;
+        if (right < s->count && s->heap[right].time < s->heap[smallest].time) smallest = right;
+        if (smallest == i) break;
+
+        swap(s, i, smallest);
+        i = smallest;
+    }
+}
+
+static void remove_at(Scheduler * s, int i) {
+    s->position[s->heap[i].type] = -1;
+    s->count--;
+
+    if (i == s->count) return;
+
+    s->heap[i] = s->heap[s->count];
+    s->position[s->heap[i].type] = i;
+    sift_down(s, i);
+    sift_up(s, i);
+}
+
+void scheduler_init(Scheduler * s) {
+    s->count = 0;
+    for (int i = 0; i < NUM_EVENTS; i++) {
+        s->position[i] = -1;
+    }
+}
+
+void scheduler_schedule(Scheduler * s, EventType type, uint64_t time) {
+    int i = s->position[type];
+
+    if (i < 0) {
+        i = s->count++;
+        s->heap[i].type = type;
+        s->position[type] = i;
+    }
+
+    s->heap[i].time = time;
+    sift_down(s, i);
+    sift_up(s, s->position[type]);
+}
+
+void scheduler_cancel(Scheduler * s, EventType type) {
+    if (s->position[type] >= 0) {
+        remove_at(s, s->position[type]);
+    }
+}
+
+int scheduler_pop(Scheduler * s, uint64_t now, uint64_t * time) {
+    /* takes the earliest event off if it's due by now, returns its type or -1 */
+    if (!s->count || s->heap[0].time > now) return -1;
+
+    int type = s->heap[0].type;
+    *time = s->heap[0].time;
+    remove_at(s, 0);
+
+    return type;
+}
@@ -0,0 +1,45 @@
+#ifndef SCHEDULER_H
+#define SCHEDULER_H
+
+#include <stdint.h>
+
+/*
+ * Min-heap of timestamped events for the peripherals. Each type has at most one event
+ * pending, scheduling it again moves it. Times are in cpu cycles (Proc.cycles), the cpu runs
+ * straight up to the earliest one instead of checking every peripheral after each instruction.
+ */
+
+#define NO_EVENT UINT64_MAX
+
+typedef enum {
+    EVENT_LCD,
+    EVENT_TIMER,
+    EVENT_SERIAL,
+    EVENT_JOYPAD,
+    EVENT_APU,
+    NUM_EVENTS
+} EventType;
+
+typedef struct {
+    uint64_t time;
+    uint8_t type;
+} Event;
+
+typedef struct {
+    Event heap[NUM_EVENTS];
+    int count;
+    // index of each type in the heap, -1 when it isn't scheduled
+    int position[NUM_EVENTS];
+} Scheduler;
+
+void scheduler_init(Scheduler * s);
+void scheduler_schedule(Scheduler * s, EventType type, uint64_t time);
+void scheduler_cancel(Scheduler * s, EventType type);
+int  scheduler_pop(Scheduler * s, uint64_t now, uint64_t * time);
+
+inline uint64_t scheduler_next(const Scheduler * s) {
+    /* when the earliest event is due, NO_EVENT if there isn't one */
+    return s->count ? s->heap[0].time : NO_EVENT;
+}
+
+#endif
@@ -0,0 +1,335 @@
+// state.c
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "state.h"
+#include "cart.h"
+#include "memory.h"
+
+/* state_pack control bytes, 0x00 -> 0x7F is that many + 1 bytes as they are */
+#define PACK_LITERALS 0x80
+// 0x80 -> 0xFE is the next byte that many - 0x80 + 3 times
+#define PACK_MIN_RUN 3
+#define PACK_SHORT_RUN (0xFE - 0x80 + PACK_MIN_RUN)
+// 0xFF is a 16 bit count + PACK_LONG_RUN, then the byte
+#define PACK_LONG 0xFF
+#define PACK_LONG_RUN (PACK_SHORT_RUN + 1)
+#define PACK_MAX_RUN (0xFFFF + PACK_LONG_RUN)
+
+static uint8_t * section_data(Proc * p, int id, size_t * size) {
+    /* where each section goes and how big it is here, NULL if there's nothing for it */
+    Cart * c = p->cart;
+
+    switch (id) {
+    case STATE_CPU:
+        // the registers through to HALT and STOP are the start of the struct (proc.h)
+        *size = offsetof(Proc, skip_idle_loops);
+        return (uint8_t *) p;
+    case STATE_MEMORY:
+        *size = sizeof(p->memory);
+        return p->memory;
+    case STATE_TILES:
+        // the decoded tiles and which ones are out of date, they're next to each other
+        *size = offsetof(Proc, tile_dirty) + sizeof(p->tile_dirty) - offsetof(Proc, tileset);
+        return (uint8_t *) p->tileset;
+    case STATE_TIMING:
+        // the scheduler's events and the timer
+        *size = offsetof(Proc, io) + sizeof(p->io) - offsetof(Proc, scheduler);
+        return (uint8_t *) &p->scheduler;
+    case STATE_APU:
+        // the channels, up to where the output is
+        *size = offsetof(Apu, ring);
+        return (uint8_t *) &p->apu;
+    case STATE_PPU:
+        *size = offsetof(Proc, palettes) + sizeof(p->palettes) - offsetof(Proc, window_line);
+        return &p->window_line;
+    case STATE_BANKS:
+        *size = sizeof(p->rom_map_bank);
+        return (uint8_t *) p->rom_map_bank;
+    case STATE_CART:
+        // the bank registers and the clock
+        if (!c) return NULL;
+        *size = offsetof(Cart, bank_switches) - offsetof(Cart, rom_bank);
+        return (uint8_t *) &c->rom_bank;
+    case STATE_CART_RAM:
+        if (!c || !c->ram_size) return NULL;
+        *size = c->ram_size;
+        return c->ram;
+    }
+    return NULL;
+}
+
+uint32_t state_rom_id(const Proc * p) {
+    /* the header's checksums and the size, enough to tell roms apart without hashing them */
+    const Cart * c = p->cart;
+    if (!c) return 0;
+
+    return (uint32_t) (c->rom_banks & 0xFF) << 24 | c->rom[HEADER_CHECKSUM] << 16
+         | c->rom[HEADER_GLOBAL_CHECKSUM] << 8 | c->rom[HEADER_GLOBAL_CHECKSUM + 1];
+}
+
+/* ---------------------------------------------------------------------------------------
+ * run length packing
+ * --------------------------------------------------------------------------------------- */
+
+static size_t pack_literals(const uint8_t * in, size_t count, uint8_t * out, size_t used, size_t capacity) {
+    /* in chunks of up to 128, returns the new used or 0 if it's full */
+    while (count) {
+        size_t chunk = count < PACK_LITERALS ? count : PACK_LITERALS;
+        if (used + 1 + chunk > capacity) return 0;
+
+        out[used++] = chunk - 1;
+        memcpy(out + used, in, chunk);
+        used += chunk;
+        in += chunk;
+        count -= chunk;
+    }
+    return used;
+}
+
+size_t state_pack(const uint8_t * in, size_t size, uint8_t * out, size_t capacity) {
+    size_t used = 0;
+    size_t literals = 0;
+
+    for (size_t i = 0; i < size;) {
+        size_t run = 1;
+        while (i + run < size && run < PACK_MIN_RUN && in[i + run] == in[i]) run++;
+        if (run < PACK_MIN_RUN) {
+            literals += run;
+            i += run;
+            continue;
+        }
+
+        // long runs are most of it, a rewind delta is nearly all 0s, 8 at a time while they last
+        uint64_t word, same = in[i] * 0x0101010101010101ULL;
+        while (i + run + 8 <= size && run + 8 <= PACK_MAX_RUN) {
+            memcpy(&word, in + i + run, 8);
+            if (word != same) break;
+            run += 8;
+        }
+        while (i + run < size && in[i + run] == in[i] && run < PACK_MAX_RUN) run++;
+
+        // whatever was different before the run goes first
+        if (literals && !(used = pack_literals(in + i - literals, literals, out, used, capacity))) return 0;
+        literals = 0;
+
+        if (run <= PACK_SHORT_RUN) {
+            if (used + 2 > capacity) return 0;
+            out[used++] = 0x80 + run - PACK_MIN_RUN;
+        } else {
+            if (used + 4 > capacity) return 0;
+            out[used++] = PACK_LONG;
+            out[used++] = (run - PACK_LONG_RUN) & 0xFF;
+            out[used++] = (run - PACK_LONG_RUN) >> 8;
+        }
+        out[used++] = in[i];
+        i += run;
+    }
+
+    if (literals && !(used = pack_literals(in + size - literals, literals, out, used, capacity))) return 0;
+    return used;
+}
+
+static size_t unpacked_size(const uint8_t * in, size_t stored) {
+    /* walks the control bytes without writing anything, SIZE_MAX if it runs off the end */
+    size_t total = 0;
+
+    for (size_t i = 0; i < stored;) {
+        uint8_t control = in[i++];
+        size_t length;
+        if (control < PACK_LITERALS) {
+            length = control + 1;
+            if (i + length > stored) return SIZE_MAX;
+            i += length;
+        } else if (control != PACK_LONG) {
+            if (i + 1 > stored) return SIZE_MAX;
+            length = control - 0x80 + PACK_MIN_RUN;
+            i++;
+        } else {
+            if (i + 3 > stored) return SIZE_MAX;
+            length = (in[i] | in[i + 1] << 8) + PACK_LONG_RUN;
+            i += 3;
+        }
+        total += length;
+    }
+    return total;
+}
+
+int state_unpack(const uint8_t * in, size_t stored, uint8_t * out, size_t size) {
+    size_t used = 0;
+
+    for (size_t i = 0; i < stored;) {
+        uint8_t control = in[i++];
+        if (control < PACK_LITERALS) {
+            size_t length = control + 1;
+            if (i + length > stored || used + length > size) return 0;
+            memcpy(out + used, in + i, length);
+            i += length;
+            used += length;
+            continue;
+        }
+
+        size_t length;
+        if (control != PACK_LONG) {
+            length = control - 0x80 + PACK_MIN_RUN;
+        } else {
+            if (i + 2 > stored) return 0;
+            length = (in[i] | in[i + 1] << 8) + PACK_LONG_RUN;
+            i += 2;
+        }
+        if (i + 1 > stored || used + length > size) return 0;
+        memset(out + used, in[i++], length);
+        used += length;
+    }
+    return used == size;
+}
+
+/* ---------------------------------------------------------------------------------------
+ * saving and loading
+ * --------------------------------------------------------------------------------------- */
+
+size_t state_bound(const Proc * p) {
+    // a section that doesn't pack any smaller is stored as it is
+    size_t bound = sizeof(StateHeader);
+    for (int id = STATE_CPU; id <= STATE_CART_RAM; id++) {
+        size_t size;
+        if (section_data((Proc *) p, id, &size)) bound += sizeof(StateSection) + size;
+    }
+    return bound;
+}
+
+size_t state_save(const Proc * p, uint8_t * buffer, size_t capacity, int flags) {
+    StateHeader header;
+    memcpy(header.magic, STATE_MAGIC, sizeof(header.magic));
+    header.version = STATE_VERSION;
+    header.sections = 0;
+    header.rom_id = state_rom_id(p);
+    header.cycles = p->cycles;
+
+    size_t used = sizeof(StateHeader);
+    if (used > capacity) return 0;
+
+    for (int id = STATE_CPU; id <= STATE_CART_RAM; id++) {
+        size_t size;
+        const uint8_t * data = section_data((Proc *) p, id, &size);
+        if (!data) continue;
+        if (used + sizeof(StateSection) > capacity) return 0;
+
+        StateSection section = { id, 0, size, size };
+        uint8_t * out = buffer + used + sizeof(StateSection);
+        size_t room = capacity - used - sizeof(StateSection);
+
+        // packed only if it comes out smaller
+        size_t packed = 0;
+        if (flags & STATE_PACKED) {
+            packed = state_pack(data, size, out, room < size ? room : size - 1);
+        }
+        if (packed) {
+            section.packed = 1;
+            section.stored = packed;
+        } else {
+            if (size > room) return 0;
+            memcpy(out, data, size);
+        }
+
+        memcpy(buffer + used, &section, sizeof(section));
+        used += sizeof(section) + section.stored;
+        header.sections++;
+    }
+
+    header.size = used;
+    memcpy(buffer, &header, sizeof(header));
+    return used;
+}
+
+static void state_rebuild(Proc * p) {
+    /* puts back everything that points somewhere for the state that was just loaded */
+
+    // the blocks were decoded from memory that isn't there any more
+    if (p->jit) jit_flush(p->jit, p->block_cache);
+    if (p->block_cache) block_cache_flush(p->block_cache);
+
+    // the pages to the banks the cart registers pick
+    memory_reset_pages(p);
+    if (p->cart) cart_load(p->cart, p);
+
+    // the blips were part way through the old sound, they start again from the loaded channels
+    if (p->apu.ring) apu_set_output(p, p->apu.ring, p->apu.rate);
+
+    // wherever the cpu was going to stop was for the old cycle count
+    p->deadline = p->cycles;
+}
+
+int state_load(Proc * p, const uint8_t * buffer, size_t size) {
+    StateHeader header;
+    if (size < sizeof(header)) return 0;
+    memcpy(&header, buffer, sizeof(header));
+
+    if (memcmp(header.magic, STATE_MAGIC, sizeof(header.magic)) != 0 || header.version != STATE_VERSION
+            || header.size > size || header.rom_id != state_rom_id(p)) {
+        return 0;
+    }
+
+    // the first pass checks every section, the second copies them in
+    for (int pass = 0; pass < 2; pass++) {
+        size_t used = sizeof(header);
+
+        for (int i = 0; i < header.sections; i++) {
+            StateSection section;
+            if (used + sizeof(section) > header.size) return 0;
+            memcpy(&section, buffer + used, sizeof(section));
+            used += sizeof(section);
+
+            size_t expected = 0;
+            uint8_t * data = section_data(p, section.id, &expected);
+            const uint8_t * in = buffer + used;
+
+            if (pass == 0) {
+                if (!data || section.size != expected || section.stored > header.size - used) return 0;
+                if (section.packed ? unpacked_size(in, section.stored) != expected : section.stored != expected) {
+                    return 0;
+                }
+            } else if (section.packed) {
+                state_unpack(in, section.stored, data, section.size);
+            } else {
+                memcpy(data, in, section.size);
+            }
+
+            used += section.stored;
+        }
+    }
+
+    state_rebuild(p);
+    return 1;
+}
+
+int state_save_file(const Proc * p, const char * path, int flags) {
+    size_t capacity = state_bound(p);
+    uint8_t * buffer = malloc(capacity);
+    if (!buffer) return 0;
+
+    size_t size = state_save(p, buffer, capacity, flags);
+    FILE * f = size ? fopen(path, "wb") : NULL;
+    int saved = f && fwrite(buffer, 1, size, f) == size;
+    if (f && fclose(f) != 0) saved = 0;
+
+    free(buffer);
+    return saved;
+}
+
+int state_load_file(Proc * p, const char * path) {
+    FILE * f = fopen(path, "rb");
+    if (!f) return 0;
+
+    fseek(f, 0, SEEK_END);
+    long size = ftell(f);
+    fseek(f, 0, SEEK_SET);
+
+    uint8_t * buffer = size > 0 ? malloc(size) : NULL;
+    int loaded = buffer && fread(buffer, 1, size, f) == (size_t) size && state_load(p, buffer, size);
+
+    free(buffer);
+    fclose(f);
+    return loaded;
+}
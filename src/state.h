@@ -0,0 +1,77 @@
+#ifndef STATE_H
+#define STATE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "proc.h"
+
+/*
+ * Save states. A state is a StateHeader then sections, each a StateSection and the bytes of
+ * one part of Proc or the cart exactly as they are in the structs, so loading is a memcpy per
+ * section (or unpacking straight into the struct) and nothing gets parsed. The layout is this
+ * build's structs on this host, a section that isn't the size it is here won't load and any
+ * change to what goes in one has to bump STATE_VERSION.
+ *
+ * Anything that only points somewhere (the memory pages, the cart, the ring) isn't saved, it's
+ * put back together for the Proc it's loaded into. Cached and compiled code is thrown away.
+ */
+
+#define STATE_MAGIC "GBST"
+#define STATE_VERSION 1
+
+// state_save flags
+#define STATE_PACKED 0x1
+
+typedef enum {
+    STATE_CPU = 1,
+    STATE_MEMORY,
+    STATE_TILES,
+    STATE_TIMING,
+    STATE_APU,
+    STATE_PPU,
+    STATE_BANKS,
+    STATE_CART,
+    STATE_CART_RAM
+} StateSectionId;
+
+typedef struct {
+    char magic[4];
+    uint16_t version;
+    uint16_t sections;
+    // whole state including this header
+    uint32_t size;
+    // which rom it was saved with (state_rom_id), 0 without a cart
+    uint32_t rom_id;
+    uint64_t cycles;
+} StateHeader;
+
+typedef struct {
+    uint16_t id;
+    // the bytes are packed (state_pack) rather than as they are in the struct
+    uint16_t packed;
+    // in the struct, and what follows this header
+    uint32_t size;
+    uint32_t stored;
+} StateSection;
+
+// most bytes state_save can need for p
+size_t   state_bound(const Proc * p);
+// returns the bytes written into buffer, 0 if it didn't fit
+size_t   state_save(const Proc * p, uint8_t * buffer, size_t capacity, int flags);
+// 1 if it loaded, a state that's wrong in any way is caught before p is touched
+int      state_load(Proc * p, const uint8_t * buffer, size_t size);
+
+int      state_save_file(const Proc * p, const char * path, int flags);
+int      state_load_file(Proc * p, const char * path);
+
+uint32_t state_rom_id(const Proc * p);
+
+/* run length coding for the sections, memory is mostly long runs of the same byte. Returns
+ * the packed size, 0 if it didn't fit in capacity
+ */
+size_t   state_pack(const uint8_t * in, size_t size, uint8_t * out, size_t capacity);
+// 1 if in unpacked to exactly size bytes
+int      state_unpack(const uint8_t * in, size_t stored, uint8_t * out, size_t size);
+
+#endif
@@ -1,10 +1,93 @@
 #include "helpers.h"
+#include "proc.h"
+#include "memory.h"
+#include "opcodes.h"
+#include "cart.h"
+#include "tile.h"
+#include "ppu.h"
+#include "headless.h"
+#include "palette.h"
+#include "timing.h"
+#include "state.h"
+#include "rewind.h"
 
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
 
 #define print(s) printf("\x1B[32m"); printf(s); printf("\x1B[0m\n");
 #define incorrect(s) printf("\x1B[31m"); printf(s); printf("\x1B[0m\n"); RET_STATUS = 1;
 
+#define PROGRAM_START 0xC000
+
+/* puts a program in work ram and points the cpu at it */
+void load_program(Proc * p, const uint8_t * program, int size) {
+    for (int i = 0; i < size; i++) {
+        write_byte(p, PROGRAM_START + i, program[i]);
+    }
+    p->pc = PROGRAM_START;
+}
+
+/* runs until pc reaches the end of the program, returns the instructions run */
+int run_program(Proc * p, int size) {
+    int instructions = 0;
+    while (p->pc != PROGRAM_START + size && instructions < 10000) {
+        proc_read_word(p);
+        instructions++;
+    }
+    return instructions;
+}
+
+/* random straight line block ending in JP C000, returns its size */
+int random_block(uint8_t * program) {
+    int size = 0;
+    int ops = 1 + rand() % 8;
+
+    for (int i = 0; i < ops; i++) {
+        uint8_t opcode;
+        do {
+            opcode = rand();
+        } while (opcode_info[opcode].ends_block);
+
+        const OpcodeInfo * info = opcode == 0xCB ? &cb_opcode_info[0] : &opcode_info[opcode];
+        program[size++] = opcode;
+        for (int j = 1; j < info->length; j++) {
+            program[size++] = rand();
+        }
+    }
+
+    program[size++] = 0xC3;
+    program[size++] = 0x00;
+    program[size++] = 0xC0;
+    return size;
+}
+
+/* same random state and block through the jit and the interpreter, returns 1 if they match */
+int jit_matches_interpreter(Proc * jit, Proc * interpreter, const uint8_t * program, int size) {
+    Proc * procs[2] = { jit, interpreter };
+
+    Registers registers = { .bc = rand(), .de = rand(), .hl = rand(), .a = rand() };
+    uint8_t f = rand() & 0xF0;
+    uint16_t sp = rand();
+
+    for (int i = 0; i < 2; i++) {
+        procs[i]->registers = registers;
+        proc_set_f(procs[i], f);
+        procs[i]->sp = sp;
+        load_program(procs[i], program, size);
+        procs[i]->deadline = procs[i]->cycles + 1000;
+        proc_run_block(procs[i]);
+    }
+
+    Registers * a = &jit->registers, * b = &interpreter->registers;
+    return a->a == b->a && a->b == b->b && a->c == b->c && a->d == b->d
+        && a->e == b->e && a->h == b->h && a->l == b->l
+        && proc_get_f(jit) == proc_get_f(interpreter)
+        && jit->pc == interpreter->pc && jit->sp == interpreter->sp
+        && jit->cycles == interpreter->cycles
+        && memcmp(jit->memory, interpreter->memory, MEM_SIZE) == 0;
+}
+
 int main() {
     int RET_STATUS = 0;
 
@@ -80,5 +163,688 @@ int main() {
     }
     printf("\t%d\n", upper);
 
+    Proc * p = proc_create();
+
+    print("testing loop summing 1..10 with DEC/JR NZ");
+    const uint8_t sum_program[] = {
+        0xAF,           // XOR A
+        0x06, 0x0A,     // LD B,10
+        0x80,           // ADD A,B
+        0x05,           // DEC B
+        0x20, 0xFC,     // JR NZ,-4
+    };
+    load_program(p, sum_program, sizeof(sum_program));
+    run_program(p, sizeof(sum_program));
+    if (p->registers.a != 55) {
+        incorrect("\tincorrect");
+    } else {
+        print("\tcorrect");
+    }
+    printf("\t%d\n", p->registers.a);
+
+    print("testing CALL/RET and PUSH/POP AF keep the stack and flags");
+    const uint8_t call_program[] = {
+        0x31, 0xFE, 0xDF,   // LD SP,DFFE
+        0x37,               // SCF
+        0xF5,               // PUSH AF
+        0xCD, 0x0C, 0xC0,   // CALL C00C
+        0xF1,               // POP AF
+        0x18, 0x03,         // JR +3, to the end of the program
+        0x00,               // NOP (skipped)
+        0x3F,               // C00C CCF
+        0xC9,               // RET
+    };
+    load_program(p, call_program, sizeof(call_program));
+    run_program(p, sizeof(call_program));
+    if (p->sp != 0xDFFE || !(proc_get_f(p) & FLAG_CARRY) || p->pc != PROGRAM_START + sizeof(call_program)) {
+        incorrect("\tincorrect");
+    } else {
+        print("\tcorrect");
+    }
+
+    print("testing DAA after adding 0x15 + 0x27");
+    const uint8_t daa_program[] = {
+        0x3E, 0x15,     // LD A,15
+        0xC6, 0x27,     // ADD A,27
+        0x27,           // DAA
+    };
+    load_program(p, daa_program, sizeof(daa_program));
+    run_program(p, sizeof(daa_program));
+    if (p->registers.a != 0x42) {
+        incorrect("\tincorrect");
+    } else {
+        print("\tcorrect");
+    }
+    printf("\t%02X\n", p->registers.a);
+
+    print("testing cycles for JR NZ taken and not taken and CB ops, BIT n,(HL) is 12 not 16");
+    const uint8_t cycle_program[] = {
+        0xAF,               // XOR A        4
+        0x20, 0x00,         // JR NZ,+0     8, not taken
+        0x3C,               // INC A        4
+        0x20, 0x00,         // JR NZ,+0     12, taken
+        0xCB, 0x37,         // SWAP A       8
+        0x21, 0x00, 0xC0,   // LD HL,C000   12
+        0xCB, 0x46,         // BIT 0,(HL)   12
+    };
+    load_program(p, cycle_program, sizeof(cycle_program));
+    uint64_t start_cycles = p->cycles;
+    run_program(p, sizeof(cycle_program));
+    if (p->cycles - start_cycles != 60 || p->registers.a != 0x10) {
+        incorrect("\tincorrect");
+    } else {
+        print("\tcorrect");
+    }
+    printf("\t%d\n", (int) (p->cycles - start_cycles));
+
+    print("testing the carry from an ADD survives an INC and gets pushed with AF");
+    const uint8_t lazy_program[] = {
+        0x3E, 0xFF,     // LD A,FF
+        0xC6, 0x01,     // ADD A,1      Z 0 H C
+        0x06, 0x00,     // LD B,0
+        0x04,           // INC B        0 0 0 -, carry from the add stays
+        0xF5,           // PUSH AF
+        0xC1,           // POP BC
+    };
+    load_program(p, lazy_program, sizeof(lazy_program));
+    run_program(p, sizeof(lazy_program));
+    if (p->registers.c != FLAG_CARRY) {
+        incorrect("\tincorrect");
+    } else {
+        print("\tcorrect");
+    }
+    printf("\t%02X\n", p->registers.c);
+
+    print("testing block cache drops blocks that get written over");
+    const uint8_t smc_program[] = {
+        0xAF,               // XOR A
+        0x21, 0x07, 0xC0,   // LD HL,C007
+        0x36, 0x3C,         // LD (HL),3C, INC A over the NOP below
+        0x00,               // NOP
+        0x00,               // C007 NOP -> INC A
+        0x18, 0xFE,         // JR -2, spin here
+    };
+    load_program(p, smc_program, sizeof(smc_program));
+    proc_run_cycles(p, 200);
+    if (p->registers.a != 1 || p->block_cache->invalidations == 0) {
+        incorrect("\tincorrect");
+    } else {
+        print("\tcorrect");
+    }
+    printf("\t%d\n", p->registers.a);
+
+    print("testing timer interrupt wakes up HALT, skipping the wait, and jumps to 0x50");
+    const uint8_t interrupt_program[] = {
+        0xAF,               // XOR A
+        0xFB,               // EI
+        0x76,               // HALT
+        0x00,               // NOP
+        0x18, 0xFE,         // JR -2, spin here
+    };
+    p->memory[0x50] = 0x3C;     // INC A
+    p->memory[0x51] = 0xD9;     // RETI
+    write_byte(p, IO_TIMA, 0xFE);
+    write_byte(p, IO_TAC, 0x05);
+    write_byte(p, IO_IE, INT_TIMER);
+    load_program(p, interrupt_program, sizeof(interrupt_program));
+    proc_run_cycles(p, 200);
+    if (p->registers.a != 1 || p->halted || p->pc < PROGRAM_START + 3 || !p->stats.halted_cycles) {
+        incorrect("\tincorrect");
+    } else {
+        print("\tcorrect");
+    }
+    printf("\t%d\n", p->registers.a);
+
+    proc_delete(p);
+
+    print("testing skipping a loop polling LY ends up the same as running it");
+    const uint8_t poll_program[] = {
+        0xF0, 0x44,         // LDH A,(44)
+        0xFE, 0x90,         // CP 90
+        0x20, 0xFA,         // JR NZ,-6
+        0x00,               // NOP
+        0x18, 0xFE,         // JR -2, spin here
+    };
+    Proc * skipped = proc_create();
+    Proc * polled = proc_create();
+    polled->skip_idle_loops = 0;
+    load_program(skipped, poll_program, sizeof(poll_program));
+    load_program(polled, poll_program, sizeof(poll_program));
+    proc_run_cycles(skipped, CYCLES_PER_FRAME);
+    proc_run_cycles(polled, CYCLES_PER_FRAME);
+    if (skipped->cycles != polled->cycles || skipped->pc != polled->pc
+            || skipped->registers.a != 0x90 || !skipped->stats.idle_skips) {
+        incorrect("\tincorrect");
+    } else {
+        print("\tcorrect");
+    }
+    printf("\t%llu cycles skipped\n", (unsigned long long) skipped->stats.idle_cycles);
+    proc_delete(skipped);
+    proc_delete(polled);
+
+    print("testing vram writes only decode the tile when it's needed");
+    p = proc_create();
+    for (int i = 0; i < 3; i++) {
+        // tile 1, row 0 written three times, ends up 0x3C / 0x7E
+        write_byte(p, 0x8010, 0x3C);
+        write_byte(p, 0x8011, i == 2 ? 0x7E : 0x00);
+    }
+    int before = p->tileset[1][0][2];
+    int decoded = tiles_update(p);
+    // pixels 1 -> 6 are set in the high plane, 2 -> 5 in the low one
+    if (before != 0 || decoded != 1 || p->tileset[1][0][0] != 0 || p->tileset[1][0][1] != 2
+            || p->tileset[1][0][2] != 3 || tiles_update(p) != 0) {
+        incorrect("\tincorrect");
+    } else {
+        print("\tcorrect");
+    }
+    printf("\t%d decoded\n", decoded);
+
+    print("testing the tile decoder against decoding a pixel at a time");
+    srand(2);
+    for (uint16_t address = 0x8000; address < 0x9800; address++) {
+        write_byte(p, address, rand());
+    }
+    tiles_update(p);
+    int wrong = 0;
+    for (int tile = 0; tile < NUM_TILES; tile++) {
+        for (int y = 0; y < TILE_HEIGHT; y++) {
+            uint8_t low = p->memory[0x8000 + tile * TILE_BYTES + 2 * y];
+            uint8_t high = p->memory[0x8000 + tile * TILE_BYTES + 2 * y + 1];
+            for (int x = 0; x < TILE_WIDTH; x++) {
+                int pixel = ((low >> (7 - x)) & 1) | (((high >> (7 - x)) & 1) << 1);
+                wrong += p->tileset[tile][y][x] != pixel;
+            }
+        }
+    }
+    if (wrong) {
+        incorrect("\tincorrect");
+    } else {
+        print("\tcorrect");
+    }
+    printf("\t%d wrong pixels\n", wrong);
+    proc_delete(p);
+
+    print("testing the ppu draws the background and a sprite over it");
+    p = proc_create();
+    const uint8_t spin_program[] = { 0x18, 0xFE };     // JR -2
+    load_program(p, spin_program, sizeof(spin_program));
+    for (int i = 0; i < TILE_BYTES; i++) {
+        write_byte(p, 0x8010 + i, 0xFF);                // tile 1 is all colour 3
+        write_byte(p, 0x8020 + i, i & 1 ? 0x00 : 0xF0); // tile 2 is colour 1 on the left half
+    }
+    write_byte(p, 0x9800, 0x01);                        // top left of the background is tile 1
+    write_byte(p, IO_BGP, 0xE4);
+    write_byte(p, IO_OBP0, 0xE4);
+    write_byte(p, OAM_START, 16 + 4);                   // tile 2 at (4, 4), half over tile 1
+    write_byte(p, OAM_START + 1, 8 + 4);
+    write_byte(p, OAM_START + 2, 0x02);
+    write_byte(p, IO_LCDC, 0x93);                       // on, 0x8000 tiles, background and sprites
+    proc_run_cycles(p, CYCLES_PER_FRAME);
+    // sprite colour 1 from x 4 to 7, see through after that
+    const uint8_t (*frame)[SCREEN_WIDTH] = triple_buffer_acquire(&p->frames);
+    if (frame[0][0] != 3 || frame[0][8] != 0 || frame[4][2] != 3
+            || frame[4][4] != 1 || frame[4][7] != 1 || frame[4][8] != 0) {
+        incorrect("\tincorrect");
+    } else {
+        print("\tcorrect");
+    }
+    printf("\t%d %d %d %d\n", frame[0][0], frame[4][2], frame[4][7], frame[4][8]);
+    proc_delete(p);
+
+    print("testing the line is white with the background off, even with BGP colour 0 dark");
+    p = proc_create();
+    load_program(p, spin_program, sizeof(spin_program));
+    for (int i = 0; i < TILE_BYTES; i++) {
+        write_byte(p, 0x8010 + i, 0xFF);
+        write_byte(p, 0x8020 + i, i & 1 ? 0x00 : 0xF0);
+    }
+    write_byte(p, 0x9800, 0x01);
+    write_byte(p, IO_BGP, 0xE7);                        // colour 0 is black
+    write_byte(p, IO_OBP0, 0xE4);
+    write_byte(p, OAM_START, 16 + 4);
+    write_byte(p, OAM_START + 1, 8 + 4);
+    write_byte(p, OAM_START + 2, 0x02);
+    write_byte(p, IO_LCDC, 0x92);                       // as above with the background off
+    proc_run_cycles(p, CYCLES_PER_FRAME);
+    frame = triple_buffer_acquire(&p->frames);
+    if (frame[0][0] != 0 || frame[4][2] != 0 || frame[4][4] != 1 || frame[4][8] != 0) {
+        incorrect("\tincorrect");
+    } else {
+        print("\tcorrect");
+    }
+    printf("\t%d %d %d %d\n", frame[0][0], frame[4][2], frame[4][4], frame[4][8]);
+    proc_delete(p);
+
+    print("testing oam dma copies the sprites in from work ram");
+    p = proc_create();
+    load_program(p, spin_program, sizeof(spin_program));
+    for (int i = 0; i < TILE_BYTES; i++) {
+        write_byte(p, 0x8020 + i, 0xFF);                // tile 2 is all colour 3
+    }
+    write_byte(p, IO_BGP, 0xE4);
+    write_byte(p, IO_OBP0, 0xE4);
+    write_byte(p, 0xD000, 16 + 8);                      // tile 2 at (10, 8), the way games set them up
+    write_byte(p, 0xD001, 8 + 10);
+    write_byte(p, 0xD002, 0x02);
+    write_byte(p, 0xD09F, 0x5A);                        // last byte of the 160
+    write_byte(p, IO_DMA, 0xD0);
+    write_byte(p, IO_LCDC, 0x93);
+    proc_run_cycles(p, CYCLES_PER_FRAME);
+    frame = triple_buffer_acquire(&p->frames);
+    if (p->memory[OAM_START + 1] != 18 || p->memory[OAM_START + 159] != 0x5A
+            || frame[8][10] != 3 || frame[8][17] != 3 || frame[8][9] != 0 || frame[7][10] != 0) {
+        incorrect("\tincorrect");
+    } else {
+        print("\tcorrect");
+    }
+    printf("\t%d %d %d %d\n", frame[8][10], frame[8][17], frame[8][9], frame[7][10]);
+    proc_delete(p);
+
+    print("testing palette writes update the lookup and lines convert to the colour scheme");
+    p = proc_create();
+    write_byte(p, IO_OBP1, 0x1B);                       // 3 2 1 0, reversed
+    ColorScheme scheme;
+    int parsed = palette_parse_scheme("FFFFFF,AAAAAA,555555,000000", &scheme);
+    uint8_t shades[SCREEN_WIDTH + 3];
+    uint32_t converted[SCREEN_WIDTH + 3];
+    for (int x = 0; x < SCREEN_WIDTH + 3; x++) {
+        shades[x] = rand() & 3;
+    }
+    // an odd count so the end of the line goes through the leftover pixels
+    palette_convert_line(&scheme, shades, converted, SCREEN_WIDTH + 3);
+    int wrong_colors = 0;
+    for (int x = 0; x < SCREEN_WIDTH + 3; x++) {
+        wrong_colors += converted[x] != (0xFF000000 | (0x555555 * (3 - shades[x])));
+    }
+    if (!parsed || wrong_colors || p->palettes[PALETTE_OBJ1][0] != 3 || p->palettes[PALETTE_OBJ1][3] != 0
+            || p->palettes[PALETTE_BG][3] != 3 || palette_parse_scheme("FFFFFF,AAAAAA", &scheme)) {
+        incorrect("\tincorrect");
+    } else {
+        print("\tcorrect");
+    }
+    printf("\t%d wrong pixels\n", wrong_colors);
+    proc_delete(p);
+
+    print("testing the triple buffer hands over the newest frame and counts the rest");
+    TripleBuffer * frames = calloc(1, sizeof(TripleBuffer));
+    triple_buffer_init(frames);
+    uint8_t (*back)[SCREEN_WIDTH] = frames->buffers[frames->back];
+    for (int i = 1; i <= 3; i++) {
+        back[0][0] = i;
+        back = triple_buffer_publish(frames);
+    }
+    // 1 and 2 were replaced before anything took them, then 3 is shown twice
+    uint8_t first = triple_buffer_acquire(frames)[0][0];
+    uint8_t second = triple_buffer_acquire(frames)[0][0];
+    if (first != 3 || second != 3 || frames->dropped != 2 || frames->duplicated != 1
+            || back == frames->buffers[frames->front]) {
+        incorrect("\tincorrect");
+    } else {
+        print("\tcorrect");
+    }
+    printf("\t%d %d dropped %llu duplicated %llu\n", first, second,
+            (unsigned long long) frames->dropped, (unsigned long long) frames->duplicated);
+    free(frames);
+
+    print("testing headless runs hand every frame to the file sink");
+    p = proc_create();
+    load_program(p, spin_program, sizeof(spin_program));
+    write_byte(p, 0x9800, 0x01);                        // tile 1 is still blank, colour 0
+    write_byte(p, IO_BGP, 0xE7);                        // colour 0 is black
+    FILE * sink_file = tmpfile();
+    Headless sink = { .callback = headless_file_sink, .data = sink_file };
+    for (int i = 0; i < 3; i++) {
+        proc_run_cycles(p, CYCLES_PER_FRAME);
+        headless_present(&sink, p);
+    }
+    long sink_size = ftell(sink_file);
+    rewind(sink_file);
+    int sink_pixel = fgetc(sink_file);
+    if (sink.frames != 3 || sink_size != 3 * SCREEN_WIDTH * SCREEN_HEIGHT || sink_pixel != 0x00) {
+        incorrect("\tincorrect");
+    } else {
+        print("\tcorrect");
+    }
+    printf("\t%llu frames, %ld bytes\n", (unsigned long long) sink.frames, sink_size);
+    fclose(sink_file);
+    proc_delete(p);
+
+    print("testing frame skip keeps the vblanks but only draws the frames it should");
+    p = proc_create();
+    load_program(p, spin_program, sizeof(spin_program));
+    p->frame_skip.skip = 1;
+    p->frame_skip.every = 2;
+    proc_run_cycles(p, 4 * CYCLES_PER_FRAME);
+    uint64_t fixed_drawn = p->frames.published;
+    // adaptive with nothing taking the frames, the first is drawn and the rest wait for it
+    p->frame_skip.every = 0;
+    p->frame_skip.adaptive = 1;
+    proc_run_cycles(p, 4 * CYCLES_PER_FRAME);
+    if (p->stats.frames != 8 || fixed_drawn != 2 || p->frames.published != 3 || p->stats.frames_skipped != 5) {
+        incorrect("\tincorrect");
+    } else {
+        print("\tcorrect");
+    }
+    printf("\t%llu vblanks, %llu drawn, %llu skipped\n", (unsigned long long) p->stats.frames,
+            (unsigned long long) p->frames.published, (unsigned long long) p->stats.frames_skipped);
+    proc_delete(p);
+
+    print("testing the apu makes a frame of samples in batches and length turns channels off");
+    p = proc_create();
+    load_program(p, spin_program, sizeof(spin_program));
+    AudioRing ring;
+    audio_ring_init(&ring, 4096);
+    apu_set_output(p, &ring, 48000);
+    write_byte(p, IO_NR50, 0x77);
+    write_byte(p, IO_NR51, 0xFF);
+    write_byte(p, IO_NR22, 0xF0);                       // full volume
+    write_byte(p, IO_NR21, 0x80 | 62);                  // 50%, 2 length steps
+    write_byte(p, IO_NR23, 0xD6);
+    write_byte(p, IO_NR24, 0xC6);                       // 440 Hz, length on, trigger
+    uint8_t playing = read_byte(p, IO_NR52);
+    proc_run_cycles(p, CYCLES_PER_FRAME);
+    apu_sync(p);
+    uint8_t stopped = read_byte(p, IO_NR52);
+    uint32_t samples = audio_ring_fill(&ring);
+    int16_t loudest = 0;
+    StereoSample sample;
+    while (audio_ring_read(&ring, &sample, 1)) {
+        if (sample.left > loudest) loudest = sample.left;
+    }
+    // 48000 / 59.7 a frame
+    if (playing != 0xF2 || stopped != 0xF0 || samples < 800 || samples > 806 || loudest < 4000) {
+        incorrect("\tincorrect");
+    } else {
+        print("\tcorrect");
+    }
+    printf("\tNR52 %02X then %02X, %u samples, loudest %d\n", playing, stopped, samples, loudest);
+    audio_ring_free(&ring);
+    proc_delete(p);
+
+    print("testing rate control keeps the ring filled for a sound card running 0.1%% fast");
+    p = proc_create();
+    load_program(p, spin_program, sizeof(spin_program));
+    audio_ring_init(&ring, 8192);
+    apu_set_output(p, &ring, 48000);
+    RateControl rate;
+    timing_rate_control_init(&rate, 1920);
+    StereoSample chunk[1024] = {{0}};
+    audio_ring_write(&ring, chunk, 1920);
+    // the card takes 1024 at a time like the sdl callback
+    double owed = 0;
+    uint64_t settled_underruns = 0;
+    for (int frame = 0; frame < 3000; frame++) {
+        proc_run_cycles(p, CYCLES_PER_FRAME);
+        apu_sync(p);
+        for (owed += 48000 * 1.001 * FRAME_NS / 1e9; owed >= 1024; owed -= 1024) {
+            audio_ring_read(&ring, chunk, 1024);
+        }
+        apu_adjust_rate(p, timing_rate_control_update(&rate, audio_ring_fill(&ring)));
+        if (frame == 1500) settled_underruns = ring.underruns;
+    }
+    if (ring.underruns != settled_underruns || ring.overruns || rate.ratio < 1.0005 || rate.ratio > 1.0015
+            || rate.fill < 1000 || rate.fill > 1920) {
+        incorrect("\tincorrect");
+    } else {
+        print("\tcorrect");
+    }
+    printf("\trate x%.4f, %.0f samples in the ring, %llu underruns settling then %llu, %llu overruns\n",
+            rate.ratio, rate.fill, (unsigned long long) settled_underruns,
+            (unsigned long long) (ring.underruns - settled_underruns), (unsigned long long) ring.overruns);
+    audio_ring_free(&ring);
+    proc_delete(p);
+
+    print("testing MBC1 switches rom banks for data and code, and ram");
+    uint8_t * rom = calloc(4, ROM_BANK_SIZE);
+    rom[HEADER_TYPE] = 0x03;        // MBC1+RAM+BATTERY
+    rom[HEADER_RAM_SIZE] = 0x02;    // 8 KiB
+    for (int bank = 1; bank < 4; bank++) {
+        // LD A,bank / RET at the start of every bank
+        rom[bank * ROM_BANK_SIZE] = 0x3E;
+        rom[bank * ROM_BANK_SIZE + 1] = bank;
+        rom[bank * ROM_BANK_SIZE + 2] = 0xC9;
+    }
+    const uint8_t bank_program[] = {
+        0x3E, 0x02,         // LD A,2
+        0xEA, 0x00, 0x20,   // LD (2000),A
+        0xCD, 0x00, 0x40,   // CALL 4000
+        0x47,               // LD B,A
+        0x3E, 0x03,         // LD A,3
+        0xEA, 0x00, 0x20,   // LD (2000),A
+        0xCD, 0x00, 0x40,   // CALL 4000
+        0x4F,               // LD C,A
+        0x18, 0xFE,         // JR -2, spin here
+    };
+    Cart * cart = cart_create_from_buffer(rom, 4 * ROM_BANK_SIZE);
+    p = proc_create();
+    cart_load(cart, p);
+    load_program(p, bank_program, sizeof(bank_program));
+    proc_run_cycles(p, 200);
+    uint8_t ram_disabled = read_byte(p, 0xA000);
+    write_byte(p, 0x0000, 0x0A);
+    write_byte(p, 0xA010, 0x42);
+    write_byte(p, 0x2000, 0x00);    // bank 0 selects 1
+    if (p->registers.b != 2 || p->registers.c != 3 || read_byte(p, 0x4001) != 1
+            || ram_disabled != 0xFF || read_byte(p, 0xA010) != 0x42 || cart->ram[0x10] != 0x42) {
+        incorrect("\tincorrect");
+    } else {
+        print("\tcorrect");
+    }
+    printf("\t%d %d, %llu bank switches\n", p->registers.b, p->registers.c, (unsigned long long) cart->bank_switches);
+    proc_delete(p);
+    cart_delete(cart);
+
+    print("testing a block that switches its own bank carries on in the new bank, with and without the jit");
+    for (int bank = 1; bank < 4; bank++) {
+        // LD A,2 / LD (2000),A / LD B,bank / JR -2 at 4100 in every bank, only bank 1 runs it from the start
+        const uint8_t switch_code[] = { 0x3E, 0x02, 0xEA, 0x00, 0x20, 0x06, bank, 0x18, 0xFE };
+        memcpy(rom + bank * ROM_BANK_SIZE + 0x100, switch_code, sizeof(switch_code));
+    }
+    uint8_t switched[2] = { 0 };
+    for (int use_jit = 0; use_jit < 2; use_jit++) {
+        cart = cart_create_from_buffer(rom, 4 * ROM_BANK_SIZE);
+        p = proc_create();
+        if (use_jit && proc_enable_jit(p, 1)) p->jit->threshold = 1;
+        cart_load(cart, p);
+        p->pc = 0x4100;
+        proc_run_cycles(p, 200);
+        switched[use_jit] = p->registers.b;
+        proc_delete(p);
+        cart_delete(cart);
+    }
+    if (switched[0] != 2 || switched[1] != 2) {
+        incorrect("\tincorrect");
+    } else {
+        print("\tcorrect");
+    }
+    printf("\tB = %d, %d with the jit\n", switched[0], switched[1]);
+
+    print("testing ROM+RAM carts have their ram mapped without switching it on");
+    uint8_t * plain_rom = calloc(2, ROM_BANK_SIZE);
+    plain_rom[HEADER_TYPE] = 0x09;      // ROM+RAM+BATTERY
+    plain_rom[HEADER_RAM_SIZE] = 0x02;  // 8 KiB
+    cart = cart_create_from_buffer(plain_rom, 2 * ROM_BANK_SIZE);
+    p = proc_create();
+    cart_load(cart, p);
+    write_byte(p, 0xBFFF, 0x5A);
+    if (cart->type != MBC_NONE || read_byte(p, 0xBFFF) != 0x5A || cart->ram[RAM_BANK_SIZE - 1] != 0x5A) {
+        incorrect("\tincorrect");
+    } else {
+        print("\tcorrect");
+    }
+    proc_delete(p);
+    cart_delete(cart);
+    free(plain_rom);
+
+    print("testing roms are mapped from the file rather than copied");
+    FILE * rom_file = fopen("test_rom.gb", "wb");
+    fwrite(rom, ROM_BANK_SIZE, 4, rom_file);
+    fclose(rom_file);
+    cart = cart_create("test_rom.gb");
+    remove("test_rom.gb");
+    p = proc_create();
+    cart_load(cart, p);
+    write_byte(p, 0x2000, 0x03);
+    if (!cart || !cart->rom_mapped || cart->type != MBC_1 || read_byte(p, 0x4001) != 3) {
+        incorrect("\tincorrect");
+    } else {
+        print("\tcorrect");
+    }
+    proc_delete(p);
+    cart_delete(cart);
+
+    print("testing a loaded state carries on exactly like the one it was saved from");
+    const uint8_t state_program[] = {
+        0x3E, 0x0A,         // LD A,0A
+        0xEA, 0x00, 0x00,   // LD (0000),A, ram on
+        0x21, 0x00, 0xA0,   // LD HL,A000
+        0x34,               // INC (HL)
+        0x2C,               // INC L
+        0x7D,               // LD A,L
+        0xE6, 0x03,         // AND 3
+        0x3C,               // INC A
+        0xEA, 0x00, 0x20,   // LD (2000),A, a different bank every time
+        0x18, 0xF5,         // JR -11, back to INC (HL)
+    };
+    cart = cart_create_from_buffer(rom, 4 * ROM_BANK_SIZE);
+    p = proc_create();
+    cart_load(cart, p);
+    load_program(p, state_program, sizeof(state_program));
+    proc_run_cycles(p, 5000);
+    size_t state_capacity = state_bound(p);
+    uint8_t * raw_state = malloc(state_capacity);
+    uint8_t * packed_state = malloc(state_capacity);
+    size_t raw_size = state_save(p, raw_state, state_capacity, 0);
+    size_t packed_size = state_save(p, packed_state, state_capacity, STATE_PACKED);
+    uint64_t saved_cycles = p->cycles;
+
+    proc_run_cycles(p, 20000);
+    uint64_t expected_cycles = p->cycles;
+    uint16_t expected_pc = p->pc;
+    Registers expected_registers = p->registers;
+    uint16_t expected_bank = p->rom_map_bank[1];
+    uint8_t * expected_memory = malloc(MEM_SIZE);
+    memcpy(expected_memory, p->memory, MEM_SIZE);
+    uint8_t * expected_ram = malloc(cart->ram_size);
+    memcpy(expected_ram, cart->ram, cart->ram_size);
+
+    int same = 1;
+    for (int packed = 0; packed < 2; packed++) {
+        int loaded = packed ? state_load(p, packed_state, packed_size) : state_load(p, raw_state, raw_size);
+        same = same && loaded && p->cycles == saved_cycles;
+        proc_run_cycles(p, 20000);
+        same = same && p->cycles == expected_cycles && p->pc == expected_pc
+            && memcmp(&p->registers, &expected_registers, sizeof(Registers)) == 0
+            && memcmp(p->memory, expected_memory, MEM_SIZE) == 0
+            && memcmp(cart->ram, expected_ram, cart->ram_size) == 0
+            && p->rom_map_bank[1] == expected_bank && read_byte(p, 0x4001) == expected_bank;
+    }
+
+    // a bad magic or a state cut short are turned down without touching anything
+    uint64_t cycles_before = p->cycles;
+    int truncated = state_load(p, packed_state, packed_size - 1);
+    raw_state[0] = 'X';
+    int bad_magic = state_load(p, raw_state, raw_size);
+    if (!same || !raw_size || packed_size >= raw_size || truncated || bad_magic || p->cycles != cycles_before) {
+        incorrect("\tincorrect");
+    } else {
+        print("\tcorrect");
+    }
+    printf("\t%zu bytes, %zu packed\n", raw_size, packed_size);
+    free(raw_state);
+    free(packed_state);
+    free(expected_memory);
+    free(expected_ram);
+    proc_delete(p);
+    cart_delete(cart);
+    free(rom);
+
+    print("testing rewind steps back through the snapshots newest first, with and without the worker");
+    const uint8_t sweep_program[] = {
+        0x21, 0x00, 0xC1,   // LD HL,C100
+        0x7E,               // LD A,(HL)
+        0x3C,               // INC A
+        0x22,               // LD (HL+),A
+        0x7C,               // LD A,H
+        0xFE, 0xD0,         // CP D0
+        0x20, 0xF8,         // JR NZ,-8, back to LD A,(HL)
+        0x18, 0xF3,         // JR -13, from the start
+    };
+    int rewound = 1;
+    uint32_t kept[2];
+    for (int threaded = 0; threaded < 2; threaded++) {
+        p = proc_create();
+        load_program(p, sweep_program, sizeof(sweep_program));
+        Rewind rewind;
+        // room for a few of the deltas, so the oldest get dropped before there are 8
+        rewind_init(&rewind, p, 256, 8, 1, threaded);
+
+        uint64_t captured_cycles[16];
+        uint8_t captured_byte[16];
+        int captured = 0;
+        for (int frame = 0; frame < 16; frame++) {
+            proc_run_cycles(p, CYCLES_PER_FRAME);
+            if (rewind_capture(&rewind, p)) {
+                captured_cycles[captured] = p->cycles;
+                captured_byte[captured++] = p->memory[0xC100];
+            }
+            // let the worker keep up, skipping is fine but it'd leave little to check
+            rewind_snapshots(&rewind);
+        }
+
+        kept[threaded] = rewind_snapshots(&rewind);
+        for (uint32_t i = 0; i < kept[threaded]; i++) {
+            int index = captured - 1 - i;
+            rewound = rewound && rewind_step_back(&rewind, p)
+                && p->cycles == captured_cycles[index] && p->memory[0xC100] == captured_byte[index];
+        }
+        // past the oldest it stays there
+        rewound = rewound && rewind_step_back(&rewind, p) && p->cycles == captured_cycles[captured - kept[threaded]];
+        rewound = rewound && kept[threaded] >= 2 && kept[threaded] <= 8 && rewind_used(&rewind) <= 256;
+
+        rewind_free(&rewind);
+        proc_delete(p);
+    }
+    if (!rewound) {
+        incorrect("\tincorrect");
+    } else {
+        print("\tcorrect");
+    }
+    printf("\t%u snapshots kept, %u with the worker\n", kept[0], kept[1]);
+
+    print("testing jit against the interpreter on random blocks");
+    Proc * jit = proc_create();
+    Proc * interpreter = proc_create();
+    if (!proc_enable_jit(jit, 1)) {
+        print("\tskipped, no jit on this host");
+    } else {
+        // compile every block the first time it runs
+        jit->jit->threshold = 1;
+        srand(1);
+
+        int mismatches = 0;
+        for (int i = 0; i < 5000; i++) {
+            uint8_t program[MAX_BLOCK_BYTES];
+            int size = random_block(program);
+            if (!jit_matches_interpreter(jit, interpreter, program, size)) {
+                if (!mismatches++) {
+                    printf("\tfirst mismatch:");
+                    for (int j = 0; j < size; j++) printf(" %02X", program[j]);
+                    printf("\n");
+                }
+            }
+        }
+
+        if (mismatches || jit->jit->native_runs == 0) {
+            incorrect("\tincorrect");
+        } else {
+            print("\tcorrect");
+        }
+        printf("\t%d mismatches, %llu native runs\n", mismatches, (unsigned long long) jit->jit->native_runs);
+    }
+    proc_delete(jit);
+    proc_delete(interpreter);
+
     return RET_STATUS;
 }
\ No newline at end of file
@@ -0,0 +1,152 @@
+// tile.c
+#include <string.h>
+
+#include "tile.h"
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+/* external definition of the inline in tile.h */
+extern inline void tile_mark_dirty(Proc * p, uint16_t address);
+
+/*
+ * http://imrannazar.com/GameBoy-Emulation-in-JavaScript:-Graphics
+ *
+ * Each row of a tile is two bytes, the low and high bit of every pixel with the leftmost
+ * pixel in bit 7. A pixel is set in a plane when its bit is set, so all of them can be done
+ * at once by comparing the row byte copied into every lane against one bit mask per lane.
+ */
+
+#if defined(__AVX2__)
+
+static void decode(const uint8_t * data, uint8_t pixels[TILE_HEIGHT][TILE_WIDTH]) {
+    /* the whole tile in 2 stores of 4 rows each */
+    const __m256i tile = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i *) data));
+    const __m256i bits = _mm256_set1_epi64x(0x0102040810204080);
+
+    for (int half = 0; half < 2; half++) {
+        // byte of each plane for every lane, shuffles only work within 16 byte lanes
+        const int row = half * 8;
+        const __m256i low_bytes = _mm256_setr_epi8(
+                row + 0, row + 0, row + 0, row + 0, row + 0, row + 0, row + 0, row + 0,
+                row + 2, row + 2, row + 2, row + 2, row + 2, row + 2, row + 2, row + 2,
+                row + 4, row + 4, row + 4, row + 4, row + 4, row + 4, row + 4, row + 4,
+                row + 6, row + 6, row + 6, row + 6, row + 6, row + 6, row + 6, row + 6);
+        const __m256i high_bytes = _mm256_add_epi8(low_bytes, _mm256_set1_epi8(1));
+
+        __m256i low = _mm256_and_si256(_mm256_shuffle_epi8(tile, low_bytes), bits);
+        __m256i high = _mm256_and_si256(_mm256_shuffle_epi8(tile, high_bytes), bits);
+
+        // 0xFF where the bit is set, & 1 and & 2 for each plane
+        low = _mm256_and_si256(_mm256_cmpeq_epi8(low, bits), _mm256_set1_epi8(1));
+        high = _mm256_and_si256(_mm256_cmpeq_epi8(high, bits), _mm256_set1_epi8(2));
+
+        _mm256_storeu_si256((__m256i *) pixels[half * 4], _mm256_or_si256(low, high));
+    }
+}
+
+#elif defined(__SSE2__)
+
+static void decode(const uint8_t * data, uint8_t pixels[TILE_HEIGHT][TILE_WIDTH]) {
+    /* 2 rows per store, no byte shuffle in SSE2 so the bytes are spread out by unpacking */
+    const __m128i tile = _mm_loadu_si128((const __m128i *) data);
+    const __m128i bits = _mm_set1_epi64x(0x0102040810204080);
+
+    // planes split out, low bytes are the even ones
+    const __m128i even = _mm_set1_epi16(0x00FF);
+    __m128i lows = _mm_packus_epi16(_mm_and_si128(tile, even), _mm_setzero_si128());
+    __m128i highs = _mm_packus_epi16(_mm_srli_epi16(tile, 8), _mm_setzero_si128());
+
+    // l0 l0 l1 l1 .. then l0 x4 l1 x4 ..
+    lows = _mm_unpacklo_epi8(lows, lows);
+    highs = _mm_unpacklo_epi8(highs, highs);
+    __m128i low_rows[2] = { _mm_unpacklo_epi16(lows, lows), _mm_unpackhi_epi16(lows, lows) };
+    __m128i high_rows[2] = { _mm_unpacklo_epi16(highs, highs), _mm_unpackhi_epi16(highs, highs) };
+
+    for (int i = 0; i < 4; i++) {
+        // l x8 for 2 rows
+        __m128i low = i & 1 ? _mm_unpackhi_epi32(low_rows[i / 2], low_rows[i / 2])
+                            : _mm_unpacklo_epi32(low_rows[i / 2], low_rows[i / 2]);
+        __m128i high = i & 1 ? _mm_unpackhi_epi32(high_rows[i / 2], high_rows[i / 2])
+                             : _mm_unpacklo_epi32(high_rows[i / 2], high_rows[i / 2]);
+
+        low = _mm_and_si128(_mm_cmpeq_epi8(_mm_and_si128(low, bits), bits), _mm_set1_epi8(1));
+        high = _mm_and_si128(_mm_cmpeq_epi8(_mm_and_si128(high, bits), bits), _mm_set1_epi8(2));
+
+        _mm_storeu_si128((__m128i *) pixels[i * 2], _mm_or_si128(low, high));
+    }
+}
+
+#else
+
+// each bit of a byte spread out to its own byte, 0 or 1, leftmost pixel first
+static uint8_t expand[256][TILE_WIDTH];
+static int expand_ready;
+
+static void decode(const uint8_t * data, uint8_t pixels[TILE_HEIGHT][TILE_WIDTH]) {
+    if (!expand_ready) {
+        for (int value = 0; value < 256; value++) {
+            for (int i = 0; i < TILE_WIDTH; i++) {
+                expand[value][i] = (value >> (7 - i)) & 1;
+            }
+        }
+        expand_ready = 1;
+    }
+
+    for (int y = 0; y < TILE_HEIGHT; y++) {
+        // the values are 0 or 1 so shifting the high plane can't carry into the next pixel
+        uint64_t low, high;
+        memcpy(&low, expand[data[2 * y]], 8);
+        memcpy(&high, expand[data[2 * y + 1]], 8);
+
+        uint64_t row = low | (high << 1);
+        memcpy(pixels[y], &row, 8);
+    }
+}
+
+#endif
+
+void tile_decode(Proc * p, int tile) {
+    decode(&p->memory[0x8000 + tile * TILE_BYTES], p->tileset[tile]);
+}
+
+void tiles_decode(Proc * p, int first, int count) {
+    /* a run of tiles, they're next to each other in vram and the tileset */
+    const uint8_t * data = &p->memory[0x8000 + first * TILE_BYTES];
+
+    for (int tile = first; tile < first + count; tile++) {
+        decode(data, p->tileset[tile]);
+        data += TILE_BYTES;
+    }
+}
+
+int tiles_update(Proc * p) {
+    /* decodes every tile written since the last call, returns how many there were */
+    int decoded = 0;
+
+    for (int word = 0; word < TILE_DIRTY_WORDS; word++) {
+        uint64_t dirty = p->tile_dirty[word];
+        p->tile_dirty[word] = 0;
+
+        // games that rewrite all of vram dirty whole words at a time
+        if (dirty == UINT64_MAX) {
+            tiles_decode(p, word * 64, 64);
+            decoded += 64;
+            continue;
+        }
+
+        while (dirty) {
+            int bit = __builtin_ctzll(dirty);
+            dirty &= dirty - 1;
+
+            tile_decode(p, word * 64 + bit);
+            decoded++;
+        }
+    }
+
+    p->stats.tiles_decoded += decoded;
+    return decoded;
+}
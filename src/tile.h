@@ -0,0 +1,30 @@
+#ifndef TILE_H
+#define TILE_H
+
+#include <stdint.h>
+
+#include "proc.h"
+
+/*
+ * Vram writes only mark the tile they hit as dirty, the 2 bit pixels in Proc.tileset are
+ * decoded from the two bitplanes when something is about to draw with them, once per
+ * frame at most however many times the game wrote to the tile. tileset[tile][y][x], each row
+ * is 8 contiguous pixels. Decoding uses AVX2 or SSE2 when the build has them and a lookup
+ * table otherwise.
+ */
+
+// each tile is 8 rows of 2 bytes, one bitplane each
+#define TILE_BYTES 16
+#define TILE_DIRTY_WORDS (NUM_TILES / 64)
+
+void tile_decode(Proc * p, int tile);
+void tiles_decode(Proc * p, int first, int count);
+int  tiles_update(Proc * p);
+
+inline void tile_mark_dirty(Proc * p, uint16_t address) {
+    /* address is in the tile data, 0x8000 -> 0x97FF */
+    int tile = (address - 0x8000) / TILE_BYTES;
+    p->tile_dirty[tile / 64] |= (uint64_t) 1 << (tile % 64);
+}
+
+#endif
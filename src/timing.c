@@ -0,0 +1,87 @@
+// timing.c
+#define _POSIX_C_SOURCE 200112L
+
+#include <errno.h>
+#include <time.h>
+#include "timing.h"
+
+static uint64_t timespec_to_ns(struct timespec * t) {
+    return (uint64_t) t->tv_sec * 1000000000 + t->tv_nsec;
+}
+
+uint64_t timing_now_ns() {
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return timespec_to_ns(&t);
+}
+
+uint64_t timing_thread_cpu_ns() {
+    /* only counts time this thread was actually on a core, so sleeping while pacing is not included */
+    struct timespec t;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &t);
+    return timespec_to_ns(&t);
+}
+
+void timing_sleep_until(uint64_t deadline_ns) {
+    /* sleeps to the deadline itself rather than for however long was left when it was
+     * worked out, and goes back to sleep if a signal wakes it early
+     */
+    struct timespec t;
+    t.tv_sec = deadline_ns / 1000000000;
+    t.tv_nsec = deadline_ns % 1000000000;
+    while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &t, NULL) == EINTR) {}
+}
+
+void timing_pacer_init(Pacer * pacer, unsigned speed) {
+    pacer->speed = speed;
+    pacer->next_frame_ns = timing_now_ns();
+    pacer->waits = 0;
+    pacer->late_ns = 0;
+}
+
+void timing_pacer_wait(Pacer * pacer) {
+    if (!pacer->speed) return;
+
+    uint64_t now = timing_now_ns();
+    pacer->next_frame_ns += FRAME_NS / pacer->speed;
+
+    // after a long stall (the host was busy, a debugger) don't run fast to make the time up
+    if (now > pacer->next_frame_ns + PACER_MAX_BEHIND_NS) {
+        pacer->next_frame_ns = now;
+        return;
+    }
+    if (now >= pacer->next_frame_ns) return;
+
+    timing_sleep_until(pacer->next_frame_ns);
+    pacer->waits++;
+    pacer->late_ns += timing_now_ns() - pacer->next_frame_ns;
+}
+
+void timing_rate_control_init(RateControl * control, uint32_t target) {
+    control->target = target;
+    control->fill = target;
+    control->ratio = 1;
+}
+
+double timing_rate_control_update(RateControl * control, uint32_t fill) {
+    /* the callback takes samples in big chunks so one reading jumps about, the average doesn't */
+    control->fill += (fill - control->fill) * RATE_CONTROL_SMOOTHING;
+
+    // straight line from 1 + max empty to 1 - max at twice the target
+    double off = (control->target - control->fill) / control->target;
+    if (off > 1) off = 1;
+    if (off < -1) off = -1;
+    control->ratio = 1 + off * RATE_CONTROL_MAX_ADJUST;
+    return control->ratio;
+}
+
+double timing_fps(uint64_t frames, uint64_t wall_ns) {
+    if (wall_ns == 0) return 0;
+    return (double) frames * 1e9 / (double) wall_ns;
+}
+
+double timing_emulated_mhz(uint64_t cycles, uint64_t cpu_ns) {
+    if (cpu_ns == 0) return 0;
+    // cycles per nanosecond * 1000 = cycles per microsecond = MHz
+    return (double) cycles * 1000.0 / (double) cpu_ns;
+}
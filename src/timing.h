@@ -0,0 +1,60 @@
+#ifndef TIMING_H
+#define TIMING_H
+
+#include <stdint.h>
+
+#include "proc.h"
+
+// real time length of one frame in nanoseconds (~16.74ms, ~59.7 fps)
+#define FRAME_NS ((uint64_t) CYCLES_PER_FRAME * 1000000000 / CLOCK_SPEED)
+
+// how far behind the pacer can get before it gives up catching up and starts from now
+#define PACER_MAX_BEHIND_NS (4 * FRAME_NS)
+
+// most the rate control changes the sample rate by, half a percent can't be heard
+#define RATE_CONTROL_MAX_ADJUST 0.005
+// how much of each new fill level goes into the average the rate control goes by
+#define RATE_CONTROL_SMOOTHING 0.125
+
+/* paces frames to speed times the real gameboy, speed 0 is uncapped and never waits */
+typedef struct {
+    unsigned speed;
+    uint64_t next_frame_ns;
+
+    // times it slept and how far past the deadline it woke up altogether
+    uint64_t waits;
+    uint64_t late_ns;
+} Pacer;
+
+/*
+ * Dynamic rate control, the pacer runs frames by the host's clock and the sound card plays
+ * samples by its own, the two never quite agree so the audio ring slowly fills up or runs
+ * dry. Instead of waiting on either, the apu makes samples a tiny bit faster when the ring is
+ * under target and slower when it's over (apu_adjust_rate), which keeps it around target.
+ */
+typedef struct {
+    uint32_t target;
+    // fill level averaged over the last few frames, and the ratio it came to
+    double fill;
+    double ratio;
+} RateControl;
+
+uint64_t timing_now_ns();
+uint64_t timing_thread_cpu_ns();
+void     timing_sleep_until(uint64_t deadline_ns);
+
+void     timing_pacer_init(Pacer * pacer, unsigned speed);
+// waits until the next frame is due
+void     timing_pacer_wait(Pacer * pacer);
+
+void     timing_rate_control_init(RateControl * control, uint32_t target);
+// the ratio to make samples at given the samples waiting in the ring now
+double   timing_rate_control_update(RateControl * control, uint32_t fill);
+
+// frames per second given frames run over the wall clock time it took
+double   timing_fps(uint64_t frames, uint64_t wall_ns);
+
+// emulated MHz per host core given cycles run over the host cpu time it took
+double   timing_emulated_mhz(uint64_t cycles, uint64_t cpu_ns);
+
+#endif
@@ -1,25 +1,36 @@
 #include "video.h"
+#include "io.h"
+#include "timing.h"
 
 Screen * screen_create() {
     Screen * s = calloc(1, sizeof(Screen));
+    s->colors = COLORS_GREY;
 
     if (SDL_Init(SDL_INIT_EVERYTHING) < 0) {
         fprintf(stderr, "error in starting sdl");
         exit(1);
     }
     
-    SDL_CreateWindowAndRenderer(SCREEN_W, SCREEN_H, 0, &(s->screen), &(s->renderer));
+    SDL_CreateWindowAndRenderer(SCREEN_WIDTH * SCREEN_SCALE, SCREEN_HEIGHT * SCREEN_SCALE, 0, &(s->screen), &(s->renderer));
     SDL_SetWindowTitle(s->screen, "ChadBoy");
 
     if (!s->screen) {
         fprintf(stderr, "sdl could not create screen");
         exit(1);
     }
+
+    // the frame is copied into this each time and scaled up to the window by the renderer
+    s->texture = SDL_CreateTexture(s->renderer, SDL_PIXELFORMAT_ARGB8888, SDL_TEXTUREACCESS_STREAMING,
+            SCREEN_WIDTH, SCREEN_HEIGHT);
+    if (!s->texture) {
+        fprintf(stderr, "sdl could not create texture");
+        exit(1);
+    }
     return s;
 }
 
 pthread_t dispatch_thread(Screen * s, Proc * p) {
-    // Creates the thread to run the video process, pthread_join should be called in the caller to this
+    // Creates the thread to run the video process, screen_stop ends it and joins it
     pthread_t thread_id;
     VideoThreadArg * arg = calloc(1, sizeof(VideoThreadArg));
     arg->s = s;
@@ -32,36 +43,96 @@ pthread_t dispatch_thread(Screen * s, Proc * p) {
 void * video_thread(void * varg) {
     /* Video thread that handles the while loop for the video displaying */
     VideoThreadArg * arg = (VideoThreadArg *) varg;
+    uint64_t next_frame = timing_now_ns();
+    const uint8_t (*shown)[SCREEN_WIDTH] = NULL;
 
-    while (1) {
-        // TODO do the video updating in here
-        // TODO make sure if we are accessing data in here from proc, it is going to not have 
-        // any concurrency issues
+    while (!__atomic_load_n(&arg->s->quit, __ATOMIC_ACQUIRE)) {
+        /* shows the newest frame the ppu finished once every frame time. The triple buffer
+         * means the cpu thread never waits on this, if it's run ahead frames get dropped and if
+         * it's behind the last one is shown again, Proc.frames counts both
+         */
         // NOTE - EVENT POLLING CANNOT HAPPEN IN A THREAD ON OSX
+        const uint8_t (*frame)[SCREEN_WIDTH] = triple_buffer_acquire(&arg->p->frames);
+
+        // a new frame is always in a different buffer, the texture still has the old one
+        if (frame != shown) {
+            render(arg->s, frame);
+            shown = frame;
+        } else {
+            screen_present(arg->s);
+        }
+
+        next_frame += FRAME_NS;
+        timing_sleep_until(next_frame);
     }
+
+    free(arg);
+    return NULL;
 }
 
-void render(Screen * s, Proc * p) {
-    uint32_t pixels[SCREEN_W * SCREEN_H] = {0};
+void screen_stop(Screen * s, pthread_t thread) {
+    __atomic_store_n(&s->quit, 1, __ATOMIC_RELEASE);
+    pthread_join(thread, NULL);
+}
 
-    // TODO figure out how to decide what to render before updating screen 
+static uint8_t key_button(SDL_Keycode key) {
+    switch (key) {
+    case SDLK_RIGHT:     return BUTTON_RIGHT;
+    case SDLK_LEFT:      return BUTTON_LEFT;
+    case SDLK_UP:        return BUTTON_UP;
+    case SDLK_DOWN:      return BUTTON_DOWN;
+    case SDLK_x:         return BUTTON_A;
+    case SDLK_z:         return BUTTON_B;
+    case SDLK_BACKSPACE: return BUTTON_SELECT;
+    case SDLK_RETURN:    return BUTTON_START;
+    default:             return 0;
+    }
+}
 
-    SDL_UpdateTexture(s->texture, NULL, pixels, SCREEN_W * sizeof(Uint32));
-    SDL_RenderClear(s->renderer);
-    SDL_RenderCopy(s->renderer, s->texture, NULL, NULL);
-    SDL_RenderPresent(s->renderer);
+int screen_poll(Screen * s, Proc * p) {
+    int flags = 0;
+    uint8_t buttons = s->buttons;
+
+    while (SDL_PollEvent(&s->event)) {
+        switch (s->event.type) {
+        case SDL_QUIT:
+            flags |= SCREEN_QUIT;
+            break;
+        case SDL_KEYDOWN:
+            // holding it down doesn't keep changing the speed
+            if (s->event.key.keysym.sym == SPEED_KEY && !s->event.key.repeat) flags |= SCREEN_SPEED;
+            buttons |= key_button(s->event.key.keysym.sym);
+            break;
+        case SDL_KEYUP:
+            buttons &= ~key_button(s->event.key.keysym.sym);
+            break;
+        }
+    }
+
+    // only when something changed, each one is an event on the scheduler
+    if (buttons != s->buttons) {
+        s->buttons = buttons;
+        io_set_buttons(p, buttons);
+    }
+    return flags;
 }
 
-uint32_t get_pixel_value(uint8_t value) {
-    /* Switches the 2 bit color value from memory to a hex value for SDL to render */
-    switch (value) {
-        case 0: 
-            return 0xFFFFFF;
-        case 1:
-            return 0xC0C0C0;
-        case 2:
-            return 0x606060;
-        default:
-            return 0;
+void render(Screen * s, const uint8_t (*frame)[SCREEN_WIDTH]) {
+    /* converted a line at a time straight into the texture */
+    void * pixels;
+    int pitch;
+    if (SDL_LockTexture(s->texture, NULL, &pixels, &pitch) != 0) return;
+
+    for (int y = 0; y < SCREEN_HEIGHT; y++) {
+        palette_convert_line(&s->colors, frame[y], (uint32_t *) ((uint8_t *) pixels + y * pitch), SCREEN_WIDTH);
     }
+
+    SDL_UnlockTexture(s->texture);
+    screen_present(s);
+}
+
+void screen_present(Screen * s) {
+    SDL_RenderClear(s->renderer);
+    SDL_RenderCopy(s->renderer, s->texture, NULL, NULL);
+    SDL_RenderPresent(s->renderer);
 }
@@ -5,20 +5,29 @@
 #include "pthread.h"
 
 #include "proc.h"
+#include "ppu.h"
+#include "palette.h"
 
-#define SCREEN_H 160
-#define SCREEN_W 144
-#define MAX_SPRITES 40
+// the window is the screen scaled up by this much
+#define SCREEN_SCALE 3
 
-// The gameboy screen buffer is larger than the visible screen
-#define BACKGROUND_H 256
-#define BACKGROUND_W 256
+// screen_poll flags, the window was closed / the speed key was pressed
+#define SCREEN_QUIT  0x1
+#define SCREEN_SPEED 0x2
+// cycles through the speeds, the buttons are the arrows, X, Z, backspace and return
+#define SPEED_KEY SDLK_TAB
 
 typedef struct {
     SDL_Window * screen;
     SDL_Renderer * renderer;
     SDL_Texture * texture;
     SDL_Event event;
+    // what the shades look like, grey unless it's changed after screen_create
+    ColorScheme colors;
+    // held down, as io_set_buttons takes them
+    uint8_t buttons;
+    // set by screen_stop, the video thread finishes the frame it's on and returns
+    int quit;
 } Screen;
 
 typedef struct {
@@ -29,13 +38,20 @@ typedef struct {
 Screen * screen_create();
 
 pthread_t dispatch_thread(Screen * s, Proc * p);
+// stops the video thread and waits for it, after this it doesn't touch the Proc
+void      screen_stop(Screen * s, pthread_t thread);
 
 void * video_thread(void *);
 
-void render(Screen * s, Proc * p);
-
-// Transforms the 2 bit value that is held in memory to the emulated pixel color
-uint32_t get_pixel_value(uint8_t value);
+/* takes the events since the last call, the buttons go straight to p so it has to be the cpu
+ * thread calling it (and the main thread, SDL only gives events to that one on OSX). Returns
+ * SCREEN_QUIT / SCREEN_SPEED for the rest
+ */
+int  screen_poll(Screen * s, Proc * p);
 
+// converts a frame of shades from Proc.frames and shows it
+void render(Screen * s, const uint8_t (*frame)[SCREEN_WIDTH]);
+// shows whatever the last frame rendered was again
+void screen_present(Screen * s);
 
 #endif